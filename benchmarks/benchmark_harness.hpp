@@ -0,0 +1,68 @@
+#pragma once
+
+#include "util/log.hpp"
+#include "util/misc.hpp"
+#include "util/thread_pool.hpp"
+#include <chrono>
+#include <cstddef>
+#include <type_traits>
+
+namespace bench
+{
+    /// Installs the global logger and thread pool for as long as it lives
+    class BenchmarkEnvironment
+    {
+    public:
+        BenchmarkEnvironment()
+        {
+            util::installGlobalLoggerRacy();
+            util::installGlobalThreadPoolRacy();
+        }
+        ~BenchmarkEnvironment()
+        {
+            util::removeGlobalThreadPoolRacy();
+            util::removeGlobalLoggerRacy();
+        }
+
+        BenchmarkEnvironment(const BenchmarkEnvironment&)             = delete;
+        BenchmarkEnvironment(BenchmarkEnvironment&&)                  = delete;
+        BenchmarkEnvironment& operator= (const BenchmarkEnvironment&) = delete;
+        BenchmarkEnvironment& operator= (BenchmarkEnvironment&&)      = delete;
+    };
+
+    struct Measurement
+    {
+        std::chrono::nanoseconds time_per_call;
+        std::size_t              calls;
+        // Sum of everything func returned, log it so that none of the work can be optimized out
+        std::size_t              checksum;
+    };
+
+    /// Calls func once to warm up and then until at least minDuration has passed
+    template<class Fn>
+    Measurement measure(
+        const Fn& func, std::chrono::milliseconds minDuration = std::chrono::milliseconds {500})
+        requires std::is_invocable_r_v<std::size_t, const Fn&>
+    {
+        std::size_t checksum = func();
+        std::size_t calls    = 0;
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration         elapsed {};
+
+        do
+        {
+            checksum += func();
+            calls += 1;
+
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        while (elapsed < minDuration);
+
+        return Measurement {
+            .time_per_call {std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                            / static_cast<i64>(calls)},
+            .calls {calls},
+            .checksum {checksum}};
+    }
+} // namespace bench
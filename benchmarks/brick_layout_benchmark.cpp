@@ -0,0 +1,279 @@
+#include "benchmark_harness.hpp"
+#include "shaders/include/common.glsl"
+#include "util/log.hpp"
+#include "voxel/structures.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+#include <random>
+#include <vector>
+
+// Walks a chunk of hilly terrain with caves the ways that care about the brick layout: halving it
+// to the next lod, looking at every voxel's 6 neighbours like the mesher and casting rays through
+// it voxel by voxel. The layout is chosen at compile time, so this is built once for each and the
+// two executables are compared.
+
+namespace
+{
+    using voxel::BrickCoordinate;
+    using voxel::BrickLocalPosition;
+    using voxel::ChunkBrickMap;
+    using voxel::ChunkLocalPosition;
+    using voxel::MaterialBrick;
+    using voxel::Voxel;
+
+    constexpr i32         ChunkEdge    = voxel::VoxelsPerChunkEdge;
+    constexpr std::size_t NumberOfRays = 4096;
+
+    /// Bricks are allocated in the order the brick map stores them, like the mesher does
+    struct TerrainChunk
+    {
+        ChunkBrickMap              brick_map;
+        std::vector<MaterialBrick> bricks;
+    };
+
+    bool isTerrainSolid(i32 x, i32 y, i32 z)
+    {
+        const f32 height = 28.0f + (10.0f * std::sin(static_cast<f32>(x) / 9.0f))
+                         + (8.0f * std::cos(static_cast<f32>(z) / 7.0f));
+        const f32 cave = std::sin(static_cast<f32>(x) / 5.0f) * std::sin(static_cast<f32>(y) / 4.0f)
+                       * std::sin(static_cast<f32>(z) / 6.0f);
+
+        return static_cast<f32>(y) < height && cave < 0.35f;
+    }
+
+    TerrainChunk generateTerrainChunk()
+    {
+        TerrainChunk chunk {};
+
+        for (std::size_t i = 0; i < GpuBrickLayoutSize; ++i)
+        {
+            const BrickCoordinate brick {voxel::getBrickLayoutPosition(i)};
+            MaterialBrick         materials {};
+            bool                  hasAnySolid = false;
+
+            materials.modifyOverVoxels(
+                [&](BrickLocalPosition p, Voxel& v)
+                {
+                    const ChunkLocalPosition c = voxel::assembleChunkLocalPosition(brick, p);
+                    const bool               isSolid = isTerrainSolid(c.x, c.y, c.z);
+
+                    v = isSolid ? Voxel::Granite : Voxel::NullAirEmpty;
+                    hasAnySolid |= isSolid;
+                });
+
+            if (hasAnySolid)
+            {
+                chunk.brick_map.setOffset(brick, static_cast<u16>(chunk.bricks.size()));
+                chunk.bricks.push_back(materials);
+            }
+        }
+
+        return chunk;
+    }
+
+    Voxel readVoxel(const TerrainChunk& chunk, i32 x, i32 y, i32 z)
+    {
+        if (x < 0 || y < 0 || z < 0 || x >= ChunkEdge || y >= ChunkEdge || z >= ChunkEdge)
+        {
+            return Voxel::NullAirEmpty;
+        }
+
+        const auto [brick, position] = voxel::splitChunkLocalPosition(
+            ChunkLocalPosition {glm::u8vec3 {glm::ivec3 {x, y, z}}});
+        const u16 offset = chunk.brick_map.getOffset(brick);
+
+        return offset == ChunkBrickMap::NullOffset ? Voxel::NullAirEmpty
+                                                   : chunk.bricks[offset].read(position);
+    }
+
+    // A coarse voxel is solid when any of the 8 below it are
+    std::size_t downsample(const TerrainChunk& chunk)
+    {
+        std::size_t numberOfSolidVoxels = 0;
+
+        for (i32 x = 0; x < ChunkEdge / 2; ++x)
+        {
+            for (i32 y = 0; y < ChunkEdge / 2; ++y)
+            {
+                for (i32 z = 0; z < ChunkEdge / 2; ++z)
+                {
+                    bool isSolid = false;
+
+                    for (i32 child = 0; child < 8; ++child)
+                    {
+                        isSolid |= readVoxel(
+                                       chunk,
+                                       (2 * x) + (child & 1),
+                                       (2 * y) + ((child >> 1) & 1),
+                                       (2 * z) + ((child >> 2) & 1))
+                                != Voxel::NullAirEmpty;
+                    }
+
+                    numberOfSolidVoxels += isSolid ? 1 : 0;
+                }
+            }
+        }
+
+        return numberOfSolidVoxels;
+    }
+
+    // Visits voxels in the order they are stored, as the mesher does
+    std::size_t countVisibleFaces(const TerrainChunk& chunk)
+    {
+        std::size_t numberOfFaces = 0;
+
+        chunk.brick_map.iterateOverBricks(
+            [&](BrickCoordinate brick, u16 offset)
+            {
+                if (offset == ChunkBrickMap::NullOffset)
+                {
+                    return;
+                }
+
+                chunk.bricks[offset].iterateOverVoxels(
+                    [&](BrickLocalPosition p, Voxel v)
+                    {
+                        if (v == Voxel::NullAirEmpty)
+                        {
+                            return;
+                        }
+
+                        const ChunkLocalPosition c = voxel::assembleChunkLocalPosition(brick, p);
+                        const i32                x = c.x;
+                        const i32                y = c.y;
+                        const i32                z = c.z;
+
+                        for (const glm::ivec3 n :
+                             {glm::ivec3 {x - 1, y, z},
+                              glm::ivec3 {x + 1, y, z},
+                              glm::ivec3 {x, y - 1, z},
+                              glm::ivec3 {x, y + 1, z},
+                              glm::ivec3 {x, y, z - 1},
+                              glm::ivec3 {x, y, z + 1}})
+                        {
+                            numberOfFaces +=
+                                readVoxel(chunk, n.x, n.y, n.z) == Voxel::NullAirEmpty ? 1 : 0;
+                        }
+                    });
+            });
+
+        return numberOfFaces;
+    }
+
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+    };
+
+    // From just under the top of the chunk, downwards at every angle steep enough to find ground
+    std::vector<Ray> generateRays()
+    {
+        std::mt19937                        generator {7};
+        std::uniform_real_distribution<f32> across {0.0f, static_cast<f32>(ChunkEdge)};
+        std::uniform_real_distribution<f32> sideways {0.05f, 1.0f};
+        std::uniform_real_distribution<f32> down {-1.0f, -0.2f};
+        std::bernoulli_distribution         flip {};
+
+        std::vector<Ray> rays {};
+
+        for (std::size_t i = 0; i < NumberOfRays; ++i)
+        {
+            const f32 dx = flip(generator) ? sideways(generator) : -sideways(generator);
+            const f32 dz = flip(generator) ? sideways(generator) : -sideways(generator);
+
+            const f32 x = across(generator);
+            const f32 z = across(generator);
+
+            rays.push_back(Ray {
+                glm::vec3 {x, static_cast<f32>(ChunkEdge) - 0.5f, z},
+                glm::vec3 {dx, down(generator), dz}});
+        }
+
+        return rays;
+    }
+
+    /// Steps voxel by voxel until something solid or the edge of the chunk, returns the number of
+    /// voxels visited
+    std::size_t castRay(const TerrainChunk& chunk, const Ray& ray)
+    {
+        glm::ivec3       position {glm::floor(ray.origin)};
+        const glm::ivec3 step {glm::sign(ray.direction)};
+        const glm::vec3  tDelta = glm::abs(1.0f / ray.direction);
+        glm::vec3        tMax =
+            (glm::vec3 {position} + glm::max(glm::vec3 {step}, 0.0f) - ray.origin) / ray.direction;
+
+        std::size_t numberOfSteps = 0;
+
+        while (position.x >= 0 && position.y >= 0 && position.z >= 0 && position.x < ChunkEdge
+               && position.y < ChunkEdge && position.z < ChunkEdge)
+        {
+            numberOfSteps += 1;
+
+            if (readVoxel(chunk, position.x, position.y, position.z) != Voxel::NullAirEmpty)
+            {
+                break;
+            }
+
+            const i32 axis =
+                tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+
+            position[axis] += step[axis];
+            tMax[axis] += tDelta[axis];
+        }
+
+        return numberOfSteps;
+    }
+} // namespace
+
+int main()
+{
+    const bench::BenchmarkEnvironment environment {};
+
+    const char* const layoutName = LAVENDER_MORTON_BRICK_LAYOUT ? "Z-order" : "[x][y][z]";
+
+    const TerrainChunk     chunk = generateTerrainChunk();
+    const std::vector<Ray> rays  = generateRays();
+
+    const bench::Measurement downsampled = bench::measure(
+        [&]
+        {
+            return downsample(chunk);
+        });
+    const bench::Measurement faces = bench::measure(
+        [&]
+        {
+            return countVisibleFaces(chunk);
+        });
+    const bench::Measurement rayCast = bench::measure(
+        [&]
+        {
+            std::size_t numberOfSteps = 0;
+
+            for (const Ray& r : rays)
+            {
+                numberOfSteps += castRay(chunk, r);
+            }
+
+            return numberOfSteps;
+        });
+
+    util::logLog(
+        "{} | {} bricks | downsample {}us | visible faces {}us | {} rays {}us",
+        layoutName,
+        chunk.bricks.size(),
+        downsampled.time_per_call.count() / 1000,
+        faces.time_per_call.count() / 1000,
+        rays.size(),
+        rayCast.time_per_call.count() / 1000);
+    util::logLog(
+        "{} | {} solid coarse voxels | {} visible faces | {} voxels stepped over per pass",
+        layoutName,
+        downsampled.checksum / (downsampled.calls + 1),
+        faces.checksum / (faces.calls + 1),
+        rayCast.checksum / (rayCast.calls + 1));
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include "benchmark_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/structures.hpp"
+#include "world/column_cache.hpp"
+#include "world/generator.hpp"
+#include <cstdlib>
+#include <glm/vec3.hpp>
+
+// Generates vertical stacks of chunks from a fresh generator, so every footprint starts out
+// uncached, and counts how much 2d noise each chunk cost. Without the column cache every chunk
+// evaluates the three noise grids of its own apron.
+
+namespace
+{
+    constexpr i32         FootprintsPerAxis = 16;
+    constexpr i32         LowestLayer       = -20;
+    constexpr i32         HighestLayer      = 20;
+    constexpr i32         ChunkWidth        = 64;
+    constexpr u64         Seed              = 3849234;
+    constexpr std::size_t NumberOfChunks =
+        FootprintsPerAxis * FootprintsPerAxis * (HighestLayer - LowestLayer + 1);
+    constexpr u64         UnsharedEvaluationsPerChunk =
+        3 * world::ChunkColumns::ApronWidth * world::ChunkColumns::ApronWidth;
+
+    /// Returns the number of voxels generated
+    std::size_t generateStacks(const world::WorldGenerator& generator)
+    {
+        std::size_t numberOfUpdates = 0;
+
+        for (i32 x = 0; x < FootprintsPerAxis; ++x)
+        {
+            for (i32 z = 0; z < FootprintsPerAxis; ++z)
+            {
+                for (i32 layer = LowestLayer; layer <= HighestLayer; ++layer)
+                {
+                    numberOfUpdates +=
+                        generator
+                            .generateChunk(
+                                voxel::ChunkLocation {glm::ivec3 {x, layer, z} * ChunkWidth, 0})
+                            .updates.size();
+                }
+            }
+        }
+
+        return numberOfUpdates;
+    }
+} // namespace
+
+int main()
+{
+    const bench::BenchmarkEnvironment environment {};
+
+    const bench::Measurement measurement = bench::measure(
+        []
+        {
+            const world::WorldGenerator generator {Seed};
+
+            return generateStacks(generator);
+        });
+
+    const world::WorldGenerator generator {Seed};
+    const std::size_t           numberOfUpdates = generateStacks(generator);
+    const u64 evaluationsPerChunk = generator.getNumberOfNoiseEvaluations() / NumberOfChunks;
+
+    util::logLog(
+        "{} chunks | {} chunks/s | {} noise evaluations per chunk, {} unshared ({:.1f}x fewer) | "
+        "{} voxels",
+        NumberOfChunks,
+        static_cast<i64>(
+            static_cast<f64>(NumberOfChunks) * 1e9
+            / static_cast<f64>(measurement.time_per_call.count())),
+        evaluationsPerChunk,
+        UnsharedEvaluationsPerChunk,
+        static_cast<f64>(UnsharedEvaluationsPerChunk) / static_cast<f64>(evaluationsPerChunk),
+        numberOfUpdates);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,123 @@
+#include "benchmark_harness.hpp"
+#include "util/log.hpp"
+#include "util/thread_pool.hpp"
+#include "voxel/chunk_bounds_table.hpp"
+#include "voxel/structures.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+#include <glm/mat4x4.hpp>
+#include <vector>
+
+// Culls a world of chunks from a camera orbiting its center, once on the calling thread and once
+// split across the thread pool the same way ChunkRenderManager prepares each frame
+
+namespace
+{
+    constexpr i32 ChunksPerAxis   = 64;
+    constexpr i32 ChunkLayers     = 16;
+    constexpr u32 FramesPerOrbit  = 64;
+    constexpr f32 OrbitRadius     = 512.0f;
+    constexpr f32 CameraHeight    = 256.0f;
+    constexpr f32 FieldOfViewRads = 1.4f;
+
+    glm::vec3 getCameraPosition(u32 frame)
+    {
+        const f32 angle =
+            (static_cast<f32>(frame) / static_cast<f32>(FramesPerOrbit)) * 2.0f * 3.14159265f;
+
+        return glm::vec3 {
+            OrbitRadius * std::cos(angle), CameraHeight, OrbitRadius * std::sin(angle)};
+    }
+
+    std::array<glm::vec4, 6> getFrustumPlanes(u32 frame)
+    {
+        const glm::mat4 m =
+            glm::perspective(FieldOfViewRads, 16.0f / 9.0f, 0.1f, 100000.0f)
+            * glm::lookAt(getCameraPosition(frame), glm::vec3 {0.0f}, glm::vec3 {0.0f, 1.0f, 0.0f});
+
+        const glm::vec4 row0 {m[0][0], m[1][0], m[2][0], m[3][0]};
+        const glm::vec4 row1 {m[0][1], m[1][1], m[2][1], m[3][1]};
+        const glm::vec4 row2 {m[0][2], m[1][2], m[2][2], m[3][2]};
+        const glm::vec4 row3 {m[0][3], m[1][3], m[2][3], m[3][3]};
+
+        std::array<glm::vec4, 6> planes {
+            row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2};
+
+        for (glm::vec4& p : planes)
+        {
+            p /= glm::length(glm::vec3 {p});
+        }
+
+        return planes;
+    }
+} // namespace
+
+int main()
+{
+    const bench::BenchmarkEnvironment environment {};
+
+    voxel::ChunkBoundsTable table {};
+    u32                     chunkId = 0;
+
+    for (i32 x = -ChunksPerAxis / 2; x < ChunksPerAxis / 2; ++x)
+    {
+        for (i32 y = -ChunkLayers / 2; y < ChunkLayers / 2; ++y)
+        {
+            for (i32 z = -ChunksPerAxis / 2; z < ChunksPerAxis / 2; ++z)
+            {
+                table.setBounds(chunkId, voxel::ChunkLocation {glm::ivec3 {x, y, z} * 64, 0});
+                table.setDrawRanges(chunkId, {0, 1, 2, 3, 4, 5}, {1, 1, 1, 1, 1, 1});
+
+                chunkId += 1;
+            }
+        }
+    }
+
+    std::vector<u8> visibleDirections {};
+    u32             frame = 0;
+
+    auto countVisible = [&]
+    {
+        return static_cast<std::size_t>(std::count_if(
+            visibleDirections.cbegin(), visibleDirections.cend(), [](u8 d) { return d != 0; }));
+    };
+
+    const bench::Measurement serial = bench::measure(
+        [&]
+        {
+            frame += 1;
+            table.cull(getFrustumPlanes(frame), getCameraPosition(frame), visibleDirections);
+
+            return countVisible();
+        });
+
+    frame = 0;
+
+    const bench::Measurement parallel = bench::measure(
+        [&]
+        {
+            frame += 1;
+            table.cullParallel(
+                getFrustumPlanes(frame), getCameraPosition(frame), visibleDirections);
+
+            return countVisible();
+        });
+
+    util::logLog(
+        "{} chunks | serial {}us/frame | parallel on {} threads {}us/frame | {:.2f}x | {} {}",
+        chunkId,
+        serial.time_per_call.count() / 1000,
+        util::getGlobalThreadPool()->getNumberOfWorkers() + 1,
+        parallel.time_per_call.count() / 1000,
+        static_cast<f64>(serial.time_per_call.count())
+            / static_cast<f64>(parallel.time_per_call.count()),
+        serial.checksum,
+        parallel.checksum);
+
+    return EXIT_SUCCESS;
+}
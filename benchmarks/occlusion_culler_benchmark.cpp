@@ -0,0 +1,206 @@
+#include "benchmark_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/brick_kernels.hpp"
+#include "voxel/occlusion_culler.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/geometric.hpp>
+#include <glm/mat4x4.hpp>
+#include <utility>
+#include <vector>
+
+// Flies a camera low over rolling terrain made of chunks and culls every chunk each frame the way
+// ChunkRenderManager does, rasterizing the nearest solid chunks and testing every chunk against
+// them, once with each instruction set this cpu supports
+
+namespace
+{
+    using voxel::kernels::InstructionSet;
+
+    constexpr i32 ChunksPerAxis   = 48;
+    constexpr i32 ChunkLayers     = 6;
+    constexpr f32 ChunkWidth      = 64.0f;
+    constexpr u32 FramesPerPath   = 256;
+    constexpr f32 FieldOfViewRads = 1.4f;
+
+    constexpr std::array<InstructionSet, 4> AllInstructionSets {
+        InstructionSet::Scalar, InstructionSet::Avx2, InstructionSet::Avx512, InstructionSet::Neon};
+
+    struct Chunk
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+        bool      is_solid;
+    };
+
+    f32 getTerrainHeight(f32 x, f32 z)
+    {
+        return 160.0f + (96.0f * std::sin(x / 300.0f)) + (64.0f * std::cos(z / 220.0f));
+    }
+
+    std::vector<Chunk> generateChunks()
+    {
+        std::vector<Chunk> chunks {};
+
+        for (i32 x = -ChunksPerAxis / 2; x < ChunksPerAxis / 2; ++x)
+        {
+            for (i32 y = 0; y < ChunkLayers; ++y)
+            {
+                for (i32 z = -ChunksPerAxis / 2; z < ChunksPerAxis / 2; ++z)
+                {
+                    const glm::vec3 min =
+                        glm::vec3 {static_cast<f32>(x), static_cast<f32>(y), static_cast<f32>(z)}
+                        * ChunkWidth;
+                    const glm::vec3 max = min + ChunkWidth;
+
+                    // Solid when the lowest point of the terrain above it is over its top
+                    const f32 lowestGround = std::min(
+                        {getTerrainHeight(min.x, min.z),
+                         getTerrainHeight(max.x, min.z),
+                         getTerrainHeight(min.x, max.z),
+                         getTerrainHeight(max.x, max.z)});
+
+                    chunks.push_back(Chunk {min, max, lowestGround >= max.y});
+                }
+            }
+        }
+
+        return chunks;
+    }
+
+    // A lap around the middle of the terrain, just above the ground and looking along the path
+    std::pair<glm::vec3, glm::mat4> getCamera(u32 frame)
+    {
+        const auto getPosition = [](u32 f)
+        {
+            const f32 angle =
+                (static_cast<f32>(f % FramesPerPath) / static_cast<f32>(FramesPerPath)) * 2.0f
+                * 3.14159265f;
+            const f32 x = 900.0f * std::cos(angle);
+            const f32 z = 700.0f * std::sin(angle);
+
+            return glm::vec3 {x, getTerrainHeight(x, z) + 24.0f, z};
+        };
+
+        const glm::vec3 position = getPosition(frame);
+        glm::vec3       target   = getPosition(frame + 1);
+        target.y                 = position.y;
+
+        return {
+            position,
+            glm::perspective(FieldOfViewRads, 16.0f / 9.0f, 0.1f, 100000.0f)
+                * glm::lookAt(position, target, glm::vec3 {0.0f, 1.0f, 0.0f})};
+    }
+
+    std::size_t cullFrame(
+        voxel::OcclusionCuller&           culler,
+        const std::vector<Chunk>&         chunks,
+        std::vector<std::pair<f32, u32>>& occludingChunks,
+        u32                               frame)
+    {
+        const auto [position, viewProjection] = getCamera(frame);
+
+        occludingChunks.clear();
+
+        for (u32 chunkId = 0; chunkId < chunks.size(); ++chunkId)
+        {
+            if (chunks[chunkId].is_solid)
+            {
+                const glm::vec3 offset =
+                    ((chunks[chunkId].min + chunks[chunkId].max) * 0.5f) - position;
+
+                occludingChunks.push_back({glm::dot(offset, offset), chunkId});
+            }
+        }
+
+        const std::size_t numberOfOccludingChunks =
+            std::min(occludingChunks.size(), voxel::OcclusionCuller::MaxOccluders);
+
+        std::ranges::partial_sort(
+            occludingChunks,
+            occludingChunks.begin() + static_cast<std::ptrdiff_t>(numberOfOccludingChunks));
+
+        culler.clear(viewProjection);
+
+        for (std::size_t i = 0; i < numberOfOccludingChunks; ++i)
+        {
+            const Chunk& c = chunks[occludingChunks[i].second];
+
+            culler.rasterizeOccluder(c.min, c.max);
+        }
+
+        culler.buildHierarchy();
+
+        std::size_t numberOfChunksOccluded = 0;
+
+        for (const Chunk& c : chunks)
+        {
+            numberOfChunksOccluded += culler.isOccluded(c.min, c.max) ? 1 : 0;
+        }
+
+        return numberOfChunksOccluded;
+    }
+} // namespace
+
+int main()
+{
+    const bench::BenchmarkEnvironment environment {};
+
+    const std::vector<Chunk>         chunks = generateChunks();
+    std::vector<std::pair<f32, u32>> occludingChunks {};
+    voxel::OcclusionCuller           culler {};
+
+    const InstructionSet original         = voxel::kernels::getInstructionSet();
+    i64                  scalarNsPerFrame = 0;
+
+    for (const InstructionSet i : AllInstructionSets)
+    {
+        if (!voxel::kernels::isInstructionSetSupported(i))
+        {
+            continue;
+        }
+
+        voxel::kernels::setInstructionSet(i);
+
+        u32 frame = 0;
+
+        // Whole laps, so that every instruction set culls the same frames
+        const bench::Measurement measurement = bench::measure(
+            [&]
+            {
+                std::size_t numberOfChunksOccluded = 0;
+
+                for (u32 f = 0; f < FramesPerPath; ++f)
+                {
+                    numberOfChunksOccluded += cullFrame(culler, chunks, occludingChunks, frame);
+                    frame += 1;
+                }
+
+                return numberOfChunksOccluded;
+            });
+
+        const i64 nsPerFrame =
+            measurement.time_per_call.count() / static_cast<i64>(FramesPerPath);
+
+        if (i == InstructionSet::Scalar)
+        {
+            scalarNsPerFrame = nsPerFrame;
+        }
+
+        util::logLog(
+            "{} | {} chunks | {}us/frame | {:.2f}x scalar | {} chunks occluded per lap",
+            voxel::kernels::getInstructionSetName(i),
+            chunks.size(),
+            nsPerFrame / 1000,
+            static_cast<f64>(scalarNsPerFrame) / static_cast<f64>(nsPerFrame),
+            measurement.checksum / (measurement.calls + 1));
+    }
+
+    voxel::kernels::setInstructionSet(original);
+
+    return EXIT_SUCCESS;
+}
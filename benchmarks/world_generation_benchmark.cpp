@@ -0,0 +1,85 @@
+#include "benchmark_harness.hpp"
+#include "util/log.hpp"
+#include "util/misc.hpp"
+#include "voxel/structures.hpp"
+#include "world/generator.hpp"
+#include <array>
+#include <cstdlib>
+#include <glm/vec3.hpp>
+
+// Generates a square of chunks at each of a sweep of heights, from far below the lowest valleys
+// to far above the highest mountains, on the calling thread. The columns under the square are
+// cached by the warm up, so this times what each height costs on top of its noise.
+
+namespace
+{
+    using world::ChunkContents;
+
+    constexpr i32 FootprintsPerAxis = 16;
+    // Terrain is never more than about 1060 from 0, every layer between is swept as the surface
+    // may be only one or two layers thick across the square
+    constexpr i32 LowestLayer       = -20;
+    constexpr i32 HighestLayer      = 20;
+    constexpr i32 ChunkWidth        = 64;
+    constexpr u64 Seed              = 3849234;
+
+    struct LayerContents
+    {
+        // Indexed by ChunkContents
+        std::array<std::size_t, 4> number_of_chunks;
+        std::size_t                number_of_updates;
+    };
+
+    LayerContents generateLayer(const world::WorldGenerator& generator, i32 layer)
+    {
+        LayerContents contents {.number_of_chunks {}, .number_of_updates {0}};
+
+        for (i32 x = 0; x < FootprintsPerAxis; ++x)
+        {
+            for (i32 z = 0; z < FootprintsPerAxis; ++z)
+            {
+                const world::GeneratedChunk chunk = generator.generateChunk(
+                    voxel::ChunkLocation {glm::ivec3 {x, layer, z} * ChunkWidth, 0});
+
+                contents.number_of_chunks[util::toUnderlying(chunk.contents)] += 1;
+                contents.number_of_updates += chunk.updates.size();
+            }
+        }
+
+        return contents;
+    }
+} // namespace
+
+int main()
+{
+    const bench::BenchmarkEnvironment environment {};
+
+    const world::WorldGenerator generator {Seed};
+
+    for (i32 layer = LowestLayer; layer <= HighestLayer; ++layer)
+    {
+        const LayerContents contents = generateLayer(generator, layer);
+
+        const bench::Measurement measurement = bench::measure(
+            [&]
+            {
+                return generateLayer(generator, layer).number_of_updates;
+            });
+
+        const std::size_t chunksPerLayer = FootprintsPerAxis * FootprintsPerAxis;
+
+        util::logLog(
+            "y {} | {} chunks/s | {} empty {} buried {} solid {} surface | {} updates per chunk",
+            layer * ChunkWidth,
+            static_cast<i64>(
+                static_cast<f64>(chunksPerLayer) * 1e9
+                / static_cast<f64>(measurement.time_per_call.count())),
+            contents.number_of_chunks[util::toUnderlying(ChunkContents::Empty)],
+            contents.number_of_chunks[util::toUnderlying(ChunkContents::Buried)],
+            contents.number_of_chunks[util::toUnderlying(ChunkContents::Solid)],
+            contents.number_of_chunks[util::toUnderlying(ChunkContents::Surface)],
+            contents.number_of_updates / chunksPerLayer);
+    }
+
+    return EXIT_SUCCESS;
+}
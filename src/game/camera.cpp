@@ -47,6 +47,37 @@ namespace game
         return projection * this->getViewMatrix() * transform_.asModelMatrix();
     }
 
+    std::array<glm::vec4, 6> Camera::getFrustumPlanes(const Game& game) const
+    {
+        const glm::mat4 m = this->getPerspectiveMatrix(game, Transform {});
+
+        const glm::vec4 row0 {m[0][0], m[1][0], m[2][0], m[3][0]};
+        const glm::vec4 row1 {m[0][1], m[1][1], m[2][1], m[3][1]};
+        const glm::vec4 row2 {m[0][2], m[1][2], m[2][2], m[3][2]};
+        const glm::vec4 row3 {m[0][3], m[1][3], m[2][3], m[3][3]};
+
+        std::array<glm::vec4, 6> planes {
+            row3 + row0, // left
+            row3 - row0, // right
+            row3 + row1, // bottom
+            row3 - row1, // top
+            row3 - row2, // near, depth is reversed
+            row2,        // far, degenerate and always passes with an infinite projection
+        };
+
+        for (glm::vec4& p : planes)
+        {
+            const float length = glm::length(glm::vec3 {p});
+
+            if (length > 0.0f)
+            {
+                p /= length;
+            }
+        }
+
+        return planes;
+    }
+
     glm::mat4 Camera::getModelMatrix() const
     {
         return this->transform.asModelMatrix();
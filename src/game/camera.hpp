@@ -2,6 +2,7 @@
 
 #include "game/transform.hpp"
 #include "transform.hpp"
+#include <array>
 
 namespace game
 {
@@ -15,6 +16,9 @@ namespace game
         explicit Camera(glm::vec3 position);
 
         [[nodiscard]] glm::mat4 getPerspectiveMatrix(const Game&, const Transform&) const;
+        /// World space planes (xyz = inwards normal, w = distance) of the view frustum, a point
+        /// p is inside when dot(plane.xyz, p) + plane.w >= 0 for all six
+        [[nodiscard]] std::array<glm::vec4, 6> getFrustumPlanes(const Game&) const;
         [[nodiscard]] glm::mat4 getModelMatrix() const;
         [[nodiscard]] glm::mat4 getViewMatrix() const;
         [[nodiscard]] glm::vec3 getForwardVector() const;
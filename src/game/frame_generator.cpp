@@ -38,6 +38,12 @@ std::atomic<u32> numberOfFacesPossible  = 0; // NOLINT
 
 std::atomic<u32> numberOfChunksAllocated = 0; // NOLINT
 std::atomic<u32> numberOfChunksPossible  = 0; // NOLINT
+std::atomic<u32> numberOfChunksElided    = 0; // NOLINT
+std::atomic<u32> numberOfChunksOccluded  = 0; // NOLINT
+std::atomic<u32> numberOfChunkDraws      = 0; // NOLINT
+
+std::atomic<u32> numberOfMeshCacheHits   = 0; // NOLINT
+std::atomic<u32> numberOfMeshCacheMisses = 0; // NOLINT
 
 std::atomic<u32> numberOfBricksAllocated = 0; // NOLINT
 std::atomic<u32> numberOfBricksPossible  = 0; // NOLINT
@@ -1318,6 +1324,12 @@ namespace game
 
                         auto chunks         = numberOfChunksAllocated.load();
                         auto chunksPossible = numberOfChunksPossible.load();
+                        auto chunksElided   = numberOfChunksElided.load();
+                        auto chunksOccluded = numberOfChunksOccluded.load();
+                        auto chunkDraws     = numberOfChunkDraws.load();
+
+                        auto meshCacheHits   = numberOfMeshCacheHits.load();
+                        auto meshCacheMisses = numberOfMeshCacheMisses.load();
 
                         auto bricks         = numberOfBricksAllocated.load();
                         auto bricksPossible = numberOfBricksPossible.load();
@@ -1334,9 +1346,11 @@ namespace game
                             "Ram: {}\n"
                             "Vram: {}\n"
                             "Staging Usage: {}\n"
-                            "Chunks {} / {} | {:.3f}%\n"
+                            "Chunks {} / {} | {:.3f}% | {} elided | {} occluded\n"
                             "Bricks {} / {} | {:.3f}%\n"
                             "Faces {} / {} / {} / {} | {:.3f}%\n"
+                            "Overdraw {:.3f} faces drawn per visible face | {} draws\n"
+                            "Mesh Cache {} hits / {} misses | {:.3f}%\n"
                             "Fly Speed {}",
                             camera.getPosition().x,
                             camera.getPosition().y,
@@ -1357,6 +1371,8 @@ namespace game
                             chunksPossible,
                             100.0f * static_cast<float>(chunks)
                                 / static_cast<float>(chunksPossible),
+                            chunksElided,
+                            chunksOccluded,
                             bricks,
                             bricksPossible,
                             100.0f * static_cast<float>(bricks)
@@ -1367,6 +1383,13 @@ namespace game
                             facesPossible,
                             100.0f * static_cast<float>(facesVisible)
                                 / static_cast<float>(facesPossible),
+                            static_cast<float>(facesOnGpu)
+                                / static_cast<float>(std::max(facesVisible, 1U)),
+                            chunkDraws,
+                            meshCacheHits,
+                            meshCacheMisses,
+                            100.0f * static_cast<float>(meshCacheHits)
+                                / static_cast<float>(std::max(meshCacheHits + meshCacheMisses, 1U)),
                             fly);
 
                         ImGui::TextWrapped("%s", menuText.c_str()); // NOLINT
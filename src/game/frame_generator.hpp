@@ -21,6 +21,12 @@ extern std::atomic<u32> numberOfFacesAllocated; // NOLINT
 
 extern std::atomic<u32> numberOfChunksAllocated; // NOLINT
 extern std::atomic<u32> numberOfChunksPossible;  // NOLINT
+extern std::atomic<u32> numberOfChunksElided;    // NOLINT
+extern std::atomic<u32> numberOfChunksOccluded;  // NOLINT
+extern std::atomic<u32> numberOfChunkDraws;      // NOLINT
+
+extern std::atomic<u32> numberOfMeshCacheHits;   // NOLINT
+extern std::atomic<u32> numberOfMeshCacheMisses; // NOLINT
 
 extern std::atomic<u32> numberOfBricksAllocated; // NOLINT
 extern std::atomic<u32> numberOfBricksPossible;  // NOLINT
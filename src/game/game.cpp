@@ -16,7 +16,6 @@
 #include <gfx/vulkan/device.hpp>
 #include <gfx/window.hpp>
 #include <memory>
-#include <random>
 #include <util/log.hpp>
 #include <vulkan/vulkan_structs.hpp>
 
@@ -84,8 +83,6 @@ namespace game
 
         bool isFirstIterationAfterGameStateChange = true;
 
-        std::mt19937 drawShuffler {std::random_device {}()};
-
         while (!this->renderer->shouldWindowClose() && !this->should_game_close.load())
         {
             this->active_game_state.lock(
@@ -110,11 +107,6 @@ namespace game
                         GameState::OnFrameReturnData package = state->onFrame(deltaTime);
                         auto                         end     = std::chrono::steady_clock::now();
 
-                        std::shuffle(
-                            package.record_objects.begin(),
-                            package.record_objects.end(),
-                            drawShuffler);
-
                         std::chrono::duration<float> diff = end - start;
 
                         std::vector<gfx::profiler::ProfilerTask> tasks =
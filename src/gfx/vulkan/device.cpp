@@ -3,7 +3,9 @@
 #include "util/misc.hpp"
 #include "util/threads.hpp"
 #include <algorithm>
+#include <array>
 #include <optional>
+#include <utility>
 #include <vulkan/vulkan.hpp>
 #include <vulkan/vulkan_enums.hpp>
 #include <vulkan/vulkan_handles.hpp>
@@ -192,15 +194,47 @@ namespace gfx::vulkan
 #endif // __APPLE__,
         };
 
+        const vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>
+            supportedFeatures = this->physical_device.getFeatures2<
+                vk::PhysicalDeviceFeatures2,
+                vk::PhysicalDeviceVulkan12Features>();
+        const vk::PhysicalDeviceFeatures& supportedFeatures10 =
+            supportedFeatures.get<vk::PhysicalDeviceFeatures2>().features;
+        const vk::PhysicalDeviceVulkan12Features& supportedFeatures12 =
+            supportedFeatures.get<vk::PhysicalDeviceVulkan12Features>();
+
+        // Per chunk data is split across an array of storage buffers, one per page, that the
+        // voxel shaders index with a chunk id that differs between invocations
+        const std::array<std::pair<vk::Bool32, const char*>, 3> chunkDataPageFeatures {{
+            {supportedFeatures10.shaderStorageBufferArrayDynamicIndexing,
+             "shaderStorageBufferArrayDynamicIndexing"},
+            {supportedFeatures12.shaderStorageBufferArrayNonUniformIndexing,
+             "shaderStorageBufferArrayNonUniformIndexing"},
+            {supportedFeatures12.runtimeDescriptorArray, "runtimeDescriptorArray"},
+        }};
+
+        for (const auto& [isSupported, name] : chunkDataPageFeatures)
+        {
+            if (!static_cast<bool>(isSupported))
+            {
+                util::panic(
+                    "{} doesn't support {}, which is required to index the pages of chunk data",
+                    this->physical_device.getProperties().deviceName.data(),
+                    name);
+            }
+        }
+
         vk::PhysicalDeviceFeatures features {};
-        features.shaderInt16              = vk::True;
-        features.multiDrawIndirect        = vk::True;
-        features.fragmentStoresAndAtomics = vk::True;
+        features.shaderInt16                             = vk::True;
+        features.multiDrawIndirect                       = vk::True;
+        features.fragmentStoresAndAtomics                = vk::True;
+        features.shaderStorageBufferArrayDynamicIndexing = vk::True;
 
         vk::PhysicalDeviceVulkan12Features features12 {};
         features12.sType                  = vk::StructureType::ePhysicalDeviceVulkan12Features;
         features12.pNext                  = nullptr;
         features12.runtimeDescriptorArray = vk::True;
+        features12.shaderStorageBufferArrayNonUniformIndexing = vk::True;
 
         vk::PhysicalDeviceVulkan11Features features11 {};
         features11.sType                    = vk::StructureType::ePhysicalDeviceVulkan11Features;
@@ -7,6 +7,7 @@
 #include "util/misc.hpp"
 #include <glm/gtx/hash.hpp>
 using glm::ivec3;
+using glm::uvec3;
 using glm::vec3;
 using glm::vec4;
 
@@ -67,6 +68,73 @@ GLSL_INLINE u32 gpu_hashChunkCoordinate(Gpu_ChunkLocation location)
     return seed;
 }
 
+GLSL_INLINE bool gpu_isChunkLocationEqual(Gpu_ChunkLocation a, Gpu_ChunkLocation b)
+{
+    return a.root_position.x == b.root_position.x && a.root_position.y == b.root_position.y
+        && a.root_position.z == b.root_position.z && a.lod == b.lod;
+}
+
+// Chunk Hash Table
+// Open addressed Robin Hood table of Gpu_ChunkLocation -> chunk id. Each value holds the chunk id
+// in its low bits and the entry's distance from its home slot in the high bits, so a lookup can
+// stop as soon as it reaches an entry that is closer to home than it is.
+const u32 GpuChunkHashTableCapacity       = 1u << 21u;
+const u32 GpuChunkHashTableMaxProbeLength = 64u;
+const u32 GpuChunkHashTableIdBits         = 23u;
+const u32 GpuChunkHashTableEmpty          = ~0u;
+
+const u32 GpuChunkHashTableProbeMiss     = 0u;
+const u32 GpuChunkHashTableProbeHit      = 1u;
+const u32 GpuChunkHashTableProbeContinue = 2u;
+
+GLSL_INLINE u32 gpu_chunkHashTableHomeSlot(Gpu_ChunkLocation location)
+{
+    return gpu_hashChunkCoordinate(location) & (GpuChunkHashTableCapacity - 1u);
+}
+
+GLSL_INLINE u32 gpu_chunkHashTableNextSlot(u32 slot)
+{
+    return (slot + 1u) & (GpuChunkHashTableCapacity - 1u);
+}
+
+GLSL_INLINE u32 gpu_packChunkHashTableValue(u32 chunkId, u32 probeLength)
+{
+    return chunkId | (probeLength << GpuChunkHashTableIdBits);
+}
+
+GLSL_INLINE u32 gpu_unpackChunkHashTableId(u32 value)
+{
+    return value & ((1u << GpuChunkHashTableIdBits) - 1u);
+}
+
+GLSL_INLINE u32 gpu_unpackChunkHashTableProbeLength(u32 value)
+{
+    return value >> GpuChunkHashTableIdBits;
+}
+
+// One step of a lookup, `probeLength` slots away from `key`'s home slot
+GLSL_INLINE u32 gpu_chunkHashTableProbe(
+    Gpu_ChunkLocation key, u32 probeLength, Gpu_ChunkLocation slotKey, u32 slotValue)
+{
+    if (slotValue == GpuChunkHashTableEmpty)
+    {
+        return GpuChunkHashTableProbeMiss;
+    }
+
+    if (gpu_isChunkLocationEqual(slotKey, key))
+    {
+        return GpuChunkHashTableProbeHit;
+    }
+
+    // Had our key been present it would have displaced this entry
+    if (gpu_unpackChunkHashTableProbeLength(slotValue) < probeLength)
+    {
+        return GpuChunkHashTableProbeMiss;
+    }
+
+    return GpuChunkHashTableProbeContinue;
+}
+
 GLSL_INLINE u32 gpu_calculateChunkWidthUnits(u32 lod)
 {
     return 64u << lod;
@@ -77,6 +145,128 @@ GLSL_INLINE u32 gpu_calculateChunkVoxelSizeUnits(u32 lod)
     return 1u << lod;
 }
 
+// The voxels of a brick and the bricks of a chunk's brick map are both 8^3 arrays, stored either
+// in Z-order (x in the lowest bit) or as [x][y][z]. Z-order keeps neighbours along every axis
+// close in memory, [x][y][z] only along z. Chosen at configure time for both C++ and shaders.
+#ifndef LAVENDER_MORTON_BRICK_LAYOUT
+#define LAVENDER_MORTON_BRICK_LAYOUT 0
+#endif
+
+const u32 GpuBrickLayoutSize = 512u;
+
+// Moves bit i of the low 10 bits of x to bit 3i
+GLSL_INLINE u32 gpu_mortonSpread(u32 x)
+{
+    x &= 0x000003FFu;
+    x = (x | (x << 16u)) & 0x030000FFu;
+    x = (x | (x << 8u)) & 0x0300F00Fu;
+    x = (x | (x << 4u)) & 0x030C30C3u;
+    x = (x | (x << 2u)) & 0x09249249u;
+
+    return x;
+}
+
+// Inverse of gpu_mortonSpread
+GLSL_INLINE u32 gpu_mortonCompact(u32 x)
+{
+    x &= 0x09249249u;
+    x = (x | (x >> 2u)) & 0x030C30C3u;
+    x = (x | (x >> 4u)) & 0x0300F00Fu;
+    x = (x | (x >> 8u)) & 0x030000FFu;
+    x = (x | (x >> 16u)) & 0x000003FFu;
+
+    return x;
+}
+
+GLSL_INLINE u32 gpu_mortonEncode(uvec3 p)
+{
+    return gpu_mortonSpread(p.x) | (gpu_mortonSpread(p.y) << 1u) | (gpu_mortonSpread(p.z) << 2u);
+}
+
+GLSL_INLINE uvec3 gpu_mortonDecode(u32 m)
+{
+    return uvec3(gpu_mortonCompact(m), gpu_mortonCompact(m >> 1u), gpu_mortonCompact(m >> 2u));
+}
+
+// Where p, each component in [0, 8), lives in a brick or brick map
+GLSL_INLINE u32 gpu_brickLayoutIndex(uvec3 p)
+{
+#if LAVENDER_MORTON_BRICK_LAYOUT
+    return gpu_mortonEncode(p);
+#else
+    return (p.x * 64u) + (p.y * 8u) + p.z;
+#endif
+}
+
+GLSL_INLINE uvec3 gpu_brickLayoutPosition(u32 index)
+{
+#if LAVENDER_MORTON_BRICK_LAYOUT
+    return gpu_mortonDecode(index);
+#else
+    return uvec3(index / 64u, (index / 8u) % 8u, index % 8u);
+#endif
+}
+
+// PerChunkGpuData is split across buffers of this many chunks
+const u32 GpuChunksPerDataPage = 4096u;
+const u32 GpuMaxChunkDataPages = 256u;
+
+// Per chunk data grows a whole page at a time, this is how many chunks fit in the pages that
+// chunkId needs
+GLSL_INLINE u32 gpu_calculateChunkDataPageCapacity(u32 chunkId)
+{
+    return ((chunkId / GpuChunksPerDataPage) + 1u) * GpuChunksPerDataPage;
+}
+
+// Packed face data holds the brick's index into the brick buffers in its low bits, so no more
+// bricks than this may exist at once
+const u32 GpuBrickPointerBits = 20u;
+
+// A brick's parent info is its chunk id in the low bits and its brick's linear index within
+// that chunk in the high 9 bits
+const u32 GpuBrickParentChunkBits = 23u;
+
+GLSL_INLINE u32 gpu_packBrickParentInformation(u32 parentChunk, u32 positionInParentChunk)
+{
+    return (parentChunk & ((1u << GpuBrickParentChunkBits) - 1u))
+         | (positionInParentChunk << GpuBrickParentChunkBits);
+}
+
+GLSL_INLINE u32 gpu_unpackBrickParentChunk(u32 parentInformation)
+{
+    return parentInformation & ((1u << GpuBrickParentChunkBits) - 1u);
+}
+
+GLSL_INLINE u32 gpu_unpackBrickPositionInParentChunk(u32 parentInformation)
+{
+    return parentInformation >> GpuBrickParentChunkBits;
+}
+
+// Each visible chunk draw is one u32, either a chunk id with the first and last of a run of its
+// directions that are drawn together, or with GpuVisibleChunkDrawExplicitBit set an index into
+// that frame's explicit draws
+const u32 GpuVisibleChunkDrawExplicitBit = 1u << 31u;
+
+GLSL_INLINE u32 gpu_packVisibleChunkDraw(u32 chunkId, u32 firstDirection, u32 lastDirection)
+{
+    return (chunkId << 6u) | (firstDirection << 3u) | lastDirection;
+}
+
+GLSL_INLINE u32 gpu_unpackVisibleChunkDrawChunkId(u32 draw)
+{
+    return draw >> 6u;
+}
+
+GLSL_INLINE u32 gpu_unpackVisibleChunkDrawFirstDirection(u32 draw)
+{
+    return (draw >> 3u) & 7u;
+}
+
+GLSL_INLINE u32 gpu_unpackVisibleChunkDrawLastDirection(u32 draw)
+{
+    return draw & 7u;
+}
+
 GLSL_INLINE u32 gpu_linearToSRGB(vec4 color)
 {
     vec3 t;
@@ -27,9 +27,10 @@ layout(set = 1, binding = 1) readonly buffer RaytracedLightDataBuffer
 }
 in_raytraced_lights;
 
+// Indexed by gpu_brickLayoutIndex
 struct ChunkBrickMap
 {
-    u16 data[8][8][8];
+    u16 data[GpuBrickLayoutSize];
 };
 
 struct PerChunkGpuData
@@ -39,53 +40,63 @@ struct PerChunkGpuData
     i32           world_offset_z;
     u32           lod;
     u32           brick_allocation_offset;
+    u32           direction_face_offsets[6];
     ChunkBrickMap data;
 };
 
-layout(set = 1, binding = 2) readonly buffer GpuChunkDataBuffer
+layout(set = 1, binding = 2) readonly buffer GpuChunkDataPage
 {
     PerChunkGpuData data[];
 }
-in_gpu_chunk_data;
+in_gpu_chunk_data_pages[];
+
+#define GpuChunkData_get(chunk_id)                                                                 \
+    in_gpu_chunk_data_pages[nonuniformEXT((chunk_id) / GpuChunksPerDataPage)]                      \
+        .data[(chunk_id) % GpuChunksPerDataPage]
 
 layout(set = 1, binding = 3) readonly buffer AlignedChunkHashTableKeys
 {
-    u32 keys[];
+    Gpu_ChunkLocation keys[];
 }
 in_aligned_chunk_hash_table_keys;
 
 layout(set = 1, binding = 4) readonly buffer AlignedChunkHashTableValues
 {
-    u16 values[];
+    u32 values[];
 }
 in_aligned_chunk_hash_table_values;
 
-const u32 MaxChunkHashNodes = 1U << 16U;
-const u32 ChunkHashEmpty    = ~0u;
-
-u16 ChunkHashTable_load(Gpu_ChunkLocation chunk)
+// Mirrors voxel::ChunkHashTable::find
+u32 ChunkHashTable_load(Gpu_ChunkLocation chunk)
 {
-    const u32 key = gpu_hashChunkCoordinate(chunk);
-
-    uint32_t slot = key % MaxChunkHashNodes;
+    u32 slot = gpu_chunkHashTableHomeSlot(chunk);
 
-    while (true)
+    for (u32 probeLength = 0; probeLength < GpuChunkHashTableMaxProbeLength; ++probeLength)
     {
-        if (in_aligned_chunk_hash_table_keys.keys[slot] == key)
+        const u32 value = in_aligned_chunk_hash_table_values.values[slot];
+
+        const u32 result = gpu_chunkHashTableProbe(
+            chunk, probeLength, in_aligned_chunk_hash_table_keys.keys[slot], value);
+
+        if (result == GpuChunkHashTableProbeHit)
         {
-            return in_aligned_chunk_hash_table_values.values[slot];
+            return gpu_unpackChunkHashTableId(value);
         }
-        if (in_aligned_chunk_hash_table_keys.keys[slot] == ChunkHashEmpty)
+        if (result == GpuChunkHashTableProbeMiss)
         {
-            return u16(~0u);
+            return GpuChunkHashTableEmpty;
         }
-        slot = (slot + 1) % MaxChunkHashNodes;
+
+        slot = gpu_chunkHashTableNextSlot(slot);
     }
+
+    return GpuChunkHashTableEmpty;
 }
 
 u32 BrickMap_load(u32 chunk_id, uvec3 coord)
 {
-    const u16 maybeOffset = in_gpu_chunk_data.data[chunk_id].data.data[coord.x][coord.y][coord.z];
+    const u16 maybeOffset =
+        GpuChunkData_get(chunk_id).data.data[gpu_brickLayoutIndex(coord)];
 
     if (maybeOffset == u16(-1))
     {
@@ -93,7 +104,7 @@ u32 BrickMap_load(u32 chunk_id, uvec3 coord)
     }
     else
     {
-        return maybeOffset + in_gpu_chunk_data.data[chunk_id].brick_allocation_offset;
+        return maybeOffset + GpuChunkData_get(chunk_id).brick_allocation_offset;
     }
 }
 
@@ -113,9 +124,10 @@ struct Voxel
     u16 data;
 };
 
+// Indexed by gpu_brickLayoutIndex
 struct MaterialBrick
 {
-    Voxel data[8][8][8];
+    Voxel data[GpuBrickLayoutSize];
 };
 
 layout(set = 1, binding = 6) readonly buffer MaterialBrickBuffer
@@ -301,6 +313,39 @@ layout(set = 1, binding = 12) readonly buffer VoxelMaterialBuffer
 }
 in_voxel_materials;
 
+struct GpuDrawIndirectCommand
+{
+    u32 vertex_count;
+    u32 instance_count;
+    u32 first_vertex;
+    u32 first_instance;
+};
+
+// Indexed by chunk_id * 6 + direction, only rewritten when a chunk's faces move
+layout(set = 1, binding = 13) readonly buffer ChunkDirectionDrawBuffer
+{
+    GpuDrawIndirectCommand command[];
+}
+in_chunk_direction_draws;
+
+layout(set = 1, binding = 14) readonly buffer VisibleChunkDrawBuffer
+{
+    u32 draw[];
+}
+in_visible_chunk_draws;
+
+layout(set = 1, binding = 15) readonly buffer ExplicitChunkDrawBuffer
+{
+    GpuDrawIndirectCommand command[];
+}
+in_explicit_chunk_draws;
+
+layout(set = 1, binding = 16) writeonly buffer IndirectCommandBuffer
+{
+    GpuDrawIndirectCommand command[];
+}
+in_indirect_commands;
+
 vec3 unpackNormalId(u32 id)
 {
     const vec3 available_normals[6] = {
@@ -67,8 +67,8 @@ void main()
     //     discard;
     // }
 
-    const u32 brick_pointer = bitfieldExtract(in_face_brick_data, 0, 20);
-    const u32 face_number   = bitfieldExtract(in_face_brick_data, 20, 9);
+    const u32 brick_pointer = bitfieldExtract(in_face_brick_data, 0, int(GpuBrickPointerBits));
+    const u32 face_number   = bitfieldExtract(in_face_brick_data, int(GpuBrickPointerBits), 9);
     const u32 normal        = bitfieldExtract(in_face_brick_data, 29, 3);
 
     const uvec3 brick_local_position =
@@ -12,7 +12,7 @@ layout(location = 0) out u32 out_face_data;
 void main()
 {
     const float chunk_voxel_size =
-        gpu_calculateChunkVoxelSizeUnits(in_gpu_chunk_data.data[in_chunk_id].lod);
+        gpu_calculateChunkVoxelSizeUnits(GpuChunkData_get(in_chunk_id).lod);
 
     const uvec3 chunk_local_position = uvec3(floor(in_chunk_local_position / chunk_voxel_size));
 
@@ -21,9 +21,8 @@ void main()
 
     const u32 this_brick_pointer = BrickMap_load(in_chunk_id, brick_coordinate);
 
-    const Voxel this_voxel =
-        in_material_bricks.brick[this_brick_pointer]
-            .data[brick_local_position.x][brick_local_position.y][brick_local_position.z];
+    const Voxel this_voxel = in_material_bricks.brick[this_brick_pointer]
+                                 .data[gpu_brickLayoutIndex(brick_local_position)];
 
     const VoxelMaterial this_material = in_voxel_materials.material[int(this_voxel.data)];
 
@@ -32,8 +31,8 @@ void main()
 
     u32 res = 0;
 
-    res = bitfieldInsert(res, this_brick_pointer, 0, 20);
-    res = bitfieldInsert(res, brick_local_number, 20, 9);
+    res = bitfieldInsert(res, this_brick_pointer, 0, int(GpuBrickPointerBits));
+    res = bitfieldInsert(res, brick_local_number, int(GpuBrickPointerBits), 9);
     res = bitfieldInsert(res, in_normal_id, 29, 3);
 
     out_face_data = res;
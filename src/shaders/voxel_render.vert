@@ -38,18 +38,27 @@ layout(push_constant) uniform PushConstants
 }
 in_push_constants;
 
-layout(location = 0) in u32 in_normal_id;
-layout(location = 1) in u32 in_chunk_id;
-
 layout(location = 0) out u32 out_chunk_id;
 layout(location = 1) out vec3 out_chunk_local_position;
 layout(location = 2) out u32 out_normal_id;
 
 void main()
 {
+    // Every draw's firstInstance is the id of the chunk it draws
+    const u32 chunk_id = u32(gl_InstanceIndex);
+
     const u32 face_number       = gl_VertexIndex / 6;
     const u32 point_within_face = gl_VertexIndex % 6;
 
+    // A draw may span several of the chunk's directions, which are laid out back to back in
+    // VoxelFaceDirection order
+    u32 normal_id = 0;
+
+    for (u32 i = 1; i < 6; ++i)
+    {
+        normal_id += u32(face_number >= GpuChunkData_get(chunk_id).direction_face_offsets[i]);
+    }
+
     const GreedyVoxelFace greedy_face = in_greedy_voxel_faces.face[face_number];
 
     const u32 x_pos  = GreedyVoxelFace_x(greedy_face);
@@ -61,17 +70,17 @@ void main()
     const uvec3 voxel_position_in_chunk = uvec3(x_pos, y_pos, z_pos);
 
     const float chunk_voxel_size =
-        gpu_calculateChunkVoxelSizeUnits(in_gpu_chunk_data.data[in_chunk_id].lod);
+        gpu_calculateChunkVoxelSizeUnits(GpuChunkData_get(chunk_id).lod);
 
     const uvec3 face_point_local = uvec3(
-        chunk_voxel_size * FACE_LOOKUP_TABLE[in_normal_id][IDX_TO_VTX_TABLE[point_within_face]]);
+        chunk_voxel_size * FACE_LOOKUP_TABLE[normal_id][IDX_TO_VTX_TABLE[point_within_face]]);
 
     vec3 scaled_face_point_local = vec3(0.0);
 
     const float width_scale  = float(1 + width);
     const float height_scale = float(1 + height);
 
-    if (in_normal_id == 0 || in_normal_id == 1)
+    if (normal_id == 0 || normal_id == 1)
     {
         // TOP or BOTTOM face: scale X and Z
         scaled_face_point_local = vec3(
@@ -79,7 +88,7 @@ void main()
             face_point_local.y,
             face_point_local.z * height_scale);
     }
-    else if (in_normal_id == 2 || in_normal_id == 3)
+    else if (normal_id == 2 || normal_id == 3)
     {
         // LEFT or RIGHT face: scale Y and Z
         scaled_face_point_local = vec3(
@@ -100,18 +109,18 @@ void main()
         chunk_voxel_size * voxel_position_in_chunk + scaled_face_point_local;
 
     const ivec3 in_chunk_position = ivec3(
-        in_gpu_chunk_data.data[in_chunk_id].world_offset_x,
-        in_gpu_chunk_data.data[in_chunk_id].world_offset_y,
-        in_gpu_chunk_data.data[in_chunk_id].world_offset_z);
+        GpuChunkData_get(chunk_id).world_offset_x,
+        GpuChunkData_get(chunk_id).world_offset_y,
+        GpuChunkData_get(chunk_id).world_offset_z);
 
     const vec3 face_point_world = vec3(in_chunk_position.xyz) + point_within_chunk;
 
-    const vec3 normal = unpackNormalId(in_normal_id);
+    const vec3 normal = unpackNormalId(normal_id);
 
     gl_Position = in_mvp_matrices.matrix[in_push_constants.matrix_id] * vec4(face_point_world, 1.0);
     out_chunk_local_position = point_within_chunk + chunk_voxel_size * (0.5 * -normal);
     // (voxel_position_in_chunk + scaled_face_point_local) + 0.5 * chunk_voxel_size
     // + chunk_voxel_size* normal;
-    out_chunk_id             = in_chunk_id;
-    out_normal_id            = in_normal_id;
+    out_chunk_id             = chunk_id;
+    out_normal_id            = normal_id;
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace util
+{
+    /// A least recently used cache bounded by the sum of the costs of the elements inside of it.
+    /// Not threadsafe, wrap it in a util::Mutex if you need that
+    template<class K, class V, class Hash = std::hash<K>>
+    class LruCache
+    {
+    public:
+        explicit LruCache(std::size_t maxCost_)
+            : max_cost {maxCost_}
+            , current_cost {0}
+        {}
+        ~LruCache() = default;
+
+        LruCache(const LruCache&)             = delete;
+        LruCache(LruCache&&)                  = default;
+        LruCache& operator= (const LruCache&) = delete;
+        LruCache& operator= (LruCache&&)      = default;
+
+        /// Inserts, replacing any previous value with the same key, and then evicts the least
+        /// recently used elements until the cache is back under its budget
+        void insert(const K& key, V value, std::size_t cost)
+        {
+            this->erase(key);
+
+            if (cost > this->max_cost)
+            {
+                return;
+            }
+
+            this->elements.push_front(Entry {.key {key}, .value {std::move(value)}, .cost {cost}});
+            this->lookup.insert({key, this->elements.begin()});
+            this->current_cost += cost;
+
+            while (this->current_cost > this->max_cost)
+            {
+                this->current_cost -= this->elements.back().cost;
+                this->lookup.erase(this->elements.back().key);
+                this->elements.pop_back();
+            }
+        }
+
+        /// Removes the element from the cache and returns it
+        [[nodiscard]] std::optional<V> take(const K& key)
+        {
+            const auto it = this->lookup.find(key);
+
+            if (it == this->lookup.end())
+            {
+                return std::nullopt;
+            }
+
+            std::optional<V> output {std::move(it->second->value)};
+
+            this->current_cost -= it->second->cost;
+            this->elements.erase(it->second);
+            this->lookup.erase(it);
+
+            return output;
+        }
+
+        /// Marks the element as the most recently used and returns it without copying, the
+        /// pointer is valid until the next insert, take or erase
+        [[nodiscard]] const V* find(const K& key)
+        {
+            const auto it = this->lookup.find(key);
+
+            if (it == this->lookup.end())
+            {
+                return nullptr;
+            }
+
+            this->elements.splice(this->elements.begin(), this->elements, it->second);
+
+            return &it->second->value;
+        }
+
+        [[nodiscard]] bool contains(const K& key) const
+        {
+            return this->lookup.contains(key);
+        }
+
+        void erase(const K& key)
+        {
+            std::ignore = this->take(key);
+        }
+
+        [[nodiscard]] std::size_t getCost() const
+        {
+            return this->current_cost;
+        }
+
+        [[nodiscard]] std::size_t getNumberOfElements() const
+        {
+            return this->elements.size();
+        }
+
+    private:
+        struct Entry
+        {
+            K           key;
+            V           value;
+            std::size_t cost;
+        };
+
+        std::size_t max_cost;
+        std::size_t current_cost;
+
+        std::list<Entry>                                                elements;
+        std::unordered_map<K, typename std::list<Entry>::iterator, Hash> lookup;
+    };
+} // namespace util
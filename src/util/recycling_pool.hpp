@@ -0,0 +1,69 @@
+#pragma once
+
+#include "threads.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace util
+{
+    /// Holds on to released objects so that whatever memory they own is reused by the next
+    /// acquire instead of going back to the global allocator. Objects are handed back exactly as
+    /// they were released, resetting them is up to the caller.
+    /// Threadsafe.
+    template<class T>
+    class RecyclingPool
+    {
+    public:
+        explicit RecyclingPool(std::size_t maxRetained)
+            : max_retained {maxRetained}
+        {
+            this->retained.lock(
+                [&](std::vector<T>& r)
+                {
+                    r.reserve(this->max_retained);
+                });
+        }
+        ~RecyclingPool() = default;
+
+        RecyclingPool(const RecyclingPool&)             = delete;
+        RecyclingPool(RecyclingPool&&)                  = delete;
+        RecyclingPool& operator= (const RecyclingPool&) = delete;
+        RecyclingPool& operator= (RecyclingPool&&)      = delete;
+
+        /// Returns a previously released object, or a default constructed one if there are none
+        [[nodiscard]] T acquire() const
+        {
+            return this->retained.lock(
+                [](std::vector<T>& r) -> T
+                {
+                    if (r.empty())
+                    {
+                        return T {};
+                    }
+
+                    T t = std::move(r.back());
+                    r.pop_back();
+
+                    return t;
+                });
+        }
+
+        /// Dropped instead if the pool already holds maxRetained objects
+        void release(T t) const
+        {
+            this->retained.lock(
+                [&](std::vector<T>& r)
+                {
+                    if (r.size() < this->max_retained)
+                    {
+                        r.push_back(std::move(t));
+                    }
+                });
+        }
+
+    private:
+        std::size_t                 max_retained;
+        util::Mutex<std::vector<T>> retained;
+    };
+} // namespace util
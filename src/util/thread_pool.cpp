@@ -38,6 +38,11 @@ namespace util
         }
     }
 
+    std::size_t ThreadPool::getNumberOfWorkers() const
+    {
+        return this->threads.size();
+    }
+
     void ThreadPool::threadFunction() const
     {
         using namespace std::literals;
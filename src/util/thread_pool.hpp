@@ -1,10 +1,14 @@
 #pragma once
 
 #include "timer.hpp"
+#include <algorithm>
+#include <atomic>
 #include <blockingconcurrentqueue.h>
 #include <functional>
 #include <future>
+#include <memory>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 
 namespace util
@@ -20,6 +24,8 @@ namespace util
         ThreadPool& operator= (const ThreadPool&) = delete;
         ThreadPool& operator= (ThreadPool&&)      = delete;
 
+        [[nodiscard]] std::size_t getNumberOfWorkers() const;
+
         template<class Fn, class R = std::invoke_result_t<Fn>>
         std::future<R> executeOnPool(Fn&& func) const
             requires std::is_invocable_v<Fn>
@@ -54,4 +60,63 @@ namespace util
     {
         return getGlobalThreadPool()->executeOnPool(std::forward<Fn>(func));
     }
+
+    /// Calls func(i) for every i in [0, numberOfTasks) across the global pool and the calling
+    /// thread and returns once every call has finished. The caller claims tasks as well, so this
+    /// never waits on workers that are busy with something else.
+    template<class Fn>
+    void parallelFor(std::size_t numberOfTasks, const Fn& func)
+        requires std::is_invocable_v<const Fn&, std::size_t>
+    {
+        if (numberOfTasks == 0)
+        {
+            return;
+        }
+
+        struct SharedState
+        {
+            std::atomic<std::size_t> next_task;
+            std::atomic<std::size_t> finished_tasks;
+        };
+
+        // Workers that only start after everything is done still touch this, but never func
+        std::shared_ptr<SharedState> state = std::make_shared<SharedState>();
+
+        auto work = [state, numberOfTasks, funcPtr = &func]
+        {
+            while (true)
+            {
+                const std::size_t task = state->next_task.fetch_add(1, std::memory_order_relaxed);
+
+                if (task >= numberOfTasks)
+                {
+                    return;
+                }
+
+                (*funcPtr)(task);
+
+                state->finished_tasks.fetch_add(1, std::memory_order_release);
+                state->finished_tasks.notify_all();
+            }
+        };
+
+        const std::size_t numberOfHelpers =
+            std::min(numberOfTasks, getGlobalThreadPool()->getNumberOfWorkers() + 1) - 1;
+
+        for (std::size_t i = 0; i < numberOfHelpers; ++i)
+        {
+            std::ignore = getGlobalThreadPool()->executeOnPool(work);
+        }
+
+        work();
+
+        std::size_t finished = state->finished_tasks.load(std::memory_order_acquire);
+
+        while (finished < numberOfTasks)
+        {
+            state->finished_tasks.wait(finished, std::memory_order_acquire);
+
+            finished = state->finished_tasks.load(std::memory_order_acquire);
+        }
+    }
 } // namespace util
\ No newline at end of file
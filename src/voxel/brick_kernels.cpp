@@ -0,0 +1,733 @@
+#include "brick_kernels.hpp"
+#include "shaders/include/common.glsl"
+#include "util/log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VOXEL_KERNELS_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define VOXEL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace voxel::kernels
+{
+    namespace
+    {
+        // A BitWords as one u64 per z slice, bit (x + 8y) of the slice
+        using Lanes = std::array<u64, VoxelsPerBrick / 64>;
+
+        Lanes toLanes(const BitWords& words)
+        {
+            Lanes lanes {};
+
+            for (std::size_t i = 0; i < lanes.size(); ++i)
+            {
+                lanes[i] = u64 {words[2 * i]} | (u64 {words[(2 * i) + 1]} << 32);
+            }
+
+            return lanes;
+        }
+
+        void fromLanes(BitWords& out, const Lanes& lanes)
+        {
+            for (std::size_t i = 0; i < lanes.size(); ++i)
+            {
+                out[2 * i]       = static_cast<u32>(lanes[i]);
+                out[(2 * i) + 1] = static_cast<u32>(lanes[i] >> 32);
+            }
+        }
+
+#if !LAVENDER_MORTON_BRICK_LAYOUT
+        // Bit j of byte i becomes bit i of byte j (Hacker's Delight, transpose8)
+        u64 transpose8x8(u64 x)
+        {
+            u64 t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+            x     = x ^ t ^ (t << 7);
+            t     = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+            x     = x ^ t ^ (t << 14);
+            t     = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+            x     = x ^ t ^ (t << 28);
+
+            return x;
+        }
+#endif // !LAVENDER_MORTON_BRICK_LAYOUT
+
+        // The vector paths compare values in the order they are in memory, which is a mask with
+        // bit gpu_brickLayoutIndex(p), BitBricks want bit (x + 8y + 64z)
+        void memoryMaskToBitBrick(BitWords& out, const BitWords& memoryMask)
+        {
+#if LAVENDER_MORTON_BRICK_LAYOUT
+            // Bit i of a Z-order index is bit (i / 3) of axis (i % 3), which is bit
+            // (3 * (i % 3) + i / 3) of a BitBrick index. That swaps index bits 1 with 3, 2 with 6
+            // and 5 with 7, each by exchanging the mask bits at the positions where the pair of
+            // index bits is 01 with those where it is 10.
+            // lane = index bits 6-8, bit = index bits 0-5
+            Lanes lanes = toLanes(memoryMask);
+
+            for (u64& lane : lanes)
+            {
+                const u64 t = (lane ^ (lane >> 6)) & 0x00CC00CC00CC00CCULL;
+                lane        = lane ^ t ^ (t << 6);
+            }
+
+            for (std::size_t l = 0; l < lanes.size(); l += 2)
+            {
+                const u64 t = ((lanes[l] >> 4) ^ lanes[l + 1]) & 0x0F0F0F0F0F0F0F0FULL;
+                lanes[l] ^= t << 4;
+                lanes[l + 1] ^= t;
+            }
+
+            for (const std::size_t l : std::array<std::size_t, 4> {0, 1, 4, 5})
+            {
+                const u64 t = ((lanes[l] >> 32) ^ lanes[l + 2]) & 0x00000000FFFFFFFFULL;
+                lanes[l] ^= t << 32;
+                lanes[l + 2] ^= t;
+            }
+
+            fromLanes(out, lanes);
+#else
+
+            // lane x, bit (8y + z)
+            const Lanes byX = toLanes(memoryMask);
+            // lane z, bit (8y + x)
+            Lanes byZ {};
+
+            for (std::size_t y = 0; y < 8; ++y)
+            {
+                // byte x, bit z
+                u64 rows = 0;
+
+                for (std::size_t x = 0; x < 8; ++x)
+                {
+                    rows |= ((byX[x] >> (8 * y)) & 0xFFU) << (8 * x);
+                }
+
+                // byte z, bit x
+                const u64 columns = transpose8x8(rows);
+
+                for (std::size_t z = 0; z < 8; ++z)
+                {
+                    byZ[z] |= ((columns >> (8 * z)) & 0xFFU) << (8 * y);
+                }
+            }
+
+            fromLanes(out, byZ);
+#endif // LAVENDER_MORTON_BRICK_LAYOUT
+        }
+
+        struct KernelTable
+        {
+            InstructionSet instruction_set;
+            bool (*is_uniform)(std::span<const u16, VoxelsPerBrick>);
+            bool (*is_empty)(const BitWords&);
+            bool (*is_full)(const BitWords&);
+            u32 (*popcount)(const BitWords&);
+            void (*bit_and)(BitWords&, const BitWords&, const BitWords&);
+            void (*bit_or)(BitWords&, const BitWords&, const BitWords&);
+            void (*bit_and_not)(BitWords&, const BitWords&, const BitWords&);
+            void (*extract_memory_mask)(BitWords&, std::span<const u16, VoxelsPerBrick>, u16);
+        };
+
+        // Scalar, written branchless so that the compiler is free to vectorize them for whatever
+        // baseline we're built for
+
+        bool isUniformScalar(std::span<const u16, VoxelsPerBrick> values)
+        {
+            const u16 first      = values[0];
+            u16       difference = 0;
+
+            for (const u16 v : values)
+            {
+                difference |= static_cast<u16>(v ^ first);
+            }
+
+            return difference == 0;
+        }
+
+        bool isEmptyScalar(const BitWords& words)
+        {
+            u32 anySet = 0;
+
+            for (const u32 w : words)
+            {
+                anySet |= w;
+            }
+
+            return anySet == 0;
+        }
+
+        bool isFullScalar(const BitWords& words)
+        {
+            u32 allSet = ~u32 {0};
+
+            for (const u32 w : words)
+            {
+                allSet &= w;
+            }
+
+            return allSet == ~u32 {0};
+        }
+
+        u32 popcountScalar(const BitWords& words)
+        {
+            u32 count = 0;
+
+            for (const u32 w : words)
+            {
+                count += static_cast<u32>(std::popcount(w));
+            }
+
+            return count;
+        }
+
+        void bitAndScalar(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            for (std::size_t i = 0; i < out.size(); ++i)
+            {
+                out[i] = l[i] & r[i];
+            }
+        }
+
+        void bitOrScalar(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            for (std::size_t i = 0; i < out.size(); ++i)
+            {
+                out[i] = l[i] | r[i];
+            }
+        }
+
+        void bitAndNotScalar(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            for (std::size_t i = 0; i < out.size(); ++i)
+            {
+                out[i] = l[i] & ~r[i];
+            }
+        }
+
+        void extractMemoryMaskScalar(
+            BitWords& out, std::span<const u16, VoxelsPerBrick> values, u16 value)
+        {
+            out.fill(0);
+
+            for (std::size_t i = 0; i < VoxelsPerBrick; ++i)
+            {
+                out[i / 32] |= static_cast<u32>(values[i] == value) << (i % 32);
+            }
+        }
+
+        constexpr KernelTable ScalarKernels {
+            .instruction_set {InstructionSet::Scalar},
+            .is_uniform {isUniformScalar},
+            .is_empty {isEmptyScalar},
+            .is_full {isFullScalar},
+            .popcount {popcountScalar},
+            .bit_and {bitAndScalar},
+            .bit_or {bitOrScalar},
+            .bit_and_not {bitAndNotScalar},
+            .extract_memory_mask {extractMemoryMaskScalar},
+        };
+
+#ifdef VOXEL_KERNELS_X86
+        // Every cpu with avx2 also has popcnt
+        [[gnu::target("popcnt")]] u32 popcountPopcnt(const BitWords& words)
+        {
+            u64 count = 0;
+
+            for (std::size_t i = 0; i < words.size(); i += 2)
+            {
+                count += static_cast<u64>(
+                    _mm_popcnt_u64(u64 {words[i]} | (u64 {words[i + 1]} << 32)));
+            }
+
+            return static_cast<u32>(count);
+        }
+
+        [[gnu::target("avx2")]] __m256i loadAvx2(const void* ptr)
+        {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        }
+
+        [[gnu::target("avx2")]] void storeAvx2(void* ptr, __m256i v)
+        {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), v);
+        }
+
+        [[gnu::target("avx2")]] bool isUniformAvx2(std::span<const u16, VoxelsPerBrick> values)
+        {
+            const __m256i first      = _mm256_set1_epi16(std::bit_cast<i16>(values[0]));
+            __m256i       difference = _mm256_setzero_si256();
+
+            for (std::size_t i = 0; i < VoxelsPerBrick; i += 16)
+            {
+                difference =
+                    _mm256_or_si256(difference, _mm256_xor_si256(loadAvx2(&values[i]), first));
+            }
+
+            return _mm256_testz_si256(difference, difference) != 0;
+        }
+
+        [[gnu::target("avx2")]] bool isEmptyAvx2(const BitWords& words)
+        {
+            const __m256i anySet = _mm256_or_si256(loadAvx2(&words[0]), loadAvx2(&words[8]));
+
+            return _mm256_testz_si256(anySet, anySet) != 0;
+        }
+
+        [[gnu::target("avx2")]] bool isFullAvx2(const BitWords& words)
+        {
+            const __m256i allSet = _mm256_and_si256(loadAvx2(&words[0]), loadAvx2(&words[8]));
+
+            return _mm256_testc_si256(allSet, _mm256_set1_epi32(-1)) != 0;
+        }
+
+        [[gnu::target("avx2")]] void
+        bitAndAvx2(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            storeAvx2(&out[0], _mm256_and_si256(loadAvx2(&l[0]), loadAvx2(&r[0])));
+            storeAvx2(&out[8], _mm256_and_si256(loadAvx2(&l[8]), loadAvx2(&r[8])));
+        }
+
+        [[gnu::target("avx2")]] void bitOrAvx2(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            storeAvx2(&out[0], _mm256_or_si256(loadAvx2(&l[0]), loadAvx2(&r[0])));
+            storeAvx2(&out[8], _mm256_or_si256(loadAvx2(&l[8]), loadAvx2(&r[8])));
+        }
+
+        [[gnu::target("avx2")]] void
+        bitAndNotAvx2(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            // andnot is ~first & second
+            storeAvx2(&out[0], _mm256_andnot_si256(loadAvx2(&r[0]), loadAvx2(&l[0])));
+            storeAvx2(&out[8], _mm256_andnot_si256(loadAvx2(&r[8]), loadAvx2(&l[8])));
+        }
+
+        [[gnu::target("avx2")]] void extractMemoryMaskAvx2(
+            BitWords& out, std::span<const u16, VoxelsPerBrick> values, u16 value)
+        {
+            const __m256i target = _mm256_set1_epi16(std::bit_cast<i16>(value));
+
+            for (std::size_t word = 0; word < out.size(); ++word)
+            {
+                const __m256i low  = _mm256_cmpeq_epi16(loadAvx2(&values[32 * word]), target);
+                const __m256i high =
+                    _mm256_cmpeq_epi16(loadAvx2(&values[(32 * word) + 16]), target);
+
+                // packs works within each 128 bit half, put the quarters back in order
+                const __m256i packed =
+                    _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0b11'01'10'00);
+
+                out[word] = static_cast<u32>(_mm256_movemask_epi8(packed));
+            }
+        }
+
+        constexpr KernelTable Avx2Kernels {
+            .instruction_set {InstructionSet::Avx2},
+            .is_uniform {isUniformAvx2},
+            .is_empty {isEmptyAvx2},
+            .is_full {isFullAvx2},
+            .popcount {popcountPopcnt},
+            .bit_and {bitAndAvx2},
+            .bit_or {bitOrAvx2},
+            .bit_and_not {bitAndNotAvx2},
+            .extract_memory_mask {extractMemoryMaskAvx2},
+        };
+
+        [[gnu::target("avx512f,avx512bw")]] bool
+        isUniformAvx512(std::span<const u16, VoxelsPerBrick> values)
+        {
+            const __m512i first      = _mm512_set1_epi16(std::bit_cast<i16>(values[0]));
+            __m512i       difference = _mm512_setzero_si512();
+
+            for (std::size_t i = 0; i < VoxelsPerBrick; i += 32)
+            {
+                difference = _mm512_or_si512(
+                    difference, _mm512_xor_si512(_mm512_loadu_si512(&values[i]), first));
+            }
+
+            return _mm512_test_epi64_mask(difference, difference) == 0;
+        }
+
+        [[gnu::target("avx512f")]] bool isEmptyAvx512(const BitWords& words)
+        {
+            const __m512i v = _mm512_loadu_si512(words.data());
+
+            return _mm512_test_epi64_mask(v, v) == 0;
+        }
+
+        [[gnu::target("avx512f")]] bool isFullAvx512(const BitWords& words)
+        {
+            return _mm512_cmpneq_epi64_mask(
+                       _mm512_loadu_si512(words.data()), _mm512_set1_epi64(-1))
+                == 0;
+        }
+
+        [[gnu::target("avx512f")]] void
+        bitAndAvx512(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            _mm512_storeu_si512(
+                out.data(),
+                _mm512_and_si512(_mm512_loadu_si512(l.data()), _mm512_loadu_si512(r.data())));
+        }
+
+        [[gnu::target("avx512f")]] void
+        bitOrAvx512(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            _mm512_storeu_si512(
+                out.data(),
+                _mm512_or_si512(_mm512_loadu_si512(l.data()), _mm512_loadu_si512(r.data())));
+        }
+
+        [[gnu::target("avx512f")]] void
+        bitAndNotAvx512(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            // andnot is ~first & second
+            _mm512_storeu_si512(
+                out.data(),
+                _mm512_andnot_si512(_mm512_loadu_si512(r.data()), _mm512_loadu_si512(l.data())));
+        }
+
+        [[gnu::target("avx512f,avx512bw")]] void extractMemoryMaskAvx512(
+            BitWords& out, std::span<const u16, VoxelsPerBrick> values, u16 value)
+        {
+            const __m512i target = _mm512_set1_epi16(std::bit_cast<i16>(value));
+
+            for (std::size_t word = 0; word < out.size(); ++word)
+            {
+                out[word] = static_cast<u32>(
+                    _mm512_cmpeq_epi16_mask(_mm512_loadu_si512(&values[32 * word]), target));
+            }
+        }
+
+        constexpr KernelTable Avx512Kernels {
+            .instruction_set {InstructionSet::Avx512},
+            .is_uniform {isUniformAvx512},
+            .is_empty {isEmptyAvx512},
+            .is_full {isFullAvx512},
+            .popcount {popcountPopcnt},
+            .bit_and {bitAndAvx512},
+            .bit_or {bitOrAvx512},
+            .bit_and_not {bitAndNotAvx512},
+            .extract_memory_mask {extractMemoryMaskAvx512},
+        };
+#endif // VOXEL_KERNELS_X86
+
+#ifdef VOXEL_KERNELS_NEON
+        // Neon is part of the aarch64 baseline, there is nothing to check for at runtime
+
+        bool isUniformNeon(std::span<const u16, VoxelsPerBrick> values)
+        {
+            const uint16x8_t first      = vdupq_n_u16(values[0]);
+            uint16x8_t       difference = vdupq_n_u16(0);
+
+            for (std::size_t i = 0; i < VoxelsPerBrick; i += 8)
+            {
+                difference = vorrq_u16(difference, veorq_u16(vld1q_u16(&values[i]), first));
+            }
+
+            return vmaxvq_u16(difference) == 0;
+        }
+
+        bool isEmptyNeon(const BitWords& words)
+        {
+            uint32x4_t anySet = vdupq_n_u32(0);
+
+            for (std::size_t i = 0; i < words.size(); i += 4)
+            {
+                anySet = vorrq_u32(anySet, vld1q_u32(&words[i]));
+            }
+
+            return vmaxvq_u32(anySet) == 0;
+        }
+
+        bool isFullNeon(const BitWords& words)
+        {
+            uint32x4_t allSet = vdupq_n_u32(~u32 {0});
+
+            for (std::size_t i = 0; i < words.size(); i += 4)
+            {
+                allSet = vandq_u32(allSet, vld1q_u32(&words[i]));
+            }
+
+            return vminvq_u32(allSet) == ~u32 {0};
+        }
+
+        u32 popcountNeon(const BitWords& words)
+        {
+            u32 count = 0;
+
+            // At most 128 bits are set in each 16 bytes, so the sum always fits in a byte
+            for (std::size_t i = 0; i < words.size(); i += 4)
+            {
+                count += vaddvq_u8(vcntq_u8(vreinterpretq_u8_u32(vld1q_u32(&words[i]))));
+            }
+
+            return count;
+        }
+
+        void bitAndNeon(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            for (std::size_t i = 0; i < out.size(); i += 4)
+            {
+                vst1q_u32(&out[i], vandq_u32(vld1q_u32(&l[i]), vld1q_u32(&r[i])));
+            }
+        }
+
+        void bitOrNeon(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            for (std::size_t i = 0; i < out.size(); i += 4)
+            {
+                vst1q_u32(&out[i], vorrq_u32(vld1q_u32(&l[i]), vld1q_u32(&r[i])));
+            }
+        }
+
+        void bitAndNotNeon(BitWords& out, const BitWords& l, const BitWords& r)
+        {
+            for (std::size_t i = 0; i < out.size(); i += 4)
+            {
+                vst1q_u32(&out[i], vbicq_u32(vld1q_u32(&l[i]), vld1q_u32(&r[i])));
+            }
+        }
+
+        void extractMemoryMaskNeon(
+            BitWords& out, std::span<const u16, VoxelsPerBrick> values, u16 value)
+        {
+            static constexpr std::array<u16, 8> LaneBits {1, 2, 4, 8, 16, 32, 64, 128};
+
+            const uint16x8_t target   = vdupq_n_u16(value);
+            const uint16x8_t laneBits = vld1q_u16(LaneBits.data());
+
+            out.fill(0);
+
+            for (std::size_t i = 0; i < VoxelsPerBrick; i += 8)
+            {
+                const uint16x8_t matches =
+                    vandq_u16(vceqq_u16(vld1q_u16(&values[i]), target), laneBits);
+
+                out[i / 32] |= static_cast<u32>(vaddvq_u16(matches)) << (i % 32);
+            }
+        }
+
+        constexpr KernelTable NeonKernels {
+            .instruction_set {InstructionSet::Neon},
+            .is_uniform {isUniformNeon},
+            .is_empty {isEmptyNeon},
+            .is_full {isFullNeon},
+            .popcount {popcountNeon},
+            .bit_and {bitAndNeon},
+            .bit_or {bitOrNeon},
+            .bit_and_not {bitAndNotNeon},
+            .extract_memory_mask {extractMemoryMaskNeon},
+        };
+#endif // VOXEL_KERNELS_NEON
+
+        const KernelTable& getKernelTable(InstructionSet instructionSet)
+        {
+            switch (instructionSet)
+            {
+            case InstructionSet::Scalar:
+                return ScalarKernels;
+#ifdef VOXEL_KERNELS_X86
+            case InstructionSet::Avx2:
+                return Avx2Kernels;
+            case InstructionSet::Avx512:
+                return Avx512Kernels;
+#endif // VOXEL_KERNELS_X86
+#ifdef VOXEL_KERNELS_NEON
+            case InstructionSet::Neon:
+                return NeonKernels;
+#endif // VOXEL_KERNELS_NEON
+            default:
+                util::panic(
+                    "{} brick kernels aren't built for this cpu",
+                    getInstructionSetName(instructionSet));
+            }
+        }
+
+        InstructionSet selectInstructionSet()
+        {
+            for (const InstructionSet i :
+                 {InstructionSet::Avx512, InstructionSet::Avx2, InstructionSet::Neon})
+            {
+                if (isInstructionSetSupported(i))
+                {
+                    return i;
+                }
+            }
+
+            return InstructionSet::Scalar;
+        }
+
+        std::atomic<const KernelTable*> SelectedKernels = nullptr; // NOLINT
+
+        const KernelTable& getKernels()
+        {
+            const KernelTable* kernels = SelectedKernels.load(std::memory_order_acquire);
+
+            if (kernels == nullptr) [[unlikely]]
+            {
+                const KernelTable* selected = &getKernelTable(selectInstructionSet());
+
+                // Whoever gets here first logs, everyone selects the same kernels anyway
+                if (SelectedKernels.compare_exchange_strong(kernels, selected))
+                {
+                    util::logLog(
+                        "Using {} brick kernels", getInstructionSetName(selected->instruction_set));
+
+                    kernels = selected;
+                }
+            }
+
+            return *kernels;
+        }
+    } // namespace
+
+    InstructionSet getInstructionSet()
+    {
+        return getKernels().instruction_set;
+    }
+
+    bool isInstructionSetSupported(InstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+        case InstructionSet::Scalar:
+            return true;
+#ifdef VOXEL_KERNELS_X86
+        case InstructionSet::Avx2:
+            __builtin_cpu_init();
+
+            return __builtin_cpu_supports("avx2");
+        case InstructionSet::Avx512:
+            __builtin_cpu_init();
+
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif // VOXEL_KERNELS_X86
+#ifdef VOXEL_KERNELS_NEON
+        case InstructionSet::Neon:
+            return true;
+#endif // VOXEL_KERNELS_NEON
+        default:
+            return false;
+        }
+    }
+
+    void setInstructionSet(InstructionSet instructionSet)
+    {
+        util::assertFatal(
+            isInstructionSetSupported(instructionSet),
+            "{} brick kernels aren't supported on this cpu",
+            getInstructionSetName(instructionSet));
+
+        SelectedKernels.store(&getKernelTable(instructionSet), std::memory_order_release);
+    }
+
+    const char* getInstructionSetName(InstructionSet instructionSet)
+    {
+        switch (instructionSet)
+        {
+        case InstructionSet::Scalar:
+            return "Scalar";
+        case InstructionSet::Avx2:
+            return "AVX2";
+        case InstructionSet::Avx512:
+            return "AVX-512";
+        case InstructionSet::Neon:
+            return "NEON";
+        default:
+            util::panic(
+                "voxel::kernels::getInstructionSetName passed invalid instruction set | Value: {}",
+                util::toUnderlying(instructionSet));
+        }
+    }
+
+    bool isUniform(std::span<const u16, VoxelsPerBrick> values)
+    {
+        return getKernels().is_uniform(values);
+    }
+
+    bool isEmpty(const BitWords& words)
+    {
+        return getKernels().is_empty(words);
+    }
+
+    bool isFull(const BitWords& words)
+    {
+        return getKernels().is_full(words);
+    }
+
+    u32 popcount(const BitWords& words)
+    {
+        return getKernels().popcount(words);
+    }
+
+    void bitAnd(BitWords& out, const BitWords& l, const BitWords& r)
+    {
+        getKernels().bit_and(out, l, r);
+    }
+
+    void bitOr(BitWords& out, const BitWords& l, const BitWords& r)
+    {
+        getKernels().bit_or(out, l, r);
+    }
+
+    void bitAndNot(BitWords& out, const BitWords& l, const BitWords& r)
+    {
+        getKernels().bit_and_not(out, l, r);
+    }
+
+    void extractMask(BitWords& out, std::span<const u16, VoxelsPerBrick> values, u16 value)
+    {
+        BitWords memoryMask {};
+
+        getKernels().extract_memory_mask(memoryMask, values, value);
+
+        memoryMaskToBitBrick(out, memoryMask);
+    }
+
+    void shift(BitWords& out, const BitWords& in, u32 axis, bool positive)
+    {
+        // Whole slices move along z, rows within a slice along y and bits within a row along x.
+        // This is a handful of u64 ops which every instruction set does just as well.
+        Lanes lanes = toLanes(in);
+
+        switch (axis)
+        {
+        case 0:
+            for (u64& lane : lanes)
+            {
+                // Drop the bits that would otherwise wrap into the next row
+                lane = positive ? (lane << 1) & 0xFEFEFEFEFEFEFEFEULL
+                                : (lane >> 1) & 0x7F7F7F7F7F7F7F7FULL;
+            }
+            break;
+        case 1:
+            for (u64& lane : lanes)
+            {
+                lane = positive ? lane << 8 : lane >> 8;
+            }
+            break;
+        case 2:
+            if (positive)
+            {
+                std::shift_right(lanes.begin(), lanes.end(), 1);
+                lanes.front() = 0;
+            }
+            else
+            {
+                std::shift_left(lanes.begin(), lanes.end(), 1);
+                lanes.back() = 0;
+            }
+            break;
+        default:
+            util::panic("voxel::kernels::shift passed invalid axis | Value: {}", axis);
+        }
+
+        fromLanes(out, lanes);
+    }
+} // namespace voxel::kernels
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "util/misc.hpp"
+#include <array>
+#include <span>
+
+namespace voxel::kernels
+{
+    /// Voxels in a single 8^3 brick
+    static constexpr std::size_t VoxelsPerBrick = 512;
+
+    /// The storage of a BitBrick, bit (x + 8y + 64z) of the brick
+    using BitWords = std::array<u32, VoxelsPerBrick / 32>;
+
+    enum class InstructionSet : u8
+    {
+        Scalar,
+        Avx2,
+        Avx512,
+        Neon,
+    };
+
+    /// Chosen once, on first use, from what the cpu we are running on supports
+    [[nodiscard]] InstructionSet getInstructionSet();
+    [[nodiscard]] const char*    getInstructionSetName(InstructionSet);
+    [[nodiscard]] bool           isInstructionSetSupported(InstructionSet);
+    /// Replaces the chosen kernels with those of a supported instruction set, so that tests and
+    /// benchmarks can compare them. Not meant to be called while kernels are running elsewhere.
+    void                         setInstructionSet(InstructionSet);
+
+    /// Whether every one of the values is the same
+    [[nodiscard]] bool isUniform(std::span<const u16, VoxelsPerBrick> values);
+
+    [[nodiscard]] bool isEmpty(const BitWords&);
+    [[nodiscard]] bool isFull(const BitWords&);
+    [[nodiscard]] u32  popcount(const BitWords&);
+
+    void bitAnd(BitWords& out, const BitWords& l, const BitWords& r);
+    void bitOr(BitWords& out, const BitWords& l, const BitWords& r);
+    /// l & ~r
+    void bitAndNot(BitWords& out, const BitWords& l, const BitWords& r);
+
+    /// Sets the bits of every voxel equal to value. The values are in TypedBrick order, that is
+    /// indexed by gpu_brickLayoutIndex, out is in BitBrick order.
+    void extractMask(BitWords& out, std::span<const u16, VoxelsPerBrick> values, u16 value);
+
+    /// Moves every bit one voxel along axis (0 is x, 1 is y, 2 is z) towards the positive or
+    /// negative side, bits moved out of the brick are dropped and those moved in are 0
+    void shift(BitWords& out, const BitWords& in, u32 axis, bool positive);
+} // namespace voxel::kernels
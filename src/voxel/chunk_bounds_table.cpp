@@ -0,0 +1,207 @@
+#include "chunk_bounds_table.hpp"
+#include "shaders/include/common.glsl"
+#include "util/thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace voxel
+{
+    void ChunkBoundsTable::setBounds(u32 chunkId, ChunkLocation location)
+    {
+        this->ensureCapacity(chunkId);
+
+        const f32 halfWidth = static_cast<f32>(gpu_calculateChunkWidthUnits(location.lod)) / 2.0f;
+
+        this->center_x[chunkId]    = static_cast<f32>(location.root_position.x) + halfWidth;
+        this->center_y[chunkId]    = static_cast<f32>(location.root_position.y) + halfWidth;
+        this->center_z[chunkId]    = static_cast<f32>(location.root_position.z) + halfWidth;
+        this->half_extent[chunkId] = halfWidth;
+
+        this->has_draw_ranges[chunkId] = 0;
+    }
+
+    void ChunkBoundsTable::setDrawRanges(
+        u32                       chunkId,
+        const std::array<u32, 6>& faceOffsets,
+        const std::array<u32, 6>& faceCounts)
+    {
+        this->ensureCapacity(chunkId);
+
+        for (std::size_t normal = 0; normal < 6; ++normal)
+        {
+            this->face_offsets[normal][chunkId] = faceOffsets[normal];
+            this->face_counts[normal][chunkId]  = faceCounts[normal];
+        }
+
+        this->has_draw_ranges[chunkId] = 1;
+    }
+
+    void ChunkBoundsTable::clear(u32 chunkId)
+    {
+        if (chunkId < this->has_draw_ranges.size())
+        {
+            this->has_draw_ranges[chunkId] = 0;
+        }
+    }
+
+    void ChunkBoundsTable::cull(
+        std::span<const glm::vec4, 6> frustumPlanes,
+        glm::vec3                     cameraPosition,
+        std::vector<u8>&              outVisibleDirections) const
+    {
+        outVisibleDirections.resize(this->size());
+
+        this->cullRange(frustumPlanes, cameraPosition, 0, this->size(), outVisibleDirections);
+    }
+
+    void ChunkBoundsTable::cullRange(
+        std::span<const glm::vec4, 6> frustumPlanes,
+        glm::vec3                     cameraPosition,
+        std::size_t                   firstChunk,
+        std::size_t                   lastChunk,
+        std::span<u8>                 outVisibleDirections) const
+    {
+        // Every chunk is a cube, so the furthest corner along a plane's normal is always
+        // sum(abs(normal)) * halfExtent further along it than the center
+        std::array<f32, 6> planeExtentScale {};
+
+        for (std::size_t i = 0; i < 6; ++i)
+        {
+            planeExtentScale[i] = std::abs(frustumPlanes[i].x) + std::abs(frustumPlanes[i].y)
+                                + std::abs(frustumPlanes[i].z);
+        }
+
+        // Branchless over fixed size batches of plain arrays so that this vectorizes
+        for (std::size_t base = firstChunk; base < lastChunk; base += BatchSize)
+        {
+            const f32* cx = &this->center_x[base];
+            const f32* cy = &this->center_y[base];
+            const f32* cz = &this->center_z[base];
+            const f32* he = &this->half_extent[base];
+
+            std::array<u8, BatchSize> isVisible {};
+            std::array<u8, BatchSize> intersectsFrustum {};
+
+            for (std::size_t lane = 0; lane < BatchSize; ++lane)
+            {
+                isVisible[lane] = this->has_draw_ranges[base + lane];
+            }
+
+            for (std::size_t p = 0; p < 6; ++p)
+            {
+                const glm::vec4 plane = frustumPlanes[p];
+                const f32       scale = planeExtentScale[p];
+
+                for (std::size_t lane = 0; lane < BatchSize; ++lane)
+                {
+                    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                    const f32 centerDistance = (plane.x * cx[lane]) + (plane.y * cy[lane])
+                                             + (plane.z * cz[lane]) + plane.w;
+                    const f32 extentDistance = scale * he[lane];
+                    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+                    isVisible[lane] &= static_cast<u8>(centerDistance + extentDistance >= 0.0f);
+                    intersectsFrustum[lane] |=
+                        static_cast<u8>(centerDistance - extentDistance < 0.0f);
+                }
+            }
+
+            for (std::size_t lane = 0; lane < BatchSize; ++lane)
+            {
+                // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                const glm::vec3 center {cx[lane], cy[lane], cz[lane]};
+                const f32       extent = he[lane];
+                // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+                const glm::vec3 min = center - extent;
+                const glm::vec3 max = center + extent;
+
+                // Bit i is VoxelFaceDirection i. Faces facing +axis are never below min and faces
+                // facing -axis are never above max, the camera sees neither from behind that
+                const u8 directions = static_cast<u8>(
+                    (static_cast<u8>(!(cameraPosition.y < min.y)) << 0)   // Top
+                    | (static_cast<u8>(!(cameraPosition.y > max.y)) << 1) // Bottom
+                    | (static_cast<u8>(!(cameraPosition.x > max.x)) << 2) // Left
+                    | (static_cast<u8>(!(cameraPosition.x < min.x)) << 3) // Right
+                    | (static_cast<u8>(!(cameraPosition.z > max.z)) << 4) // Front
+                    | (static_cast<u8>(!(cameraPosition.z < min.z)) << 5) // Back
+                );
+
+                outVisibleDirections[base + lane] =
+                    static_cast<u8>(-isVisible[lane])
+                    & (directions | static_cast<u8>(intersectsFrustum[lane] << 6));
+            }
+        }
+    }
+
+    void ChunkBoundsTable::cullParallel(
+        std::span<const glm::vec4, 6> frustumPlanes,
+        glm::vec3                     cameraPosition,
+        std::vector<u8>&              outVisibleDirections) const
+    {
+        const std::size_t numberOfChunks = this->size();
+
+        outVisibleDirections.resize(numberOfChunks);
+
+        util::parallelFor(
+            (numberOfChunks + ChunksPerTask - 1) / ChunksPerTask,
+            [&](std::size_t task)
+            {
+                this->cullRange(
+                    frustumPlanes,
+                    cameraPosition,
+                    task * ChunksPerTask,
+                    std::min((task + 1) * ChunksPerTask, numberOfChunks),
+                    outVisibleDirections);
+            });
+    }
+
+    std::size_t ChunkBoundsTable::size() const
+    {
+        return this->center_x.size();
+    }
+
+    glm::vec3 ChunkBoundsTable::getCenter(u32 chunkId) const
+    {
+        return glm::vec3 {
+            this->center_x[chunkId], this->center_y[chunkId], this->center_z[chunkId]};
+    }
+
+    f32 ChunkBoundsTable::getHalfExtent(u32 chunkId) const
+    {
+        return this->half_extent[chunkId];
+    }
+
+    u32 ChunkBoundsTable::getFaceOffset(u32 chunkId, u32 normal) const
+    {
+        return this->face_offsets[normal][chunkId];
+    }
+
+    u32 ChunkBoundsTable::getFaceCount(u32 chunkId, u32 normal) const
+    {
+        return this->face_counts[normal][chunkId];
+    }
+
+    void ChunkBoundsTable::ensureCapacity(u32 chunkId)
+    {
+        if (chunkId < this->size())
+        {
+            return;
+        }
+
+        static_assert(GpuChunksPerDataPage % BatchSize == 0);
+        const std::size_t newSize = gpu_calculateChunkDataPageCapacity(chunkId);
+
+        this->center_x.resize(newSize, 0.0f);
+        this->center_y.resize(newSize, 0.0f);
+        this->center_z.resize(newSize, 0.0f);
+        this->half_extent.resize(newSize, 0.0f);
+        this->has_draw_ranges.resize(newSize, 0);
+
+        for (std::size_t normal = 0; normal < 6; ++normal)
+        {
+            this->face_offsets[normal].resize(newSize, 0);
+            this->face_counts[normal].resize(newSize, 0);
+        }
+    }
+} // namespace voxel
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "structures.hpp"
+#include "util/misc.hpp"
+#include <array>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <span>
+#include <vector>
+
+namespace voxel
+{
+    /// Structure of arrays mirror of everything culling needs to know about each chunk, indexed by
+    /// chunk id, so that culling never has to touch PerChunkGpuData or CpuChunkData.
+    class ChunkBoundsTable
+    {
+    public:
+        /// Number of chunks tested at once by cull, the table is always a multiple of this
+        static constexpr std::size_t BatchSize = 8;
+        /// Number of chunks culled by each task of cullParallel
+        static constexpr std::size_t ChunksPerTask = 2048;
+        /// Set by cull alongside the directions of chunks that are only partly inside the frustum
+        static constexpr u8 IntersectsFrustumBit = 1U << 6;
+    public:
+        ChunkBoundsTable() = default;
+
+        /// Called on creation, the chunk won't be drawn until it has draw ranges
+        void setBounds(u32 chunkId, ChunkLocation);
+        void setDrawRanges(
+            u32                       chunkId,
+            const std::array<u32, 6>& faceOffsets,
+            const std::array<u32, 6>& faceCounts);
+        void clear(u32 chunkId);
+
+        /// Writes a mask of the VoxelFaceDirections of each chunk that need to be drawn. Chunks
+        /// without draw ranges or outside the frustum get 0, otherwise a direction is skipped
+        /// when the camera is strictly behind every face in it that the chunk could contain.
+        /// Visible chunks that cross a frustum plane also get IntersectsFrustumBit.
+        void cull(
+            std::span<const glm::vec4, 6> frustumPlanes,
+            glm::vec3                     cameraPosition,
+            std::vector<u8>&              outVisibleDirections) const;
+        /// cull restricted to chunks [firstChunk, lastChunk), both multiples of BatchSize.
+        /// Disjoint ranges may be culled concurrently into an output already of size().
+        void cullRange(
+            std::span<const glm::vec4, 6> frustumPlanes,
+            glm::vec3                     cameraPosition,
+            std::size_t                   firstChunk,
+            std::size_t                   lastChunk,
+            std::span<u8>                 outVisibleDirections) const;
+        /// cull split into ranges of ChunksPerTask across the global thread pool
+        void cullParallel(
+            std::span<const glm::vec4, 6> frustumPlanes,
+            glm::vec3                     cameraPosition,
+            std::vector<u8>&              outVisibleDirections) const;
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] glm::vec3   getCenter(u32 chunkId) const;
+        [[nodiscard]] f32         getHalfExtent(u32 chunkId) const;
+        [[nodiscard]] u32         getFaceOffset(u32 chunkId, u32 normal) const;
+        [[nodiscard]] u32         getFaceCount(u32 chunkId, u32 normal) const;
+
+    private:
+        void ensureCapacity(u32 chunkId);
+
+        std::vector<f32>                center_x;
+        std::vector<f32>                center_y;
+        std::vector<f32>                center_z;
+        std::vector<f32>                half_extent;
+        std::vector<u8>                 has_draw_ranges;
+        std::array<std::vector<u32>, 6> face_offsets;
+        std::array<std::vector<u32>, 6> face_counts;
+    };
+
+    static_assert(ChunkBoundsTable::ChunksPerTask % ChunkBoundsTable::BatchSize == 0);
+} // namespace voxel
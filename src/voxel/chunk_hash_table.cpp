@@ -0,0 +1,210 @@
+#include "chunk_hash_table.hpp"
+#include "util/log.hpp"
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace voxel
+{
+    ChunkHashTable::ChunkHashTable()
+        : keys(GpuChunkHashTableCapacity, Gpu_ChunkLocation {})
+        , values(GpuChunkHashTableCapacity, GpuChunkHashTableEmpty)
+    {}
+
+    bool ChunkHashTable::insert(ChunkLocation location, u32 chunkId)
+    {
+        util::assertFatal(
+            chunkId < (1U << GpuChunkHashTableIdBits), "Chunk id {} is too large", chunkId);
+
+        if (this->wouldExceedMaxProbeLength(location))
+        {
+            return false;
+        }
+
+        Gpu_ChunkLocation carriedKey         = location;
+        u32               carriedId          = chunkId;
+        u32               carriedProbeLength = 0;
+        u32               slot               = gpu_chunkHashTableHomeSlot(location);
+
+        while (true)
+        {
+            const u32 slotValue = this->values[slot];
+
+            if (slotValue == GpuChunkHashTableEmpty)
+            {
+                this->write(
+                    slot, carriedKey, gpu_packChunkHashTableValue(carriedId, carriedProbeLength));
+
+                return true;
+            }
+
+            const u32 slotProbeLength = gpu_unpackChunkHashTableProbeLength(slotValue);
+
+            // Only the original key can already be present, anything displaced is unique
+            if (gpu_isChunkLocationEqual(this->keys[slot], carriedKey))
+            {
+                this->writeValue(slot, gpu_packChunkHashTableValue(carriedId, slotProbeLength));
+
+                return true;
+            }
+
+            // Take from the rich, whoever is closer to home keeps searching
+            if (slotProbeLength < carriedProbeLength)
+            {
+                const Gpu_ChunkLocation displacedKey = this->keys[slot];
+
+                this->write(
+                    slot, carriedKey, gpu_packChunkHashTableValue(carriedId, carriedProbeLength));
+
+                carriedKey         = displacedKey;
+                carriedId          = gpu_unpackChunkHashTableId(slotValue);
+                carriedProbeLength = slotProbeLength;
+            }
+
+            slot = gpu_chunkHashTableNextSlot(slot);
+            carriedProbeLength += 1;
+        }
+    }
+
+    void ChunkHashTable::erase(ChunkLocation location, u32 chunkId)
+    {
+        const std::optional<u32> maybeSlot = this->findSlot(location);
+
+        // A newer chunk at the same location may have already replaced this one
+        if (!maybeSlot.has_value()
+            || gpu_unpackChunkHashTableId(this->values[*maybeSlot]) != chunkId)
+        {
+            return;
+        }
+
+        u32 slot = *maybeSlot;
+
+        while (true)
+        {
+            const u32 nextSlot  = gpu_chunkHashTableNextSlot(slot);
+            const u32 nextValue = this->values[nextSlot];
+
+            if (nextValue == GpuChunkHashTableEmpty
+                || gpu_unpackChunkHashTableProbeLength(nextValue) == 0)
+            {
+                this->writeValue(slot, GpuChunkHashTableEmpty);
+
+                return;
+            }
+
+            this->write(
+                slot,
+                this->keys[nextSlot],
+                gpu_packChunkHashTableValue(
+                    gpu_unpackChunkHashTableId(nextValue),
+                    gpu_unpackChunkHashTableProbeLength(nextValue) - 1));
+
+            slot = nextSlot;
+        }
+    }
+
+    u32 ChunkHashTable::find(ChunkLocation location) const
+    {
+        const std::optional<u32> maybeSlot = this->findSlot(location);
+
+        if (!maybeSlot.has_value())
+        {
+            return GpuChunkHashTableEmpty;
+        }
+
+        return gpu_unpackChunkHashTableId(this->values[*maybeSlot]);
+    }
+
+    std::span<const Gpu_ChunkLocation> ChunkHashTable::getKeys() const
+    {
+        return this->keys;
+    }
+
+    std::span<const u32> ChunkHashTable::getValues() const
+    {
+        return this->values;
+    }
+
+    std::vector<u32> ChunkHashTable::takeChangedSlots()
+    {
+        return std::exchange(this->changed_slots, {});
+    }
+
+    std::optional<u32> ChunkHashTable::findSlot(ChunkLocation location) const
+    {
+        // Mirrors ChunkHashTable_load in voxel_descriptors.glsl
+        u32 slot = gpu_chunkHashTableHomeSlot(location);
+
+        for (u32 probeLength = 0; probeLength < GpuChunkHashTableMaxProbeLength; ++probeLength)
+        {
+            const u32 result = gpu_chunkHashTableProbe(
+                location, probeLength, this->keys[slot], this->values[slot]);
+
+            if (result == GpuChunkHashTableProbeHit)
+            {
+                return slot;
+            }
+            if (result == GpuChunkHashTableProbeMiss)
+            {
+                return std::nullopt;
+            }
+
+            slot = gpu_chunkHashTableNextSlot(slot);
+        }
+
+        return std::nullopt;
+    }
+
+    bool ChunkHashTable::wouldExceedMaxProbeLength(ChunkLocation location) const
+    {
+        // insert without the writes. Past the slot the new key takes, every entry up to the
+        // next empty slot ends up one further from home, so only probe lengths are carried
+        u32  carriedProbeLength = 0;
+        u32  slot               = gpu_chunkHashTableHomeSlot(location);
+        bool isCarryingNewKey   = true;
+
+        while (true)
+        {
+            if (carriedProbeLength >= GpuChunkHashTableMaxProbeLength)
+            {
+                return true;
+            }
+
+            const u32 slotValue = this->values[slot];
+
+            if (slotValue == GpuChunkHashTableEmpty)
+            {
+                return false;
+            }
+
+            if (isCarryingNewKey && gpu_isChunkLocationEqual(this->keys[slot], location))
+            {
+                return false;
+            }
+
+            const u32 slotProbeLength = gpu_unpackChunkHashTableProbeLength(slotValue);
+
+            if (slotProbeLength < carriedProbeLength)
+            {
+                carriedProbeLength = slotProbeLength;
+                isCarryingNewKey   = false;
+            }
+
+            slot = gpu_chunkHashTableNextSlot(slot);
+            carriedProbeLength += 1;
+        }
+    }
+
+    void ChunkHashTable::write(u32 slot, const Gpu_ChunkLocation& key, u32 value)
+    {
+        this->keys[slot] = key;
+        this->writeValue(slot, value);
+    }
+
+    void ChunkHashTable::writeValue(u32 slot, u32 value)
+    {
+        this->values[slot] = value;
+        this->changed_slots.push_back(slot);
+    }
+} // namespace voxel
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "shaders/include/common.glsl"
+#include "structures.hpp"
+#include "util/misc.hpp"
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace voxel
+{
+    /// Cpu copy of the chunk hash table that shaders search with ChunkHashTable_load, slot for
+    /// slot in the same layout. Entries are kept in Robin Hood order and removed by shifting their
+    /// successors back, so there are no tombstones and each change only touches the slots it
+    /// moves. Those are recorded so that only they have to be uploaded.
+    class ChunkHashTable
+    {
+    public:
+        ChunkHashTable();
+
+        /// Maps this location to chunkId, replacing any chunk that was there before. Refuses,
+        /// leaving the table unchanged, if that would move any entry
+        /// GpuChunkHashTableMaxProbeLength or more slots from its home, where lookups give up.
+        [[nodiscard]] bool insert(ChunkLocation, u32 chunkId);
+        /// Removes this location if it still maps to chunkId
+        void               erase(ChunkLocation, u32 chunkId);
+
+        /// Returns GpuChunkHashTableEmpty if the location isn't present
+        [[nodiscard]] u32 find(ChunkLocation) const;
+
+        /// Every slot, the key of an empty slot is meaningless
+        [[nodiscard]] std::span<const Gpu_ChunkLocation> getKeys() const;
+        /// Every slot, each a packed value or GpuChunkHashTableEmpty
+        [[nodiscard]] std::span<const u32>               getValues() const;
+
+        /// Slots written since the last call, in no particular order and possibly repeated
+        [[nodiscard]] std::vector<u32> takeChangedSlots();
+
+    private:
+        [[nodiscard]] std::optional<u32> findSlot(ChunkLocation) const;
+        [[nodiscard]] bool               wouldExceedMaxProbeLength(ChunkLocation) const;
+
+        void write(u32 slot, const Gpu_ChunkLocation& key, u32 value);
+        void writeValue(u32 slot, u32 value);
+
+        std::vector<Gpu_ChunkLocation> keys;
+        std::vector<u32>               values;
+        std::vector<u32>               changed_slots;
+    };
+} // namespace voxel
@@ -0,0 +1,586 @@
+#include "chunk_mesher.hpp"
+#include "material_opacity.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <glm/common.hpp>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace voxel
+{
+    namespace
+    {
+        struct DenseBitChunk
+        {
+            std::array<std::array<u64, VoxelsPerChunkEdge>, VoxelsPerChunkEdge> data;
+
+            static bool isPositionInBounds(glm::i8vec3 p)
+            {
+                return p.x >= 0 && p.x < VoxelsPerChunkEdge && p.y >= 0 && p.y < VoxelsPerChunkEdge
+                    && p.z >= 0 && p.z < VoxelsPerChunkEdge;
+            }
+
+            // returns false on out of bounds access
+            [[nodiscard]] bool isOccupied(glm::i8vec3 p) const
+            {
+                if (p.x < 0 || p.x >= VoxelsPerChunkEdge || p.y < 0 || p.y >= VoxelsPerChunkEdge
+                    || p.z < 0 || p.z >= VoxelsPerChunkEdge)
+                {
+                    return false;
+                }
+                else
+                {
+                    return static_cast<bool>(
+                        this->data[static_cast<std::size_t>(p.x)] // NOLINT
+                                  [static_cast<std::size_t>(p.y)] // NOLINT
+                        & (1ULL << static_cast<u64>(p.z)));
+                }
+            }
+        };
+
+        struct BrickList
+        {
+            std::vector<std::pair<BrickCoordinate, BitBrick>> data;
+
+            void formDenseBitChunk(DenseBitChunk& out) const
+            {
+                out.data = {};
+
+                for (const auto& [bC, thisBrick] : this->data)
+                {
+                    thisBrick.iterateOverVoxels(
+                        [&](BrickLocalPosition bP, bool isFilled)
+                        {
+                            ChunkLocalPosition pos = assembleChunkLocalPosition(bC, bP);
+
+                            if (isFilled)
+                            {
+                                // NOLINTNEXTLINE
+                                out.data[pos.x][pos.y] |= (1ULL << pos.z);
+                            }
+                        });
+                }
+            }
+        };
+
+        // outFaces must start empty
+        void meshChunkGreedy(
+            const DenseBitChunk&                         thisChunkData,
+            std::array<std::vector<GreedyVoxelFace>, 6>& outFaces)
+        {
+            struct ChunkSlice
+            {
+                // width is within each u64, height is the index
+                std::array<u64, 64> data;
+            };
+
+            auto makeChunkSlice = [&](u32 normalId, u64 offset) -> ChunkSlice
+            {
+                VoxelFaceDirection dir = static_cast<VoxelFaceDirection>(normalId);
+                const auto [widthAxis, heightAxis, ascensionAxis] = getDrivingAxes(dir);
+                glm::i8vec3 normal                                = getDirFromDirection(dir);
+
+                ChunkSlice res {}; // NOLINT
+
+                for (i8 h = 0; h < 64; ++h)
+                {
+                    for (i8 w = 0; w < 64; ++w)
+                    {
+                        if (thisChunkData.isOccupied(
+                                w * widthAxis + h * heightAxis
+                                + static_cast<i8>(offset) * ascensionAxis))
+                        {
+                            if (DenseBitChunk::isPositionInBounds(
+                                    w * widthAxis + h * heightAxis
+                                    + static_cast<i8>(offset) * ascensionAxis + normal)
+                                && thisChunkData.isOccupied(
+                                    w * widthAxis + h * heightAxis
+                                    + static_cast<i8>(offset) * ascensionAxis + normal))
+                            {
+                                continue;
+                            }
+                            else
+                            {
+                                // NOLINTNEXTLINE
+                                res.data[static_cast<std::size_t>(h)] |=
+                                    (UINT64_C(1) << static_cast<u64>(w));
+                            }
+                        }
+                    }
+                }
+
+                return res;
+            };
+
+            u32 normalId = 0;
+            for (std::vector<GreedyVoxelFace>& faces : outFaces)
+            {
+                for (u64 ascend = 0; ascend < 64; ++ascend)
+                {
+                    ChunkSlice thisSlice = makeChunkSlice(normalId, ascend);
+
+                    for (u64 height = 0; height < 64; ++height)
+                    {
+                        // NOLINTNEXTLINE
+                        for (u64 width = static_cast<u64>(std::countr_zero(thisSlice.data[height]));
+                             width < 64;
+                             ++width)
+                        {
+                            // NOLINTNEXTLINE
+                            if ((thisSlice.data[height] & (UINT64_C(1) << width)) != 0ULL)
+                            {
+                                const u64 faceWidth = static_cast<u64>(std::countr_one(
+                                    // NOLINTNEXTLINE
+                                    thisSlice.data[height] >> width));
+
+                                VoxelFaceDirection dir = static_cast<VoxelFaceDirection>(normalId);
+                                const auto [widthAxis, heightAxis, ascensionAxis] =
+                                    getDrivingAxes(dir);
+
+                                glm::i8vec3 thisRoot = ascensionAxis * static_cast<i8>(ascend)
+                                                     + heightAxis * static_cast<i8>(height)
+                                                     + widthAxis * static_cast<i8>(width);
+
+                                u64 mask = 0;
+
+                                if (faceWidth == 64)
+                                {
+                                    mask = ~0ULL;
+                                }
+                                else
+                                {
+                                    mask = ((1ULL << faceWidth) - 1ULL) << width;
+                                }
+
+                                u64 faceHeight = 0;
+                                for (u64 h = height; h < 64; ++h)
+                                {
+                                    // NOLINTNEXTLINE
+                                    if ((thisSlice.data[h] & mask) == mask)
+                                    {
+                                        faceHeight += 1;
+                                    }
+                                    else
+                                    {
+                                        break;
+                                    }
+                                }
+
+                                for (u64 h = height; h < (height + faceHeight); ++h)
+                                {
+                                    // NOLINTNEXTLINE
+                                    thisSlice.data[h] &= ~mask;
+                                }
+
+                                faces.push_back(GreedyVoxelFace {
+                                    .x {static_cast<u32>(thisRoot.x)},
+                                    .y {static_cast<u32>(thisRoot.y)},
+                                    .z {static_cast<u32>(thisRoot.z)},
+                                    .width {static_cast<u32>(faceWidth - 1)},
+                                    .height {static_cast<u32>(faceHeight - 1)},
+                                    .pad {0}});
+
+                                width += faceWidth;
+                            }
+                            else
+                            {
+                                // NOLINTNEXTLINE
+                                width += static_cast<u64>(
+                                    std::countr_zero(
+                                        // NOLINTNEXTLINE
+                                        thisSlice.data[height] >> width)
+                                    - 1);
+                            }
+                        }
+                    }
+                }
+
+                normalId += 1;
+            }
+        }
+
+        // Reorders each direction's faces so that those rooted in the same region of the chunk are
+        // contiguous and writes the bounds and face range of each region that has any to
+        // outClusters, which must start empty. scratchFaces is only used for its storage.
+        void clusterGreedyFaces(
+            std::array<std::vector<GreedyVoxelFace>, 6>&   greedyFaces,
+            std::vector<GreedyVoxelFace>&                  scratchFaces,
+            std::array<std::vector<GreedyFaceCluster>, 6>& outClusters)
+        {
+            static constexpr u32 Edge            = GreedyFaceCluster::VoxelsPerFaceClusterEdge;
+            static constexpr u32 E               = VoxelsPerChunkEdge / Edge;
+            static constexpr u32 RegionsPerChunk = E * E * E;
+
+            auto getRegion = [](const GreedyVoxelFace& f) -> u32
+            {
+                return ((f.x / Edge) * E * E) + ((f.y / Edge) * E) + (f.z / Edge);
+            };
+
+            for (u32 normal = 0; normal < 6; ++normal)
+            {
+                std::vector<GreedyVoxelFace>& faces = greedyFaces[normal];
+                const auto [widthAxis, heightAxis, ascensionAxis] =
+                    getDrivingAxes(static_cast<VoxelFaceDirection>(normal));
+
+                // Counting sort, keeps the mesher's order within each region
+                std::array<u32, RegionsPerChunk + 1> regionStarts {};
+
+                for (const GreedyVoxelFace& f : faces)
+                {
+                    regionStarts[getRegion(f) + 1] += 1;
+                }
+
+                std::inclusive_scan(regionStarts.begin(), regionStarts.end(), regionStarts.begin());
+
+                std::array<u32, RegionsPerChunk + 1> regionCursors = regionStarts;
+                std::vector<GreedyVoxelFace>&        sortedFaces   = scratchFaces;
+
+                sortedFaces.resize(faces.size());
+
+                for (const GreedyVoxelFace& f : faces)
+                {
+                    sortedFaces[regionCursors[getRegion(f)]++] = f;
+                }
+
+                for (u32 region = 0; region < RegionsPerChunk; ++region)
+                {
+                    const u32 first = regionStarts[region];
+                    const u32 end   = regionStarts[region + 1];
+
+                    if (first == end)
+                    {
+                        continue;
+                    }
+
+                    glm::u8vec3 min {VoxelsPerChunkEdge - 1};
+                    glm::u8vec3 max {0};
+
+                    for (u32 i = first; i < end; ++i)
+                    {
+                        const GreedyVoxelFace& f = sortedFaces[i];
+                        const glm::u8vec3      root {f.x, f.y, f.z};
+
+                        min = glm::min(min, root);
+                        max = glm::max(
+                            max,
+                            glm::u8vec3 {
+                                root + (glm::u8vec3 {widthAxis} * static_cast<u8>(f.width))
+                                + (glm::u8vec3 {heightAxis} * static_cast<u8>(f.height))});
+                    }
+
+                    outClusters[normal].push_back(GreedyFaceCluster {
+                        .min {min},
+                        .max {max},
+                        .first_face {first},
+                        .number_of_faces {end - first},
+                    });
+                }
+
+                // The old order's storage becomes the next direction's scratch
+                std::swap(faces, sortedFaces);
+            }
+        }
+
+        // Greedily merges every brick that blocks all primary rays into boxes and writes them,
+        // largest first, to occluders which must start empty
+        void findBrickOccluders(
+            const ChunkBrickMap&             brickMap,
+            std::span<const PrimaryRayBrick> primaryRayBricks,
+            std::vector<BrickOccluder>&      occluders)
+        {
+            static constexpr std::size_t MaxOccludersPerChunk = 8;
+            static constexpr std::size_t E                    = BricksPerChunkEdge;
+
+            // [x][y][z]
+            std::array<std::array<std::array<bool, E>, E>, E> isAvailable {};
+
+            brickMap.iterateOverBricks(
+                [&](BrickCoordinate bC, u16 maybeOffset)
+                {
+                    if (maybeOffset != ChunkBrickMap::NullOffset)
+                    {
+                        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+                        isAvailable[bC.x][bC.y][bC.z] = primaryRayBricks[maybeOffset].isFull();
+                    }
+                });
+
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+            auto isBoxAvailable = [&](glm::uvec3 min, glm::uvec3 max)
+            {
+                for (u32 x = min.x; x <= max.x; ++x)
+                {
+                    for (u32 y = min.y; y <= max.y; ++y)
+                    {
+                        for (u32 z = min.z; z <= max.z; ++z)
+                        {
+                            if (!isAvailable[x][y][z])
+                            {
+                                return false;
+                            }
+                        }
+                    }
+                }
+
+                return true;
+            };
+
+            for (u32 z = 0; z < E; ++z)
+            {
+                for (u32 x = 0; x < E; ++x)
+                {
+                    for (u32 y = 0; y < E; ++y)
+                    {
+                        if (!isAvailable[x][y][z])
+                        {
+                            continue;
+                        }
+
+                        glm::uvec3 max {x, y, z};
+
+                        while (max.y + 1 < E && isAvailable[x][max.y + 1][z])
+                        {
+                            max.y += 1;
+                        }
+
+                        while (max.x + 1 < E
+                               && isBoxAvailable({max.x + 1, y, z}, {max.x + 1, max.y, z}))
+                        {
+                            max.x += 1;
+                        }
+
+                        while (max.z + 1 < E
+                               && isBoxAvailable({x, y, max.z + 1}, {max.x, max.y, max.z + 1}))
+                        {
+                            max.z += 1;
+                        }
+
+                        for (u32 bX = x; bX <= max.x; ++bX)
+                        {
+                            for (u32 bY = y; bY <= max.y; ++bY)
+                            {
+                                for (u32 bZ = z; bZ <= max.z; ++bZ)
+                                {
+                                    isAvailable[bX][bY][bZ] = false;
+                                }
+                            }
+                        }
+
+                        occluders.push_back(BrickOccluder {
+                            .min {glm::u8vec3 {x, y, z}}, .max {glm::u8vec3 {max}}});
+                    }
+                }
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+            auto volume = [](const BrickOccluder& o) -> u32
+            {
+                const glm::uvec3 size = glm::uvec3 {o.max} - glm::uvec3 {o.min} + 1U;
+
+                return size.x * size.y * size.z;
+            };
+
+            std::ranges::sort(
+                occluders,
+                [&](const BrickOccluder& l, const BrickOccluder& r)
+                {
+                    return volume(l) > volume(r);
+                });
+
+            if (occluders.size() > MaxOccludersPerChunk)
+            {
+                occluders.resize(MaxOccludersPerChunk);
+            }
+        }
+
+        // Bit 1 << VoxelFaceDirection for each face of the chunk whose bricks all block every
+        // primary ray
+        u8 findSealedFaces(
+            const ChunkBrickMap& brickMap, std::span<const PrimaryRayBrick> primaryRayBricks)
+        {
+            static constexpr u32 BricksPerFace = BricksPerChunkEdge * BricksPerChunkEdge;
+
+            std::array<u32, 6> fullBricksPerFace {};
+
+            brickMap.iterateOverBricks(
+                [&](BrickCoordinate bC, u16 maybeOffset)
+                {
+                    if (maybeOffset == ChunkBrickMap::NullOffset
+                        || !primaryRayBricks[maybeOffset].isFull())
+                    {
+                        return;
+                    }
+
+                    for (u8 face = 0; face < 6; ++face)
+                    {
+                        const glm::ivec3    normal {
+                            getDirFromDirection(static_cast<VoxelFaceDirection>(face))};
+                        const glm::length_t axis  = normal.x != 0 ? 0 : (normal.y != 0 ? 1 : 2);
+                        const i32           layer = normal[axis] > 0 ? BricksPerChunkEdge - 1 : 0;
+
+                        if (glm::ivec3 {bC}[axis] == layer)
+                        {
+                            fullBricksPerFace[face] += 1;
+                        }
+                    }
+                });
+
+            u8 sealedFaces = 0;
+
+            for (u8 face = 0; face < 6; ++face)
+            {
+                if (fullBricksPerFace[face] == BricksPerFace)
+                {
+                    sealedFaces |= static_cast<u8>(1U << face);
+                }
+            }
+
+            return sealedFaces;
+        }
+
+        // Everything a meshing task needs besides its output, kept per worker thread so that
+        // steady state meshing reuses the same memory instead of going to the global allocator
+        struct MeshScratch
+        {
+            BrickList                    list;
+            DenseBitChunk                dense_bit_chunk;
+            std::vector<GreedyVoxelFace> faces;
+            std::vector<PrimaryRayBrick> primary_ray_bricks;
+        };
+    } // namespace
+
+    ChunkAsyncMesh meshChunk(
+        const u32                                  chunkId,
+        const ChunkBrickMap&                       oldBrickMap,
+        const std::span<const MaterialBrick>       oldMaterialBricks,
+        const std::optional<Voxel>                 fill,
+        const std::span<const ChunkLocalUpdate>    newUpdates,
+        const GreedyMeshCache&                     greedyMeshCache,
+        const util::RecyclingPool<ChunkAsyncMesh>& meshPool)
+    {
+        thread_local std::unique_ptr<MeshScratch> maybeScratch {};
+
+        if (maybeScratch == nullptr)
+        {
+            maybeScratch = std::make_unique<MeshScratch>();
+        }
+
+        MeshScratch&   scratch = *maybeScratch;
+        ChunkAsyncMesh out     = meshPool.acquire();
+        out.clear();
+
+        ChunkBrickMap&                       newBrickMap         = out.new_brick_map;
+        std::vector<BrickParentInformation>& newParentBricks     = out.new_parent_bricks;
+        std::vector<MaterialBrick>&          newMaterialBricks   = out.new_material_bricks;
+        std::vector<ShadowBrick>&            newShadowBricks     = out.new_shadow_bricks;
+        std::vector<PrimaryRayBrick>&        newPrimaryRayBricks = scratch.primary_ray_bricks;
+
+        // Bricks are only ever added, so each one's offset is the number that came before it
+        auto allocateBrickOffset = [&]
+        {
+            return static_cast<u16>(newMaterialBricks.size());
+        };
+
+        // A fill replaces every old voxel, filling with air leaves no bricks at all
+        if (fill.has_value() && *fill != Voxel::NullAirEmpty)
+        {
+            MaterialBrick filledBrick {};
+            filledBrick.fill(*fill);
+
+            newBrickMap.iterateOverBricks(
+                [&](BrickCoordinate bC, u16)
+                {
+                    newBrickMap.setOffset(bC, allocateBrickOffset());
+
+                    newParentBricks.push_back(BrickParentInformation {
+                        .parent_chunk {chunkId},
+                        .position_in_parent_chunk {static_cast<u32>(bC.asLinearIndex())}});
+                    newMaterialBricks.push_back(filledBrick);
+                });
+        }
+
+        // Propagate old updates
+        oldBrickMap.iterateOverBricks(
+            [&](BrickCoordinate bC, u16 oldOffset)
+            {
+                if (!fill.has_value() && oldOffset != ChunkBrickMap::NullOffset
+                    && oldMaterialBricks[oldOffset].isSolid()
+                           != Voxel::NullAirEmpty) // TODO: do proper dense
+                                                   // brick things!
+                {
+                    const u16 newOffset = allocateBrickOffset();
+
+                    newBrickMap.setOffset(bC, newOffset);
+
+                    newParentBricks.push_back(BrickParentInformation {
+                        .parent_chunk {chunkId},
+                        .position_in_parent_chunk {static_cast<u32>(bC.asLinearIndex())}});
+                    newMaterialBricks.push_back(oldMaterialBricks[oldOffset]);
+                }
+            });
+
+        for (const ChunkLocalUpdate& newUpdate : newUpdates)
+        {
+            const ChunkLocalPosition updatePosition = newUpdate.getPosition();
+            const Voxel              updateVoxel    = newUpdate.getVoxel();
+
+            const auto [coordinate, local] = splitChunkLocalPosition(updatePosition);
+
+            u16 maybeOffset = newBrickMap.getOffset(coordinate);
+            if (maybeOffset == ChunkBrickMap::NullOffset)
+            {
+                maybeOffset = allocateBrickOffset();
+
+                newBrickMap.setOffset(coordinate, maybeOffset);
+
+                newParentBricks.push_back(BrickParentInformation {
+                    .parent_chunk {chunkId},
+                    .position_in_parent_chunk {static_cast<u32>(coordinate.asLinearIndex())}});
+                newMaterialBricks.push_back(MaterialBrick {});
+            }
+            newMaterialBricks[maybeOffset].write(local, updateVoxel);
+        }
+
+        // Both masks are a pure function of the materials, so they're rederived for every
+        // brick once all of the updates are in rather than being carried and updated
+        newShadowBricks.resize(newMaterialBricks.size());
+        newPrimaryRayBricks.resize(newMaterialBricks.size());
+
+        for (std::size_t i = 0; i < newMaterialBricks.size(); ++i)
+        {
+            deriveBrickMasks(newMaterialBricks[i], newShadowBricks[i], newPrimaryRayBricks[i]);
+        }
+
+        BrickList& list = scratch.list;
+        list.data.clear();
+
+        newBrickMap.iterateOverBricks(
+            [&](BrickCoordinate bC, u16 maybeOffset)
+            {
+                if (maybeOffset != ChunkBrickMap::NullOffset)
+                {
+                    list.data.push_back(
+                        {bC, static_cast<BitBrick>(newPrimaryRayBricks[maybeOffset])});
+                }
+            });
+
+        const GreedyMeshCache::Key meshKey = GreedyMeshCache::hashContents(list.data);
+
+        if (!greedyMeshCache.find(meshKey, out.new_greedy_faces, out.new_face_clusters))
+        {
+            list.formDenseBitChunk(scratch.dense_bit_chunk);
+
+            meshChunkGreedy(scratch.dense_bit_chunk, out.new_greedy_faces);
+            clusterGreedyFaces(out.new_greedy_faces, scratch.faces, out.new_face_clusters);
+
+            greedyMeshCache.insert(meshKey, out.new_greedy_faces, out.new_face_clusters);
+        }
+
+        findBrickOccluders(newBrickMap, newPrimaryRayBricks, out.new_occluders);
+        out.new_sealed_faces = findSealedFaces(newBrickMap, newPrimaryRayBricks);
+
+        return out;
+    }
+} // namespace voxel
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "greedy_mesh_cache.hpp"
+#include "structures.hpp"
+#include "util/misc.hpp"
+#include "util/recycling_pool.hpp"
+#include <optional>
+#include <span>
+
+namespace voxel
+{
+    /// Rebuilds a chunk's bricks from its old ones, a fill that replaces them and then the new
+    /// updates, and meshes the result. The output comes from meshPool and is meant to be
+    /// released back to it once it has been integrated.
+    /// Scratch memory is kept per thread, so once a thread and the pool are warm the only global
+    /// heap allocations are the copies greedyMeshCache keeps of meshes it didn't have yet.
+    [[nodiscard]] ChunkAsyncMesh meshChunk(
+        u32                                        chunkId,
+        const ChunkBrickMap&                       oldBrickMap,
+        std::span<const MaterialBrick>             oldMaterialBricks,
+        std::optional<Voxel>                       fill,
+        std::span<const ChunkLocalUpdate>          newUpdates,
+        const GreedyMeshCache&                     greedyMeshCache,
+        const util::RecyclingPool<ChunkAsyncMesh>& meshPool);
+} // namespace voxel
@@ -0,0 +1,370 @@
+#include "chunk_neighbour_graph.hpp"
+#include "shaders/include/common.glsl"
+#include "util/log.hpp"
+#include <algorithm>
+
+namespace voxel
+{
+    namespace
+    {
+        i64 getChunkWidth(u32 lod)
+        {
+            return static_cast<i64>(gpu_calculateChunkWidthUnits(lod));
+        }
+
+        i64 floorDivide(i64 numerator, i64 denominator)
+        {
+            const i64 quotient = numerator / denominator;
+
+            return (numerator % denominator < 0) ? quotient - 1 : quotient;
+        }
+
+        /// Smallest value that is at least min and a multiple of width plus offset
+        i64 alignUp(i64 min, i64 offset, i64 width)
+        {
+            return offset + (-floorDivide(offset - min, width) * width);
+        }
+
+        /// How far past a chunk's root its probe in a direction is along one axis
+        i64 getProbeOffset(i32 directionComponent, i64 width)
+        {
+            if (directionComponent < 0)
+            {
+                return -1;
+            }
+            else if (directionComponent == 0)
+            {
+                return width / 2;
+            }
+            else
+            {
+                return width;
+            }
+        }
+
+        /// The position just across the middle of the face, edge or corner in this direction
+        glm::ivec3 getProbePosition(ChunkLocation location, glm::ivec3 direction)
+        {
+            const i64  width = getChunkWidth(location.lod);
+            glm::ivec3 probe {};
+
+            for (glm::length_t axis = 0; axis < 3; ++axis)
+            {
+                probe[axis] = static_cast<i32>(
+                    location.root_position[axis] + getProbeOffset(direction[axis], width));
+            }
+
+            return probe;
+        }
+    } // namespace
+
+    void ChunkNeighbourGraph::insert(
+        u32 chunkId, ChunkLocation location, const ChunkHashTable& chunkHashTable)
+    {
+        util::assertFatal(location.lod < MaxLods, "Chunk lod {} is too large", location.lod);
+
+        this->ensureCapacity(chunkId);
+
+        const i64  width = getChunkWidth(location.lod);
+        glm::ivec3 rootOffset {};
+
+        for (glm::length_t axis = 0; axis < 3; ++axis)
+        {
+            const i64 root = location.root_position[axis];
+
+            rootOffset[axis] = static_cast<i32>(root - (floorDivide(root, width) * width));
+        }
+
+        if (this->chunks_per_lod[location.lod] == 0)
+        {
+            this->lod_root_offsets[location.lod] = rootOffset;
+        }
+        else
+        {
+            util::assertFatal(
+                this->lod_root_offsets[location.lod] == rootOffset,
+                "Chunk at {} {} {} isn't aligned with the other chunks of lod {}",
+                location.root_position.x,
+                location.root_position.y,
+                location.root_position.z,
+                location.lod);
+        }
+
+        this->chunks_per_lod[location.lod] += 1;
+        this->locations[chunkId]    = location;
+        this->sealed_faces[chunkId] = 0;
+
+        for (u32 directionIndex = 0; directionIndex < NumberOfDirections; ++directionIndex)
+        {
+            this->links[chunkId][directionIndex] =
+                this->resolveLink(location, getDirection(directionIndex), chunkHashTable);
+        }
+
+        this->relinkAround(location, chunkHashTable);
+    }
+
+    void ChunkNeighbourGraph::erase(u32 chunkId, const ChunkHashTable& chunkHashTable)
+    {
+        const ChunkLocation location = this->locations[chunkId];
+
+        this->links[chunkId].fill(NullChunk);
+        this->sealed_faces[chunkId] = 0;
+        this->chunks_per_lod[location.lod] -= 1;
+
+        this->relinkAround(location, chunkHashTable);
+    }
+
+    u32 ChunkNeighbourGraph::getNeighbour(u32 chunkId, glm::ivec3 direction) const
+    {
+        return this->links[chunkId][getDirectionIndex(direction)];
+    }
+
+    const std::array<u32, ChunkNeighbourGraph::NumberOfDirections>&
+    ChunkNeighbourGraph::getNeighbours(u32 chunkId) const
+    {
+        return this->links[chunkId];
+    }
+
+    void ChunkNeighbourGraph::setSealedFaces(u32 chunkId, u8 sealedFaces)
+    {
+        this->sealed_faces[chunkId] = sealedFaces;
+    }
+
+    u8 ChunkNeighbourGraph::getSealedFaces(u32 chunkId) const
+    {
+        return this->sealed_faces[chunkId];
+    }
+
+    bool ChunkNeighbourGraph::isEnclosedFrom(u32 chunkId, glm::vec3 position) const
+    {
+        const ChunkLocation location = this->locations[chunkId];
+        const i64           width    = getChunkWidth(location.lod);
+        bool                facesAny = false;
+
+        for (u8 face = 0; face < 6; ++face)
+        {
+            const glm::ivec3    normal {getDirFromDirection(static_cast<VoxelFaceDirection>(face))};
+            const glm::length_t normalAxis     = normal.x != 0 ? 0 : (normal.y != 0 ? 1 : 2);
+            const bool          positive       = normal[normalAxis] > 0;
+            const i64           faceCoordinate =
+                location.root_position[normalAxis] + (positive ? width : 0);
+
+            const f32 distanceInFront =
+                positive ? position[normalAxis] - static_cast<f32>(faceCoordinate)
+                         : static_cast<f32>(faceCoordinate) - position[normalAxis];
+
+            if (distanceInFront <= 0.0f)
+            {
+                continue;
+            }
+
+            facesAny = true;
+
+            const u32 neighbourId = this->links[chunkId][getDirectionIndex(normal)];
+
+            if (neighbourId == NullChunk)
+            {
+                return false;
+            }
+
+            const ChunkLocation neighbour      = this->locations[neighbourId];
+            const i64           neighbourWidth = getChunkWidth(neighbour.lod);
+            // Faces are declared in opposing pairs
+            const u32           touchingFace   = face ^ 1U;
+
+            if ((this->sealed_faces[neighbourId] & (1U << touchingFace)) == 0)
+            {
+                return false;
+            }
+
+            // The link is whatever is across the middle of the face, only one at least as large
+            // whose side lies on it covers all of it
+            for (glm::length_t axis = 0; axis < 3; ++axis)
+            {
+                const i64 chunkMin     = location.root_position[axis];
+                const i64 neighbourMin = neighbour.root_position[axis];
+
+                if (axis == normalAxis)
+                {
+                    const i64 touchingCoordinate =
+                        positive ? neighbourMin : neighbourMin + neighbourWidth;
+
+                    if (touchingCoordinate != faceCoordinate)
+                    {
+                        return false;
+                    }
+                }
+                else if (
+                    neighbourMin > chunkMin || neighbourMin + neighbourWidth < chunkMin + width)
+                {
+                    return false;
+                }
+            }
+
+            // From within the sealed bricks the near plane could cut a hole through them
+            const f32 neighbourBrickWidth =
+                static_cast<f32>(neighbourWidth) / static_cast<f32>(BricksPerChunkEdge);
+
+            if (distanceInFront <= 2.0f * neighbourBrickWidth)
+            {
+                return false;
+            }
+        }
+
+        // From inside of the chunk every face faces away
+        return facesAny;
+    }
+
+    glm::ivec3 ChunkNeighbourGraph::getDirection(u32 directionIndex)
+    {
+        // Index into the 3x3x3 cube of offsets, skipping its center
+        const i32 cubeIndex = static_cast<i32>(directionIndex < 13 ? directionIndex
+                                                                   : directionIndex + 1);
+
+        return glm::ivec3 {(cubeIndex % 3) - 1, ((cubeIndex / 3) % 3) - 1, (cubeIndex / 9) - 1};
+    }
+
+    u32 ChunkNeighbourGraph::getDirectionIndex(glm::ivec3 direction)
+    {
+        const u32 cubeIndex =
+            static_cast<u32>((direction.x + 1) + (3 * (direction.y + 1)) + (9 * (direction.z + 1)));
+
+        util::assertFatal(
+            cubeIndex < 27 && cubeIndex != 13,
+            "Invalid neighbour direction {} {} {}",
+            direction.x,
+            direction.y,
+            direction.z);
+
+        return cubeIndex < 13 ? cubeIndex : cubeIndex - 1;
+    }
+
+    u32 ChunkNeighbourGraph::resolveLink(
+        ChunkLocation location, glm::ivec3 direction, const ChunkHashTable& chunkHashTable) const
+    {
+        const glm::ivec3 probe  = getProbePosition(location, direction);
+        const u32        minLod = location.lod - std::min(location.lod, MaxLinkedLodDifference);
+        const u32        maxLod = std::min(location.lod + MaxLinkedLodDifference, MaxLods - 1);
+
+        // Finest first, when lods overlap mid transition the most detailed one wins
+        for (u32 lod = minLod; lod <= maxLod; ++lod)
+        {
+            if (this->chunks_per_lod[lod] == 0)
+            {
+                continue;
+            }
+
+            const glm::ivec3 root = this->getContainingRoot(probe, lod);
+
+            // The probe is outside of this chunk, so only a coarser one could contain both
+            if (lod > location.lod
+                && this->getContainingRoot(location.root_position, lod) == root)
+            {
+                continue;
+            }
+
+            const u32 maybeChunkId = chunkHashTable.find(ChunkLocation {root, lod});
+
+            if (maybeChunkId != GpuChunkHashTableEmpty)
+            {
+                return maybeChunkId;
+            }
+        }
+
+        return NullChunk;
+    }
+
+    void ChunkNeighbourGraph::relinkAround(
+        ChunkLocation region, const ChunkHashTable& chunkHashTable)
+    {
+        const i64 regionWidth = getChunkWidth(region.lod);
+        const u32 minLod      = region.lod - std::min(region.lod, MaxLinkedLodDifference);
+        const u32 maxLod      = std::min(region.lod + MaxLinkedLodDifference, MaxLods - 1);
+
+        for (u32 lod = minLod; lod <= maxLod; ++lod)
+        {
+            if (this->chunks_per_lod[lod] == 0)
+            {
+                continue;
+            }
+
+            const i64 width = getChunkWidth(lod);
+
+            for (u32 directionIndex = 0; directionIndex < NumberOfDirections; ++directionIndex)
+            {
+                const glm::ivec3 direction = getDirection(directionIndex);
+
+                // Along each axis, the roots of the chunks of this lod whose probe in this
+                // direction lands inside of the region
+                std::array<i64, 3> firstRoot {};
+                std::array<i64, 3> lastRoot {};
+
+                for (glm::length_t axis = 0; axis < 3; ++axis)
+                {
+                    const i64 regionMin   = region.root_position[axis];
+                    const i64 probeOffset = getProbeOffset(direction[axis], width);
+
+                    firstRoot[static_cast<std::size_t>(axis)] = alignUp(
+                        regionMin - probeOffset, this->lod_root_offsets[lod][axis], width);
+                    lastRoot[static_cast<std::size_t>(axis)] =
+                        regionMin + regionWidth - 1 - probeOffset;
+                }
+
+                for (i64 x = firstRoot[0]; x <= lastRoot[0]; x += width)
+                {
+                    for (i64 y = firstRoot[1]; y <= lastRoot[1]; y += width)
+                    {
+                        for (i64 z = firstRoot[2]; z <= lastRoot[2]; z += width)
+                        {
+                            const ChunkLocation candidate {
+                                glm::ivec3 {
+                                    static_cast<i32>(x), static_cast<i32>(y), static_cast<i32>(z)},
+                                lod};
+
+                            const u32 maybeChunkId = chunkHashTable.find(candidate);
+
+                            if (maybeChunkId != GpuChunkHashTableEmpty)
+                            {
+                                this->links[maybeChunkId][directionIndex] =
+                                    this->resolveLink(candidate, direction, chunkHashTable);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    glm::ivec3 ChunkNeighbourGraph::getContainingRoot(glm::ivec3 position, u32 lod) const
+    {
+        const i64  width = getChunkWidth(lod);
+        glm::ivec3 root {};
+
+        for (glm::length_t axis = 0; axis < 3; ++axis)
+        {
+            const i64 offset = this->lod_root_offsets[lod][axis];
+
+            root[axis] =
+                static_cast<i32>(offset + (floorDivide(position[axis] - offset, width) * width));
+        }
+
+        return root;
+    }
+
+    void ChunkNeighbourGraph::ensureCapacity(u32 chunkId)
+    {
+        if (chunkId < this->links.size())
+        {
+            return;
+        }
+
+        const std::size_t newSize = gpu_calculateChunkDataPageCapacity(chunkId);
+
+        std::array<u32, NumberOfDirections> noLinks {};
+        noLinks.fill(NullChunk);
+
+        this->links.resize(newSize, noLinks);
+        this->locations.resize(newSize, ChunkLocation {});
+        this->sealed_faces.resize(newSize, 0);
+    }
+} // namespace voxel
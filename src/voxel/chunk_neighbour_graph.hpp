@@ -0,0 +1,73 @@
+#pragma once
+
+#include "chunk_hash_table.hpp"
+#include "structures.hpp"
+#include "util/misc.hpp"
+#include <array>
+#include <glm/vec3.hpp>
+#include <vector>
+
+namespace voxel
+{
+    /// Links from each chunk, indexed by chunk id, to the chunks touching its 6 faces, 12 edges
+    /// and 8 corners, so that cpu code working across chunk boundaries never has to hash a
+    /// ChunkLocation to find a neighbour.
+    /// The link in a direction is the finest chunk containing the point just across the middle of
+    /// that face, edge or corner. Where the neighbours are finer that is the one at the middle,
+    /// the rest are reachable through its own links. Chunks containing the chunk itself and
+    /// chunks more than MaxLinkedLodDifference lods apart are never linked, which bounds how
+    /// many chunks each insert or erase has to relink.
+    class ChunkNeighbourGraph
+    {
+    public:
+        static constexpr u32 NumberOfDirections     = 26;
+        static constexpr u32 NullChunk              = ~u32 {0};
+        static constexpr u32 MaxLinkedLodDifference = 3;
+        // Chunks of the last lod are 1 << 30 units wide, any wider can't be rooted by an i32
+        static constexpr u32 MaxLods                = 25;
+    public:
+        ChunkNeighbourGraph() = default;
+
+        /// Links the chunk and relinks its neighbours, the chunk must already be in the table
+        void insert(u32 chunkId, ChunkLocation, const ChunkHashTable&);
+        /// Unlinks the chunk and relinks its neighbours, the chunk must already be erased from
+        /// the table
+        void erase(u32 chunkId, const ChunkHashTable&);
+
+        /// NullChunk if nothing is linked in that direction
+        [[nodiscard]] u32 getNeighbour(u32 chunkId, glm::ivec3 direction) const;
+        [[nodiscard]] const std::array<u32, NumberOfDirections>& getNeighbours(u32 chunkId) const;
+
+        /// Bit 1 << VoxelFaceDirection is set if every brick on that face of the chunk blocks
+        /// all rays, inserted chunks start with none
+        void             setSealedFaces(u32 chunkId, u8 sealedFaces);
+        [[nodiscard]] u8 getSealedFaces(u32 chunkId) const;
+
+        /// Whether every face of the chunk that faces the position is entirely covered by a
+        /// linked neighbour's sealed face, in which case nothing in the chunk can be seen from it
+        [[nodiscard]] bool isEnclosedFrom(u32 chunkId, glm::vec3 position) const;
+
+        /// Every component is -1, 0 or 1 and they are never all 0
+        [[nodiscard]] static glm::ivec3 getDirection(u32 directionIndex);
+        [[nodiscard]] static u32        getDirectionIndex(glm::ivec3 direction);
+
+    private:
+        [[nodiscard]] u32
+        resolveLink(ChunkLocation, glm::ivec3 direction, const ChunkHashTable&) const;
+        /// Re-resolves every link of other chunks that may point into this region
+        void relinkAround(ChunkLocation, const ChunkHashTable&);
+
+        /// Root of the chunk of this lod containing the position, if there could be one
+        [[nodiscard]] glm::ivec3 getContainingRoot(glm::ivec3 position, u32 lod) const;
+
+        void ensureCapacity(u32 chunkId);
+
+        std::vector<std::array<u32, NumberOfDirections>> links;
+        std::vector<ChunkLocation>                       locations;
+        std::vector<u8>                                  sealed_faces;
+
+        std::array<u32, MaxLods>        chunks_per_lod {};
+        // Chunks of a lod are rooted at multiples of its width plus this
+        std::array<glm::ivec3, MaxLods> lod_root_offsets {};
+    };
+} // namespace voxel
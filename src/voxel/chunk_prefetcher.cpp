@@ -0,0 +1,121 @@
+#include "chunk_prefetcher.hpp"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <unordered_set>
+
+namespace voxel
+{
+    ChunkPrefetcher::ChunkPrefetcher(
+        world::WorldGenerator* worldGenerator, std::size_t numberOfWorkers)
+        : generator {worldGenerator}
+        , prefetches {Prefetches {
+              .targeted {},
+              .retained {util::LruCache<voxel::ChunkLocation, PrefetchedChunk> {
+                  MaxRetainedPrefetches}}}}
+        , pool {numberOfWorkers}
+    {}
+
+    ChunkPrefetcher::~ChunkPrefetcher()
+    {
+        // Make the pool's shutdown drain instantly
+        this->setPrefetchTargets({});
+    }
+
+    void ChunkPrefetcher::setPrefetchTargets(std::span<const voxel::ChunkLocation> targets)
+    {
+        const std::unordered_set<voxel::ChunkLocation> targetSet {targets.begin(), targets.end()};
+
+        this->prefetches.lock(
+            [&](Prefetches& p)
+            {
+                for (auto it = p.targeted.begin(); it != p.targeted.end();)
+                {
+                    if (targetSet.contains(it->first))
+                    {
+                        ++it;
+                        continue;
+                    }
+
+                    PendingPrefetch& prefetch = it->second;
+
+                    // Nothing can stop a started generation, so don't throw its work away
+                    if (prefetch.has_been_claimed->exchange(true, std::memory_order_acq_rel))
+                    {
+                        p.retained.insert(it->first, std::move(prefetch.chunk), 1);
+                    }
+                    else
+                    {
+                        prefetch.chunk.should_still_generate->store(
+                            false, std::memory_order_release);
+                    }
+
+                    it = p.targeted.erase(it);
+                }
+
+                for (const voxel::ChunkLocation& location : targets)
+                {
+                    // Looking up a retained prefetch also keeps it from being evicted
+                    if (p.targeted.contains(location) || p.retained.find(location) != nullptr)
+                    {
+                        continue;
+                    }
+
+                    std::shared_ptr<std::atomic_bool> shouldStillGenerate =
+                        std::make_shared<std::atomic_bool>(true);
+                    std::shared_ptr<std::atomic_bool> hasBeenClaimed =
+                        std::make_shared<std::atomic_bool>(false);
+
+                    std::future<world::GeneratedChunk> updates = this->pool.executeOnPool(
+                        [wg = this->generator, location, shouldStillGenerate, hasBeenClaimed]
+                        -> world::GeneratedChunk
+                        {
+                            if (hasBeenClaimed->exchange(true, std::memory_order_acq_rel)
+                                || !shouldStillGenerate->load(std::memory_order_acquire))
+                            {
+                                return {};
+                            }
+
+                            return wg->generateChunk(location);
+                        });
+
+                    p.targeted.insert(
+                        {location,
+                         PendingPrefetch {
+                             .chunk {PrefetchedChunk {
+                                 .should_still_generate {std::move(shouldStillGenerate)},
+                                 .updates {std::move(updates)}}},
+                             .has_been_claimed {std::move(hasBeenClaimed)}}});
+                }
+            });
+    }
+
+    std::optional<ChunkPrefetcher::PrefetchedChunk>
+    ChunkPrefetcher::take(voxel::ChunkLocation location)
+    {
+        return this->prefetches.lock(
+            [&](Prefetches& p) -> std::optional<PrefetchedChunk>
+            {
+                const auto maybePrefetch = p.targeted.find(location);
+
+                if (maybePrefetch == p.targeted.end())
+                {
+                    return p.retained.take(location);
+                }
+
+                PendingPrefetch prefetch = std::move(maybePrefetch->second);
+                p.targeted.erase(maybePrefetch);
+
+                // We got to it before any worker did, the caller is better off generating it
+                // on the normal priority pool
+                if (!prefetch.has_been_claimed->exchange(true, std::memory_order_acq_rel))
+                {
+                    prefetch.chunk.should_still_generate->store(false, std::memory_order_release);
+
+                    return std::nullopt;
+                }
+
+                return std::move(prefetch.chunk);
+            });
+    }
+} // namespace voxel
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "util/lru_cache.hpp"
+#include "util/thread_pool.hpp"
+#include "util/threads.hpp"
+#include "voxel/structures.hpp"
+#include "world/generator.hpp"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace voxel
+{
+    /// Speculatively generates chunks that are expected to be needed soon on its own small pool
+    /// so that it never competes with chunks that are needed now.
+    class ChunkPrefetcher
+    {
+    public:
+        struct PrefetchedChunk
+        {
+            std::shared_ptr<std::atomic_bool>  should_still_generate;
+            std::future<world::GeneratedChunk> updates;
+        };
+    public:
+        explicit ChunkPrefetcher(world::WorldGenerator*, std::size_t numberOfWorkers = 1);
+        ~ChunkPrefetcher();
+
+        ChunkPrefetcher(const ChunkPrefetcher&)             = delete;
+        ChunkPrefetcher(ChunkPrefetcher&&)                  = delete;
+        ChunkPrefetcher& operator= (const ChunkPrefetcher&) = delete;
+        ChunkPrefetcher& operator= (ChunkPrefetcher&&)      = delete;
+
+        /// Replaces the set of locations being prefetched. Anything previously requested that
+        /// isn't in this set and hasn't started yet is cancelled, prefetches that already
+        /// started are kept around in case the prediction comes back to them.
+        void setPrefetchTargets(std::span<const voxel::ChunkLocation>);
+
+        /// Claims the prefetched generation of this location, if there is one that has already
+        /// started. Prefetches that were still queued are cancelled instead, as they would be
+        /// stuck behind the rest of the low priority work.
+        [[nodiscard]] std::optional<PrefetchedChunk> take(voxel::ChunkLocation);
+
+    private:
+        // Upper bound on the number of started prefetches kept after they stop being targeted
+        static constexpr std::size_t MaxRetainedPrefetches = 1024;
+
+        struct PendingPrefetch
+        {
+            PrefetchedChunk                   chunk;
+            // set by whichever of the worker or take() gets to this prefetch first
+            std::shared_ptr<std::atomic_bool> has_been_claimed;
+        };
+
+        struct Prefetches
+        {
+            std::unordered_map<voxel::ChunkLocation, PendingPrefetch> targeted;
+            // Started by a worker but no longer targeted, each costs 1
+            util::LruCache<voxel::ChunkLocation, PrefetchedChunk>     retained;
+        };
+
+        world::WorldGenerator*  generator;
+        util::Mutex<Prefetches> prefetches;
+        util::ThreadPool        pool;
+    };
+} // namespace voxel
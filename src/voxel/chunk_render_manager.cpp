@@ -8,22 +8,27 @@
 #include "gfx/window.hpp"
 #include "shaders/include/common.glsl"
 #include "structures.hpp"
-#include "util/index_allocator.hpp"
 #include "util/log.hpp"
 #include "util/range_allocator.hpp"
 #include "util/static_filesystem.hpp"
 #include "util/thread_pool.hpp"
-#include "util/timer.hpp"
+#include "voxel/chunk_mesher.hpp"
 #include "voxel/material_manager.hpp"
+#include <algorithm>
 #include <atomic>
 #include <boost/dynamic_bitset/dynamic_bitset.hpp>
+#include <format>
+#include <functional>
 #include <future>
 #include <glm/geometric.hpp>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <ranges>
 #include <source_location>
+#include <utility>
 #include <vulkan/vulkan_enums.hpp>
+#include <vk_mem_alloc.h>
 #include <vulkan/vulkan_structs.hpp>
 
 namespace voxel
@@ -32,320 +37,64 @@ namespace voxel
     namespace
     {
 
-        struct DenseBitChunk
+        [[nodiscard]] bool
+        isBoxInFrustum(std::span<const glm::vec4, 6> frustumPlanes, glm::vec3 min, glm::vec3 max)
         {
-            std::array<std::array<u64, VoxelsPerChunkEdge>, VoxelsPerChunkEdge> data;
-
-            static bool isPositionInBounds(glm::i8vec3 p)
+            for (const glm::vec4& plane : frustumPlanes)
             {
-                return p.x >= 0 && p.x < VoxelsPerChunkEdge && p.y >= 0 && p.y < VoxelsPerChunkEdge
-                    && p.z >= 0 && p.z < VoxelsPerChunkEdge;
-            }
+                const glm::vec3 furthestCorner {
+                    plane.x >= 0.0f ? max.x : min.x,
+                    plane.y >= 0.0f ? max.y : min.y,
+                    plane.z >= 0.0f ? max.z : min.z,
+                };
 
-            // returns false on out of bounds access
-            [[nodiscard]] bool isOccupied(glm::i8vec3 p) const
-            {
-                if (p.x < 0 || p.x >= VoxelsPerChunkEdge || p.y < 0 || p.y >= VoxelsPerChunkEdge
-                    || p.z < 0 || p.z >= VoxelsPerChunkEdge)
+                if (glm::dot(glm::vec3 {plane}, furthestCorner) + plane.w < 0.0f)
                 {
                     return false;
                 }
-                else
-                {
-                    return static_cast<bool>(
-                        this->data[static_cast<std::size_t>(p.x)] // NOLINT
-                                  [static_cast<std::size_t>(p.y)] // NOLINT
-                        & (1ULL << static_cast<u64>(p.z)));
-                }
             }
-        };
-
-        struct BrickList
-        {
-            std::vector<std::pair<BrickCoordinate, BitBrick>> data;
-
-            [[nodiscard]] std::unique_ptr<DenseBitChunk> formDenseBitChunk() const
-            {
-                std::unique_ptr<DenseBitChunk> out = std::make_unique<DenseBitChunk>();
-
-                for (const auto& [bC, thisBrick] : this->data)
-                {
-                    thisBrick.iterateOverVoxels(
-                        [&](BrickLocalPosition bP, bool isFilled)
-                        {
-                            ChunkLocalPosition pos = assembleChunkLocalPosition(bC, bP);
 
-                            if (isFilled)
-                            {
-                                // NOLINTNEXTLINE
-                                out->data[pos.x][pos.y] |= (1ULL << pos.z);
-                            }
-                        });
-                }
-
-                return out;
-            }
-        };
-
-        std::array<std::vector<GreedyVoxelFace>, 6>
-        meshChunkGreedy(std::unique_ptr<DenseBitChunk> thisChunkData) // NOLINT
-        {
-            std::array<std::vector<GreedyVoxelFace>, 6> outFaces {};
-
-            struct ChunkSlice
-            {
-                // width is within each u64, height is the index
-                std::array<u64, 64> data;
-            };
-
-            auto makeChunkSlice = [&](u32 normalId, u64 offset) -> ChunkSlice
-            {
-                VoxelFaceDirection dir = static_cast<VoxelFaceDirection>(normalId);
-                const auto [widthAxis, heightAxis, ascensionAxis] = getDrivingAxes(dir);
-                glm::i8vec3 normal                                = getDirFromDirection(dir);
-
-                ChunkSlice res {}; // NOLINT
-
-                for (i8 h = 0; h < 64; ++h)
-                {
-                    for (i8 w = 0; w < 64; ++w)
-                    {
-                        if (thisChunkData->isOccupied(
-                                w * widthAxis + h * heightAxis
-                                + static_cast<i8>(offset) * ascensionAxis))
-                        {
-                            if (DenseBitChunk::isPositionInBounds(
-                                    w * widthAxis + h * heightAxis
-                                    + static_cast<i8>(offset) * ascensionAxis + normal)
-                                && thisChunkData->isOccupied(
-                                    w * widthAxis + h * heightAxis
-                                    + static_cast<i8>(offset) * ascensionAxis + normal))
-                            {
-                                continue;
-                            }
-                            else
-                            {
-                                // NOLINTNEXTLINE
-                                res.data[static_cast<std::size_t>(h)] |=
-                                    (UINT64_C(1) << static_cast<u64>(w));
-                            }
-                        }
-                    }
-                }
-
-                return res;
-            };
-
-            u32 normalId = 0;
-            for (std::vector<GreedyVoxelFace>& faces : outFaces)
-            {
-                for (u64 ascend = 0; ascend < 64; ++ascend)
-                {
-                    ChunkSlice thisSlice = makeChunkSlice(normalId, ascend);
-
-                    for (u64 height = 0; height < 64; ++height)
-                    {
-                        // NOLINTNEXTLINE
-                        for (u64 width = static_cast<u64>(std::countr_zero(thisSlice.data[height]));
-                             width < 64;
-                             ++width)
-                        {
-                            // NOLINTNEXTLINE
-                            if ((thisSlice.data[height] & (UINT64_C(1) << width)) != 0ULL)
-                            {
-                                const u64 faceWidth = static_cast<u64>(std::countr_one(
-                                    // NOLINTNEXTLINE
-                                    thisSlice.data[height] >> width));
-
-                                VoxelFaceDirection dir = static_cast<VoxelFaceDirection>(normalId);
-                                const auto [widthAxis, heightAxis, ascensionAxis] =
-                                    getDrivingAxes(dir);
-
-                                glm::i8vec3 thisRoot = ascensionAxis * static_cast<i8>(ascend)
-                                                     + heightAxis * static_cast<i8>(height)
-                                                     + widthAxis * static_cast<i8>(width);
-
-                                u64 mask = 0;
-
-                                if (faceWidth == 64)
-                                {
-                                    mask = ~0ULL;
-                                }
-                                else
-                                {
-                                    mask = ((1ULL << faceWidth) - 1ULL) << width;
-                                }
-
-                                u64 faceHeight = 0;
-                                for (u64 h = height; h < 64; ++h)
-                                {
-                                    // NOLINTNEXTLINE
-                                    if ((thisSlice.data[h] & mask) == mask)
-                                    {
-                                        faceHeight += 1;
-                                    }
-                                    else
-                                    {
-                                        break;
-                                    }
-                                }
-
-                                for (u64 h = height; h < (height + faceHeight); ++h)
-                                {
-                                    // NOLINTNEXTLINE
-                                    thisSlice.data[h] &= ~mask;
-                                }
-
-                                faces.push_back(GreedyVoxelFace {
-                                    .x {static_cast<u32>(thisRoot.x)},
-                                    .y {static_cast<u32>(thisRoot.y)},
-                                    .z {static_cast<u32>(thisRoot.z)},
-                                    .width {static_cast<u32>(faceWidth - 1)},
-                                    .height {static_cast<u32>(faceHeight - 1)},
-                                    .pad {0}});
-
-                                width += faceWidth;
-                            }
-                            else
-                            {
-                                // NOLINTNEXTLINE
-                                width += static_cast<u64>(
-                                    std::countr_zero(
-                                        // NOLINTNEXTLINE
-                                        thisSlice.data[height] >> width)
-                                    - 1);
-                            }
-                        }
-                    }
-                }
-
-                normalId += 1;
-            }
-
-            return outFaces;
+            return true;
         }
 
-        [[nodiscard]] ChunkAsyncMesh doMesh(
-            const u16                              chunkId,
-            const PerChunkGpuData                  oldGpuData,
-            const std::span<const MaterialBrick>   oldMaterialBricks,
-            const std::span<const ShadowBrick>     oldShadowBricks,
-            const std::span<const PrimaryRayBrick> oldPrimaryRayBricks,
-            // NOLINTNEXTLINE(performance-unnecessary-value-param) lifetimes exist
-            const std::vector<ChunkLocalUpdate>    newUpdates)
+        [[nodiscard]] f32 getDistanceToBox(glm::vec3 point, glm::vec3 min, glm::vec3 max)
         {
-            util::MultiTimer t {};
-
-            util::IndexAllocator newChunkOffsetAllocator {
-                BricksPerChunkEdge * BricksPerChunkEdge * BricksPerChunkEdge};
-            ChunkBrickMap                       newBrickMap {};
-            std::vector<BrickParentInformation> newParentBricks {};
-            std::vector<MaterialBrick>          newMaterialBricks {};
-            std::vector<ShadowBrick>            newShadowBricks {};
-            std::vector<PrimaryRayBrick>        newPrimaryRayBricks {};
-
-            // Propagate old updates
-            oldGpuData.data.iterateOverBricks(
-                [&](BrickCoordinate bC, u16 oldOffset)
-                {
-                    if (oldOffset != ChunkBrickMap::NullOffset
-                        && oldMaterialBricks[oldOffset].isSolid()
-                               != Voxel::NullAirEmpty) // TODO: do proper dense
-                                                       // brick things!
-                    {
-                        const u16 newOffset =
-                            static_cast<u16>(newChunkOffsetAllocator.allocateOrPanic());
-
-                        newBrickMap.setOffset(bC, newOffset);
-
-                        newParentBricks.push_back(BrickParentInformation {
-                            .parent_chunk {chunkId},
-                            .position_in_parent_chunk {static_cast<u32>(bC.asLinearIndex())}});
-                        newMaterialBricks.push_back(oldMaterialBricks[oldOffset]);
-                        newShadowBricks.push_back(oldShadowBricks[oldOffset]);
-                        newPrimaryRayBricks.push_back(oldPrimaryRayBricks[oldOffset]);
-                    }
-                });
-
-            t.stamp("propagate old updates");
-
-            for (const ChunkLocalUpdate& newUpdate : newUpdates)
-            {
-                const ChunkLocalPosition             updatePosition = newUpdate.getPosition();
-                const Voxel                          updateVoxel    = newUpdate.getVoxel();
-                const ChunkLocalUpdate::ShadowUpdate shadowUpdate   = newUpdate.getShadowUpdate();
-                const ChunkLocalUpdate::CameraVisibleUpdate cameraVisibilityUpdate =
-                    newUpdate.getCameraVisibility();
-
-                const auto [coordinate, local] = splitChunkLocalPosition(updatePosition);
-
-                u16 maybeOffset = newBrickMap.getOffset(coordinate);
-                if (maybeOffset == ChunkBrickMap::NullOffset)
-                {
-                    maybeOffset = static_cast<u16>(newChunkOffsetAllocator.allocateOrPanic());
-
-                    newBrickMap.setOffset(coordinate, maybeOffset);
-
-                    newParentBricks.push_back(BrickParentInformation {
-                        .parent_chunk {chunkId},
-                        .position_in_parent_chunk {static_cast<u32>(coordinate.asLinearIndex())}});
-                    newMaterialBricks.push_back(MaterialBrick {});
-                    newShadowBricks.push_back(ShadowBrick {});
-                    newPrimaryRayBricks.push_back(PrimaryRayBrick {});
-                }
-                newMaterialBricks[maybeOffset].write(local, updateVoxel);
-                newShadowBricks[maybeOffset].write(local, static_cast<bool>(shadowUpdate));
-                newPrimaryRayBricks[maybeOffset].write(
-                    local, static_cast<bool>(cameraVisibilityUpdate));
-            }
-
-            t.stamp("propagate new updates");
-
-            BrickList list {};
-
-            newBrickMap.iterateOverBricks(
-                [&](BrickCoordinate bC, u16 maybeOffset)
-                {
-                    if (maybeOffset != ChunkBrickMap::NullOffset)
-                    {
-                        list.data.push_back(
-                            {bC, static_cast<BitBrick>(newPrimaryRayBricks[maybeOffset])});
-                    }
-                });
-            t.stamp("form brick list");
-
-            std::unique_ptr<DenseBitChunk> denseBitChunk {list.formDenseBitChunk()};
-
-            t.stamp("Generate dense bit chunk");
+            return glm::distance(point, glm::clamp(point, min, max));
+        }
 
-            std::array<std::vector<GreedyVoxelFace>, 6> newGreedyFaces =
-                meshChunkGreedy(std::move(denseBitChunk));
+        // Distance buckets that draws are sorted into, logarithmic so that the nearest draws,
+        // which cover the most of the screen, are the most finely ordered
+        constexpr u32 NumberOfDrawDistanceBuckets = 256;
 
-            t.stamp("mesh chunk greedily");
+        [[nodiscard]] u32 getDrawDistanceBucket(f32 distance)
+        {
+            static constexpr f32 BucketsPerDoubling = 16.0f;
 
-            std::ignore = t.finish();
+            const f32 bucket = std::log2(1.0f + distance) * BucketsPerDoubling;
 
-            return ChunkAsyncMesh {
-                .new_brick_map {newBrickMap},
-                .new_parent_bricks {std::move(newParentBricks)},
-                .new_material_bricks {std::move(newMaterialBricks)},
-                .new_shadow_bricks {std::move(newShadowBricks)},
-                .new_primary_ray_bricks {std::move(newPrimaryRayBricks)},
-                .new_greedy_faces {std::move(newGreedyFaces)}};
+            return static_cast<u32>(std::min(bucket, f32 {NumberOfDrawDistanceBuckets - 1}));
         }
 
     } // namespace
 
-    static constexpr u32 MaxChunks          = 65534; // max of u16, chunk ids are u16s, null is ~0
-    static constexpr u32 MaxChunkHashNodes  = 1U << 16U;
     static constexpr u32 DirectionsPerChunk = 6;
-    static constexpr u32 MaxBricks          = 1U << 20U; // FIXED(shader bound)
-    static constexpr u32 MaxFaces           = 1U << 23U; // FIXED(shader bound)
+    // Visible faces are found through the face id map, so there are never more than its nodes
     static constexpr u32 MaxFaceIdHashNodes = 1U << 23U; // FIXED(shader bound)
     static constexpr u32 MaxLights          = 4096;
+    // Partially visible runs beyond this draw their whole directions instead
+    static constexpr u32 MaxExplicitChunkDraws = 1U << 16U;
+    // Chunks turned into draws by each frame preparation task, the same ranges as culling
+    static constexpr std::size_t ChunksPerFramePrepTask = ChunkBoundsTable::ChunksPerTask;
+
+    static constexpr std::size_t RecentlyDestroyedChunkCacheBytes = std::size_t {256} << 20u;
+    static constexpr std::size_t GreedyMeshCacheBytes             = std::size_t {64} << 20u;
+    static constexpr std::size_t MaxRecycledMeshes                = 256;
 
     ChunkRenderManager::ChunkRenderManager(const game::Game* game_)
         : game {game_}
+        , storage_limits {getChunkStorageLimits(game_->getRenderer())}
+        , max_chunks {this->storage_limits.number_of_chunk_data_pages * GpuChunksPerDataPage}
+        , number_of_elided_chunks {0}
         , global_voxel_data(
               game_->getRenderer()->getAllocator(),
               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst
@@ -360,58 +109,44 @@ namespace voxel
               vk::MemoryPropertyFlagBits::eDeviceLocal,
               MaxLights,
               "Gpy Raytraced Lights Buffer")
-        , chunk_id_allocator {MaxChunks}
-        , gpu_chunk_data(
-              game_->getRenderer()->getAllocator(),
-              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
-              vk::MemoryPropertyFlagBits::eDeviceLocal,
-              MaxChunks,
-              "Gpu Chunk Data Buffer")
-        , does_chunk_hash_map_need_recreated {true}
-        , aligned_chunk_hash_table_keys(
-              game_->getRenderer()->getAllocator(),
-              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
-              vk::MemoryPropertyFlagBits::eDeviceLocal,
-              MaxChunkHashNodes,
-              "Aligned Chunk Hash Table Keys")
-        , aligned_chunk_hash_table_values(
-              game_->getRenderer()->getAllocator(),
-              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
-              vk::MemoryPropertyFlagBits::eDeviceLocal,
-              MaxChunkHashNodes,
-              "Aligned Chunk Hash Table Keys")
-        , brick_range_allocator(MaxBricks, MaxBricks * 2)
+        , chunk_id_allocator {this->max_chunks}
+        , chunk_hash_table {game_->getRenderer()->getAllocator()}
+        , recently_destroyed_chunk_cache {RecentlyDestroyedChunkCacheBytes}
+        , greedy_mesh_cache {std::make_shared<GreedyMeshCache>(GreedyMeshCacheBytes)}
+        , mesh_pool {std::make_shared<util::RecyclingPool<ChunkAsyncMesh>>(MaxRecycledMeshes)}
+        , brick_range_allocator(
+              this->storage_limits.max_bricks, this->storage_limits.max_bricks * 2)
         , per_brick_chunk_parent_info(
               game_->getRenderer()->getAllocator(),
               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxBricks),
+              static_cast<std::size_t>(this->storage_limits.max_bricks),
               "Brick Parent Info")
         , material_bricks(
               game_->getRenderer()->getAllocator(),
               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxBricks),
+              static_cast<std::size_t>(this->storage_limits.max_bricks),
               "Material Bricks")
         , shadow_bricks(
               game_->getRenderer()->getAllocator(),
               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxBricks),
+              static_cast<std::size_t>(this->storage_limits.max_bricks),
               "Shadow Bricks")
         , visibility_bricks(
               game_->getRenderer()->getAllocator(),
               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxBricks),
+              static_cast<std::size_t>(this->storage_limits.max_bricks),
               "Visibility Bricks")
-        , primary_ray_bricks(static_cast<std::size_t>(MaxBricks), PrimaryRayBrick {})
-        , voxel_face_allocator(MaxFaces, MaxChunks * 6)
+        , voxel_face_allocator(
+              this->storage_limits.max_faces, this->max_chunks * DirectionsPerChunk)
         , voxel_faces(
               game_->getRenderer()->getAllocator(),
               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxFaces),
+              static_cast<std::size_t>(this->storage_limits.max_faces),
               "Voxel Faces")
         , visible_face_id_map(
               game_->getRenderer()->getAllocator(),
@@ -423,19 +158,31 @@ namespace voxel
               game_->getRenderer()->getAllocator(),
               vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxFaces),
+              static_cast<std::size_t>(MaxFaceIdHashNodes),
               "Visible Face Data")
-        , indirect_payload(
+        , chunk_direction_draws(
               game_->getRenderer()->getAllocator(),
-              vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxChunks * DirectionsPerChunk),
-              "Indirect Payload")
+              static_cast<std::size_t>(this->max_chunks * DirectionsPerChunk),
+              "Chunk Direction Draws")
+        , visible_chunk_draws(
+              game_->getRenderer()->getAllocator(),
+              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+              vk::MemoryPropertyFlagBits::eDeviceLocal,
+              static_cast<std::size_t>(this->max_chunks * DirectionsPerChunk),
+              "Visible Chunk Draws")
+        , explicit_chunk_draws(
+              game_->getRenderer()->getAllocator(),
+              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+              vk::MemoryPropertyFlagBits::eDeviceLocal,
+              static_cast<std::size_t>(MaxExplicitChunkDraws),
+              "Explicit Chunk Draws")
         , indirect_commands(
               game_->getRenderer()->getAllocator(),
-              vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst,
+              vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer,
               vk::MemoryPropertyFlagBits::eDeviceLocal,
-              static_cast<std::size_t>(MaxChunks * DirectionsPerChunk),
+              static_cast<std::size_t>(this->max_chunks * DirectionsPerChunk),
               "Indirect Commands")
         , materials(generateVoxelMaterialBuffer(game_->getRenderer()))
         , voxel_chunk_descriptor_set_layout(
@@ -468,7 +215,7 @@ namespace voxel
                           vk::DescriptorSetLayoutBinding {
                               .binding {2},
                               .descriptorType {vk::DescriptorType::eStorageBuffer},
-                              .descriptorCount {1},
+                              .descriptorCount {this->storage_limits.number_of_chunk_data_pages},
                               .stageFlags {
                                   vk::ShaderStageFlagBits::eVertex
                                   | vk::ShaderStageFlagBits::eFragment
@@ -585,8 +332,70 @@ namespace voxel
                                   | vk::ShaderStageFlagBits::eCompute},
                               .pImmutableSamplers {nullptr},
                           },
+                          // ChunkDirectionDraws
+                          vk::DescriptorSetLayoutBinding {
+                              .binding {13},
+                              .descriptorType {vk::DescriptorType::eStorageBuffer},
+                              .descriptorCount {1},
+                              .stageFlags {
+                                  vk::ShaderStageFlagBits::eVertex
+                                  | vk::ShaderStageFlagBits::eFragment
+                                  | vk::ShaderStageFlagBits::eCompute},
+                              .pImmutableSamplers {nullptr},
+                          },
+                          // VisibleChunkDraws
+                          vk::DescriptorSetLayoutBinding {
+                              .binding {14},
+                              .descriptorType {vk::DescriptorType::eStorageBuffer},
+                              .descriptorCount {1},
+                              .stageFlags {
+                                  vk::ShaderStageFlagBits::eVertex
+                                  | vk::ShaderStageFlagBits::eFragment
+                                  | vk::ShaderStageFlagBits::eCompute},
+                              .pImmutableSamplers {nullptr},
+                          },
+                          // ExplicitChunkDraws
+                          vk::DescriptorSetLayoutBinding {
+                              .binding {15},
+                              .descriptorType {vk::DescriptorType::eStorageBuffer},
+                              .descriptorCount {1},
+                              .stageFlags {
+                                  vk::ShaderStageFlagBits::eVertex
+                                  | vk::ShaderStageFlagBits::eFragment
+                                  | vk::ShaderStageFlagBits::eCompute},
+                              .pImmutableSamplers {nullptr},
+                          },
+                          // IndirectCommands
+                          vk::DescriptorSetLayoutBinding {
+                              .binding {16},
+                              .descriptorType {vk::DescriptorType::eStorageBuffer},
+                              .descriptorCount {1},
+                              .stageFlags {
+                                  vk::ShaderStageFlagBits::eVertex
+                                  | vk::ShaderStageFlagBits::eFragment
+                                  | vk::ShaderStageFlagBits::eCompute},
+                              .pImmutableSamplers {nullptr},
+                          },
                       }},
                       .name {"Voxel Descriptor Set Layout"}}))
+        , voxel_draw_gather_pipeline {game_->getRenderer()->getAllocator()->cachePipeline(
+              gfx::vulkan::CacheableComputePipelineCreateInfo {
+                  .entry_point {"main"},
+                  .shader {game_->getRenderer()->getAllocator()->cacheShaderModule(
+                      staticFilesystem::loadShader("voxel_draw_gather.comp"),
+                      "Voxel Draw Gather Compute Shader")},
+                  .layout {game_->getRenderer()->getAllocator()->cachePipelineLayout(
+                      gfx::vulkan::CacheablePipelineLayoutCreateInfo {
+                          .descriptors {
+                              {game_->getGlobalInfoDescriptorSetLayout(),
+                               this->voxel_chunk_descriptor_set_layout}},
+                          .push_constants {vk::PushConstantRange {
+                              .stageFlags {vk::ShaderStageFlagBits::eCompute},
+                              .offset {0},
+                              .size {sizeof(u32)},
+                          }},
+                          .name {"Voxel Draw Gather Pipeline Layout"}})},
+                  .name {"Voxel Draw Gather Pipeline"}})}
         , voxel_chunk_render_pipeline {game_->getRenderer()->getAllocator()->cachePipeline(
               gfx::vulkan::CacheableGraphicsPipelineCreateInfo {
                   .stages {{
@@ -603,22 +412,8 @@ namespace voxel
                               "Voxel Render Fragment Shader")},
                           .entry_point {"main"}},
                   }},
-                  .vertex_attributes {{
-                      vk::VertexInputAttributeDescription {
-                          .location {0},
-                          .binding {0},
-                          .format {vk::Format::eR32Uint},
-                          .offset {offsetof(ChunkDrawIndirectInstancePayload, normal)}},
-                      vk::VertexInputAttributeDescription {
-                          .location {1},
-                          .binding {0},
-                          .format {vk::Format::eR32Uint},
-                          .offset {offsetof(ChunkDrawIndirectInstancePayload, chunk_id)}},
-                  }},
-                  .vertex_bindings {{vk::VertexInputBindingDescription {
-                      .binding {0},
-                      .stride {sizeof(ChunkDrawIndirectInstancePayload)},
-                      .inputRate {vk::VertexInputRate::eInstance}}}},
+                  .vertex_attributes {},
+                  .vertex_bindings {},
                   .topology {vk::PrimitiveTopology::eTriangleList},
                   .discard_enable {false},
                   .polygon_mode {vk::PolygonMode::eFill},
@@ -716,6 +511,31 @@ namespace voxel
               **this->voxel_chunk_descriptor_set_layout, "Voxel Descriptor Set")}
 
     {
+        this->gpu_chunk_data_pages.reserve(this->storage_limits.number_of_chunk_data_pages);
+
+        for (u32 i = 0; i < this->storage_limits.number_of_chunk_data_pages; ++i)
+        {
+            this->gpu_chunk_data_pages.emplace_back(
+                game_->getRenderer()->getAllocator(),
+                vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                vk::MemoryPropertyFlagBits::eDeviceLocal,
+                GpuChunksPerDataPage,
+                std::format("Gpu Chunk Data Page #{}", i));
+        }
+
+        std::vector<vk::DescriptorBufferInfo> chunkDataPageInfo {};
+        chunkDataPageInfo.reserve(this->gpu_chunk_data_pages.size());
+
+        for (const gfx::vulkan::CpuCachedBuffer<PerChunkGpuData>& page :
+             this->gpu_chunk_data_pages)
+        {
+            chunkDataPageInfo.push_back(vk::DescriptorBufferInfo {
+                .buffer {*page},
+                .offset {0},
+                .range {vk::WholeSize},
+            });
+        }
+
         const auto bufferInfo = {
             vk::DescriptorBufferInfo {
                 .buffer {*this->global_voxel_data},
@@ -727,18 +547,14 @@ namespace voxel
                 .offset {0},
                 .range {vk::WholeSize},
             },
+            chunkDataPageInfo.front(),
             vk::DescriptorBufferInfo {
-                .buffer {*this->gpu_chunk_data},
-                .offset {0},
-                .range {vk::WholeSize},
-            },
-            vk::DescriptorBufferInfo {
-                .buffer {*this->aligned_chunk_hash_table_keys},
+                .buffer {this->chunk_hash_table.getKeyBuffer()},
                 .offset {0},
                 .range {vk::WholeSize},
             },
             vk::DescriptorBufferInfo {
-                .buffer {*this->aligned_chunk_hash_table_values},
+                .buffer {this->chunk_hash_table.getValueBuffer()},
                 .offset {0},
                 .range {vk::WholeSize},
             },
@@ -781,6 +597,26 @@ namespace voxel
                 .buffer {*this->materials},
                 .offset {0},
                 .range {vk::WholeSize},
+            },
+            vk::DescriptorBufferInfo {
+                .buffer {*this->chunk_direction_draws},
+                .offset {0},
+                .range {vk::WholeSize},
+            },
+            vk::DescriptorBufferInfo {
+                .buffer {*this->visible_chunk_draws},
+                .offset {0},
+                .range {vk::WholeSize},
+            },
+            vk::DescriptorBufferInfo {
+                .buffer {*this->explicit_chunk_draws},
+                .offset {0},
+                .range {vk::WholeSize},
+            },
+            vk::DescriptorBufferInfo {
+                .buffer {*this->indirect_commands},
+                .offset {0},
+                .range {vk::WholeSize},
             }};
 
         std::vector<vk::WriteDescriptorSet> writes {};
@@ -804,10 +640,13 @@ namespace voxel
             idx += 1;
         }
 
+        // PerChunkGpuData is bound as an array of every page
+        writes[2].descriptorCount = static_cast<u32>(chunkDataPageInfo.size());
+        writes[2].pBufferInfo     = chunkDataPageInfo.data();
+
         game_->getRenderer()->getDevice()->getDevice().updateDescriptorSets(
             static_cast<u32>(writes.size()), writes.data(), 0, nullptr);
 
-        this->cpu_chunk_data.resize(MaxChunks);
         this->visible_face_id_map.fillImmediate(
             VisibleFaceIdBrickHashMapStorage {.key {~0U}, .value {~0U}}); // TODO: remove?
         this->visibility_bricks.fillImmediate(VisibilityBrick {});
@@ -820,7 +659,14 @@ namespace voxel
     ChunkRenderManager::Chunk ChunkRenderManager::createChunk(ChunkLocation chunkLocation)
     {
         Chunk     newChunk = this->chunk_id_allocator.allocateOrPanic();
-        const u16 chunkId  = this->chunk_id_allocator.getValueOfHandle(newChunk);
+        const u32 chunkId  = this->chunk_id_allocator.getValueOfHandle(newChunk);
+
+        if (chunkId >= this->cpu_chunk_data.size())
+        {
+            this->cpu_chunk_data.resize(
+                static_cast<std::size_t>((chunkId / GpuChunksPerDataPage) + 1)
+                * GpuChunksPerDataPage);
+        }
 
         this->cpu_chunk_data[chunkId] = CpuChunkData {};
         const PerChunkGpuData newChunkGpuData {
@@ -830,17 +676,93 @@ namespace voxel
             .lod {chunkLocation.lod},
             .brick_allocation_offset {0},
             .data {}};
-        this->gpu_chunk_data.write(chunkId, newChunkGpuData);
+        this->writeChunkGpuData(chunkId, newChunkGpuData);
 
-        this->does_chunk_hash_map_need_recreated = true;
+        // Only shader lookups and neighbour links miss a refused chunk, it is still drawn
+        if (!this->chunk_hash_table.insert(chunkLocation, chunkId))
+        {
+            util::logWarn(
+                "Chunk hash table refused the chunk at {} {} {} lod {}, its neighbourhood is too "
+                "crowded",
+                chunkLocation.root_position.x,
+                chunkLocation.root_position.y,
+                chunkLocation.root_position.z,
+                chunkLocation.lod);
+        }
+        this->chunk_bounds.setBounds(chunkId, chunkLocation);
+        this->chunk_neighbours.insert(chunkId, chunkLocation, this->chunk_hash_table.getTable());
 
         return newChunk;
     }
 
     void ChunkRenderManager::destroyChunk(Chunk chunk)
     {
-        CpuChunkData& thisCpuChunkData =
-            this->cpu_chunk_data[this->chunk_id_allocator.getValueOfHandle(chunk)];
+        const u32     chunkId          = this->chunk_id_allocator.getValueOfHandle(chunk);
+        CpuChunkData& thisCpuChunkData = this->cpu_chunk_data[chunkId];
+
+        // Only a chunk with nothing in flight has a final mesh worth keeping
+        if (thisCpuChunkData.active_brick_range_allocation.has_value()
+            && thisCpuChunkData.updates.empty() && !thisCpuChunkData.maybe_async_mesh.valid())
+        {
+            const PerChunkGpuData& gpuData = this->readChunkGpuData(chunkId);
+
+            const std::size_t numberOfBricks = [&]() -> std::size_t
+            {
+                const std::optional<u16> maxValidOffset = gpuData.data.getMaxValidOffset();
+
+                return maxValidOffset.has_value() ? *maxValidOffset + 1 : 0;
+            }();
+
+            const std::span<const MaterialBrick> materialBricks =
+                this->material_bricks.read(gpuData.brick_allocation_offset, numberOfBricks);
+
+            std::vector<ShadowBrick> shadowBricks(numberOfBricks);
+            for (std::size_t i = 0; i < numberOfBricks; ++i)
+            {
+                PrimaryRayBrick unused {};
+                deriveBrickMasks(materialBricks[i], shadowBricks[i], unused);
+            }
+
+            // parent_chunk is patched when this is restored
+            std::vector<BrickParentInformation> parentBricks(numberOfBricks);
+            gpuData.data.iterateOverBricks(
+                [&](BrickCoordinate bC, u16 offset)
+                {
+                    if (offset != ChunkBrickMap::NullOffset)
+                    {
+                        parentBricks[offset] = BrickParentInformation {
+                            .parent_chunk {chunkId},
+                            .position_in_parent_chunk {static_cast<u32>(bC.asLinearIndex())}};
+                    }
+                });
+
+            ChunkAsyncMesh finalMesh {
+                .new_brick_map {gpuData.data},
+                .new_parent_bricks {std::move(parentBricks)},
+                .new_material_bricks {std::from_range, materialBricks},
+                .new_shadow_bricks {std::move(shadowBricks)},
+                .new_greedy_faces {std::move(thisCpuChunkData.active_greedy_faces)},
+                .new_face_clusters {std::move(thisCpuChunkData.active_face_clusters)},
+                .new_occluders {std::move(thisCpuChunkData.active_occluders)},
+                .new_sealed_faces {this->chunk_neighbours.getSealedFaces(chunkId)}};
+
+            std::size_t cost = numberOfBricks
+                             * (sizeof(BrickParentInformation) + sizeof(MaterialBrick)
+                                + sizeof(ShadowBrick));
+
+            for (const std::vector<GreedyVoxelFace>& faces : finalMesh.new_greedy_faces)
+            {
+                cost += faces.size() * sizeof(GreedyVoxelFace);
+            }
+
+            for (const std::vector<GreedyFaceCluster>& clusters : finalMesh.new_face_clusters)
+            {
+                cost += clusters.size() * sizeof(GreedyFaceCluster);
+            }
+
+            this->recently_destroyed_chunk_cache.insert(
+                this->getChunkLocation(chunkId), std::move(finalMesh), cost);
+        }
 
         this->chunk_id_allocator.free(std::move(chunk));
 
@@ -849,19 +771,64 @@ namespace voxel
             this->brick_range_allocator.free(*allocation);
         }
 
-        if (std::optional faces = thisCpuChunkData.active_draw_allocations; faces.has_value())
+        if (std::optional faces = thisCpuChunkData.active_draw_allocation; faces.has_value())
         {
-            for (util::RangeAllocation a : *faces)
-            {
-                this->voxel_face_allocator.free(a);
-            }
+            this->voxel_face_allocator.free(*faces);
         }
 
-        this->does_chunk_hash_map_need_recreated = true;
+        this->chunk_hash_table.erase(this->getChunkLocation(chunkId), chunkId);
+        this->chunk_bounds.clear(chunkId);
+        this->chunk_neighbours.erase(chunkId, this->chunk_hash_table.getTable());
 
         thisCpuChunkData = {};
     }
 
+    void ChunkRenderManager::addElidedChunk()
+    {
+        this->number_of_elided_chunks += 1;
+    }
+
+    void ChunkRenderManager::removeElidedChunk()
+    {
+        util::assertFatal(this->number_of_elided_chunks > 0, "No chunk was elided");
+
+        this->number_of_elided_chunks -= 1;
+    }
+
+    bool ChunkRenderManager::hasRecentlyDestroyedChunk(ChunkLocation location) const
+    {
+        return this->recently_destroyed_chunk_cache.contains(location);
+    }
+
+    std::shared_ptr<std::atomic_bool>
+    ChunkRenderManager::tryRestoreRecentlyDestroyedChunk(const Chunk& chunk)
+    {
+        const u32 chunkId = this->chunk_id_allocator.getValueOfHandle(chunk);
+
+        std::optional<ChunkAsyncMesh> maybeCachedMesh =
+            this->recently_destroyed_chunk_cache.take(this->getChunkLocation(chunkId));
+
+        if (!maybeCachedMesh.has_value())
+        {
+            return nullptr;
+        }
+
+        for (BrickParentInformation& parent : maybeCachedMesh->new_parent_bricks)
+        {
+            parent.parent_chunk = chunkId;
+        }
+
+        // Hand it to the integration pass as if it were a freshly completed mesh
+        std::promise<ChunkAsyncMesh> alreadyMeshed {};
+        alreadyMeshed.set_value(std::move(*maybeCachedMesh));
+
+        CpuChunkData& chunkData                  = this->cpu_chunk_data[chunkId];
+        chunkData.maybe_async_mesh               = alreadyMeshed.get_future();
+        chunkData.maybe_async_mesh_caller_result = std::make_shared<std::atomic_bool>(false);
+
+        return chunkData.maybe_async_mesh_caller_result;
+    }
+
     ChunkRenderManager::RaytracedLight
     ChunkRenderManager::createRaytracedLight(GpuRaytracedLight rawLight)
     {
@@ -900,50 +867,44 @@ namespace voxel
         return chunkData.maybe_async_mesh_caller_result;
     }
 
+    std::shared_ptr<std::atomic_bool> ChunkRenderManager::fillChunk(const Chunk& chunk, Voxel voxel)
+    {
+        util::assertFatal(!chunk.isNull(), "Tried to fill null chunk!");
+
+        CpuChunkData& chunkData =
+            this->cpu_chunk_data[this->chunk_id_allocator.getValueOfHandle(chunk)];
+
+        chunkData.pending_fill = voxel;
+        chunkData.updates.clear();
+
+        chunkData.maybe_async_mesh_caller_result = std::make_shared<std::atomic_bool>(false);
+
+        return chunkData.maybe_async_mesh_caller_result;
+    }
+
     std::vector<game::FrameGenerator::RecordObject>
     ChunkRenderManager::processUpdatesAndGetDrawObjects(
         const game::Camera& camera, gfx::profiler::TaskGenerator& profilerTaskGenerator) // NOLINT
     {
         const gfx::vulkan::BufferStager& stager = this->game->getRenderer()->getStager();
 
-        std::vector<vk::DrawIndirectCommand>                indirectCommands {};
-        std::vector<ChunkDrawIndirectInstancePayload>       indirectPayload {};
-        std::vector<std::pair<HashedGpuChunkLocation, u16>> alignedChunksToPutInHashMap {};
+        std::vector<u32>                     visibleDraws {};
+        std::vector<vk::DrawIndirectCommand> explicitDraws {};
 
-        u32 callNumber         = 0;
         u32 numberOfTotalFaces = 0;
 
         this->chunk_id_allocator.iterateThroughAllocatedElements(
-            [&](const u16 chunkId) // NOLINT
+            [&](const u32 chunkId) // NOLINT
             {
                 CpuChunkData& thisChunkData = this->cpu_chunk_data[chunkId];
 
-                const ChunkLocation chunkPosition = [&]
-                {
-                    const PerChunkGpuData& gpuData = this->gpu_chunk_data.read(chunkId);
-
-                    return ChunkLocation {
-                        glm::i32vec3 {
-                            gpuData.world_offset_x,
-                            gpuData.world_offset_y,
-                            gpuData.world_offset_z,
-                        },
-                        gpuData.lod};
-                }();
-
-#warning handle
-                /* is chunk aligned chunk */
-                {
-                    alignedChunksToPutInHashMap.push_back(
-                        {HashedGpuChunkLocation {chunkPosition}, chunkId});
-                }
-
                 // we need to spawn a new mesh task
-                if (!thisChunkData.updates.empty() && !thisChunkData.maybe_async_mesh.valid())
+                if ((!thisChunkData.updates.empty() || thisChunkData.pending_fill.has_value())
+                    && !thisChunkData.maybe_async_mesh.valid())
                 {
                     // TODO: HACK: bad replace with unique_ptr once run async has move only function
                     std::shared_ptr<PerChunkGpuData> oldGpuData =
-                        std::make_shared<PerChunkGpuData>(this->gpu_chunk_data.read(chunkId));
+                        std::make_shared<PerChunkGpuData>(this->readChunkGpuData(chunkId));
 
                     const std::size_t oldBricksPerChunk = [&]() -> std::size_t
                     {
@@ -963,28 +924,24 @@ namespace voxel
                     const std::span<const MaterialBrick> spanOldMaterialBricks =
                         this->material_bricks.read(
                             oldGpuData->brick_allocation_offset, oldBricksPerChunk);
-                    const std::span<const ShadowBrick> spanOldShadowBricks =
-                        this->shadow_bricks.read(
-                            oldGpuData->brick_allocation_offset, oldBricksPerChunk);
-                    const std::span<const PrimaryRayBrick> spanOldPrimaryRayBricks {
-                        &this->primary_ray_bricks[oldGpuData->brick_allocation_offset],
-                        oldBricksPerChunk};
 
                     thisChunkData.maybe_async_mesh = util::runAsync(
                         [chunkId,
-                         localOldGpuData          = oldGpuData,
-                         localOldMaterialBricks   = spanOldMaterialBricks,
-                         localOldShadowBricks     = spanOldShadowBricks,
-                         localOldPrimaryRayBricks = spanOldPrimaryRayBricks,
-                         localNewUpdates          = std::move(thisChunkData.updates)]
+                         localOldGpuData        = oldGpuData,
+                         localOldMaterialBricks = spanOldMaterialBricks,
+                         localFill              = std::exchange(thisChunkData.pending_fill, {}),
+                         localNewUpdates        = std::move(thisChunkData.updates),
+                         localGreedyMeshCache   = this->greedy_mesh_cache,
+                         localMeshPool          = this->mesh_pool]
                         {
-                            return doMesh(
+                            return meshChunk(
                                 chunkId,
-                                *localOldGpuData,
+                                localOldGpuData->data,
                                 localOldMaterialBricks,
-                                localOldShadowBricks,
-                                localOldPrimaryRayBricks,
-                                localNewUpdates);
+                                localFill,
+                                localNewUpdates,
+                                *localGreedyMeshCache,
+                                *localMeshPool);
                         });
                 }
             });
@@ -992,7 +949,7 @@ namespace voxel
         profilerTaskGenerator.stamp("Spawn Meshes");
 
         this->chunk_id_allocator.iterateThroughAllocatedElements(
-            [&](const u16 chunkId) // NOLINT
+            [&](const u32 chunkId) // NOLINT
             {
                 CpuChunkData& thisChunkData = this->cpu_chunk_data[chunkId];
 
@@ -1006,13 +963,9 @@ namespace voxel
                             *thisChunkData.active_brick_range_allocation);
                     }
 
-                    if (thisChunkData.active_draw_allocations.has_value())
+                    if (thisChunkData.active_draw_allocation.has_value())
                     {
-                        for (util::RangeAllocation allocation :
-                             *thisChunkData.active_draw_allocations)
-                        {
-                            this->voxel_face_allocator.free(allocation);
-                        }
+                        this->voxel_face_allocator.free(*thisChunkData.active_draw_allocation);
                     }
 
                     ChunkAsyncMesh newMeshResult   = thisChunkData.maybe_async_mesh.get();
@@ -1025,20 +978,53 @@ namespace voxel
                         newMeshResult.new_material_bricks.size()
                                 == newMeshResult.new_shadow_bricks.size()
                             && newMeshResult.new_shadow_bricks.size()
-                                   == newMeshResult.new_parent_bricks.size()
-                            && newMeshResult.new_parent_bricks.size()
-                                   == newMeshResult.new_primary_ray_bricks.size(),
-                        "Dont mess this up {} {} {} {}",
+                                   == newMeshResult.new_parent_bricks.size(),
+                        "Dont mess this up {} {} {}",
                         newMeshResult.new_material_bricks.size(),
                         newMeshResult.new_shadow_bricks.size(),
-                        newMeshResult.new_parent_bricks.size(),
-                        newMeshResult.new_primary_ray_bricks.size());
+                        newMeshResult.new_parent_bricks.size());
 
                     thisChunkData.active_brick_range_allocation = newBrickAllocation;
 
-                    const PerChunkGpuData& oldGpuData = this->gpu_chunk_data.read(chunkId);
+                    u32 numberOfFaces = 0;
+
+                    for (const std::vector<GreedyVoxelFace>& faces :
+                         newMeshResult.new_greedy_faces)
+                    {
+                        numberOfFaces += static_cast<u32>(faces.size());
+                    }
+
+                    const util::RangeAllocation newFaceAllocation =
+                        this->voxel_face_allocator.allocate(numberOfFaces);
+
+                    std::array<u32, 6> faceOffsets {};
+                    std::array<u32, 6> faceCounts {};
+                    u32                nextFaceOffset = newFaceAllocation.offset;
+
+                    for (std::size_t normal = 0; normal < 6; ++normal)
+                    {
+                        const std::vector<GreedyVoxelFace>& faces =
+                            newMeshResult.new_greedy_faces[normal];
 
-                    this->gpu_chunk_data.write(
+                        faceOffsets[normal] = nextFaceOffset;
+                        faceCounts[normal]  = static_cast<u32>(faces.size());
+
+                        if (!faces.empty())
+                        {
+                            stager.enqueueTransfer(
+                                this->voxel_faces,
+                                faceOffsets[normal],
+                                {faces.data(), faces.size()});
+                        }
+
+                        nextFaceOffset += faceCounts[normal];
+                    }
+
+                    thisChunkData.active_draw_allocation = newFaceAllocation;
+
+                    const PerChunkGpuData& oldGpuData = this->readChunkGpuData(chunkId);
+
+                    this->writeChunkGpuData(
                         chunkId,
                         PerChunkGpuData {
                             .world_offset_x {oldGpuData.world_offset_x},
@@ -1046,6 +1032,7 @@ namespace voxel
                             .world_offset_z {oldGpuData.world_offset_z},
                             .lod {oldGpuData.lod},
                             .brick_allocation_offset {newBrickAllocation.offset},
+                            .direction_face_offsets {faceOffsets},
                             .data {newMeshResult.new_brick_map}});
 
                     stager.enqueueTransfer(
@@ -1055,32 +1042,32 @@ namespace voxel
 
                     this->material_bricks.write(
                         newBrickAllocation.offset, newMeshResult.new_material_bricks);
-                    this->shadow_bricks.write(
-                        newBrickAllocation.offset, newMeshResult.new_shadow_bricks);
-
-                    std::copy( // NOLINT
-                        newMeshResult.new_primary_ray_bricks.cbegin(),
-                        newMeshResult.new_primary_ray_bricks.cend(),
-                        this->primary_ray_bricks.begin() + newBrickAllocation.offset);
+                    stager.enqueueTransfer(
+                        this->shadow_bricks,
+                        newBrickAllocation.offset,
+                        {newMeshResult.new_shadow_bricks});
 
-                    std::array<util::RangeAllocation, 6> allocations {};
+                    this->chunk_bounds.setDrawRanges(chunkId, faceOffsets, faceCounts);
 
-                    for (auto [thisAllocation, faces] :
-                         std::views::zip(allocations, newMeshResult.new_greedy_faces))
+                    for (u32 normal = 0; normal < 6; ++normal)
                     {
-                        thisAllocation =
-                            this->voxel_face_allocator.allocate(static_cast<u32>(faces.size()));
-
-                        if (!faces.empty())
-                        {
-                            stager.enqueueTransfer(
-                                this->voxel_faces,
-                                thisAllocation.offset,
-                                {faces.data(), faces.size()});
-                        }
+                        this->chunk_direction_draws.write(
+                            (chunkId * DirectionsPerChunk) + normal,
+                            vk::DrawIndirectCommand {
+                                .vertexCount {faceCounts[normal] * 6},
+                                .instanceCount {1},
+                                .firstVertex {faceOffsets[normal] * 6},
+                                .firstInstance {chunkId},
+                            });
                     }
 
-                    thisChunkData.active_draw_allocations = allocations;
+                    // Swapped so that the storage of the previous mesh is recycled below
+                    std::swap(thisChunkData.active_greedy_faces, newMeshResult.new_greedy_faces);
+                    std::swap(thisChunkData.active_face_clusters, newMeshResult.new_face_clusters);
+                    std::swap(thisChunkData.active_occluders, newMeshResult.new_occluders);
+                    this->chunk_neighbours.setSealedFaces(chunkId, newMeshResult.new_sealed_faces);
+
+                    this->mesh_pool->release(std::move(newMeshResult));
 
                     thisChunkData.maybe_async_mesh_caller_result->store(true);
                 }
@@ -1088,98 +1075,278 @@ namespace voxel
 
         profilerTaskGenerator.stamp("Integrate Mesh");
 
-        this->chunk_id_allocator.iterateThroughAllocatedElements(
-            [&](const u16 chunkId) // NOLINT
+        const std::array<glm::vec4, 6> frustumPlanes  = camera.getFrustumPlanes(*this->game);
+        const glm::vec3                cameraPosition = camera.getPosition();
+        std::vector<u8>                visibleDirections {};
+
+        // Culling and draw generation only read chunk state, so they are split into fixed ranges
+        // of chunks across the thread pool. Each range has its own output and they are merged in
+        // range order, so the result never depends on scheduling.
+        const std::size_t numberOfChunkSlots = this->chunk_bounds.size();
+        const std::size_t numberOfFramePrepTasks =
+            (numberOfChunkSlots + ChunksPerFramePrepTask - 1) / ChunksPerFramePrepTask;
+
+        this->chunk_bounds.cullParallel(frustumPlanes, cameraPosition, visibleDirections);
+
+        const u32 numberOfChunksOccluded = this->cullOccludedChunks(camera, visibleDirections);
+
+        profilerTaskGenerator.stamp("Cull Chunks");
+
+        struct SortableChunkDraw
+        {
+            u32 bucket;
+            u32 visible_draw;
+        };
+        // Every direction's faces are contiguous in VoxelFaceDirection order, so consecutive
+        // visible ranges, even ones from different directions, are drawn as one run
+        struct DrawRun
+        {
+            u32 first_face;
+            u32 number_of_faces;
+            f32 distance;
+            u32 first_direction;
+            u32 last_direction;
+        };
+        struct ChunkDrawBatch
+        {
+            std::vector<SortableChunkDraw>               draws;
+            std::array<u32, NumberOfDrawDistanceBuckets> draws_per_bucket;
+            std::vector<vk::DrawIndirectCommand>         explicit_draws;
+            u32                                          number_of_faces;
+            // Runs of the chunk being generated, kept to reuse their storage
+            std::vector<DrawRun>                         runs;
+        };
+        std::vector<ChunkDrawBatch> batches(numberOfFramePrepTasks);
+
+        // A fixed share each, so which runs get explicit draws doesn't depend on scheduling either
+        const std::size_t maxExplicitDrawsPerBatch =
+            MaxExplicitChunkDraws / std::max(numberOfFramePrepTasks, std::size_t {1});
+
+        auto generateChunkDraws = [&](ChunkDrawBatch& batch, u32 chunkId)
+        {
+            const u8 thisChunkVisibleDirections = visibleDirections[chunkId];
+
+            if (thisChunkVisibleDirections == 0)
             {
-                CpuChunkData& thisChunkData = this->cpu_chunk_data[chunkId];
+                return;
+            }
+
+            std::vector<DrawRun>& runs = batch.runs;
+            runs.clear();
 
-                const ChunkLocation chunkPosition = [&]
+            // Runs are ordered by their nearest part
+            auto addToRun = [&](u32 normal, u32 firstFace, u32 numberOfFaces, f32 distance)
+            {
+                if (!runs.empty()
+                    && runs.back().first_face + runs.back().number_of_faces == firstFace)
                 {
-                    const PerChunkGpuData& gpuData = this->gpu_chunk_data.read(chunkId);
+                    runs.back().number_of_faces += numberOfFaces;
+                    runs.back().distance       = std::min(runs.back().distance, distance);
+                    runs.back().last_direction = normal;
+                }
+                else
+                {
+                    runs.push_back(DrawRun {
+                        .first_face {firstFace},
+                        .number_of_faces {numberOfFaces},
+                        .distance {distance},
+                        .first_direction {normal},
+                        .last_direction {normal},
+                    });
+                }
+            };
+
+            auto getDirectionsStart = [&](const DrawRun& r)
+            {
+                return this->chunk_bounds.getFaceOffset(chunkId, r.first_direction);
+            };
+            auto getDirectionsEnd = [&](const DrawRun& r)
+            {
+                return this->chunk_bounds.getFaceOffset(chunkId, r.last_direction)
+                     + this->chunk_bounds.getFaceCount(chunkId, r.last_direction);
+            };
+            // Runs of whole directions are already described by chunk_direction_draws
+            auto isWholeDirections = [&](const DrawRun& r)
+            {
+                return r.first_face == getDirectionsStart(r)
+                    && r.first_face + r.number_of_faces == getDirectionsEnd(r);
+            };
 
-                    return ChunkLocation {
-                        glm::i32vec3 {
-                            gpuData.world_offset_x,
-                            gpuData.world_offset_y,
-                            gpuData.world_offset_z,
-                        },
-                        gpuData.lod};
-                }();
+            const bool intersectsFrustum =
+                (thisChunkVisibleDirections & ChunkBoundsTable::IntersectsFrustumBit) != 0;
+            const f32       halfExtent = this->chunk_bounds.getHalfExtent(chunkId);
+            const glm::vec3 chunkMin   = this->chunk_bounds.getCenter(chunkId) - halfExtent;
+            const f32       voxelWidth = (2.0f * halfExtent) / static_cast<f32>(VoxelsPerChunkEdge);
+            const f32       chunkDistance =
+                getDistanceToBox(cameraPosition, chunkMin, chunkMin + (2.0f * halfExtent));
 
-                bool isChunkInFrustum = true;
+            for (u32 normal = 0; normal < 6; ++normal)
+            {
+                const u32 numberOfFaces = this->chunk_bounds.getFaceCount(chunkId, normal);
+                const u32 firstFace     = this->chunk_bounds.getFaceOffset(chunkId, normal);
 
-                if (thisChunkData.active_draw_allocations.has_value() && isChunkInFrustum)
+                if (numberOfFaces == 0 || (thisChunkVisibleDirections & (1U << normal)) == 0)
                 {
-                    const glm::vec3 chunkCenterPosition =
-                        chunkPosition.root_position
-                        + static_cast<i32>(
-                            (gpu_calculateChunkVoxelSizeUnits(chunkPosition.lod)
-                             * (VoxelsPerChunkEdge / 2)));
+                    continue;
+                }
 
-                    u32 normal = 0;
+                if (!intersectsFrustum)
+                {
+                    addToRun(normal, firstFace, numberOfFaces, chunkDistance);
 
-                    for (util::RangeAllocation a : *thisChunkData.active_draw_allocations)
+                    continue;
+                }
+
+                // Only part of this chunk is visible, so cull its clusters individually
+                for (const GreedyFaceCluster& c :
+                     this->cpu_chunk_data[chunkId].active_face_clusters[normal])
+                {
+                    const glm::vec3 clusterMin = chunkMin + (glm::vec3 {c.min} * voxelWidth);
+                    const glm::vec3 clusterMax =
+                        chunkMin + ((glm::vec3 {c.max} + 1.0f) * voxelWidth);
+
+                    if (isBoxInFrustum(frustumPlanes, clusterMin, clusterMax))
                     {
-                        const u32 numberOfFaces = this->voxel_face_allocator.getSizeOfAllocation(a);
-
-                        // const glm::vec3 normalVector = static_cast<glm::vec3>(
-                        //     getDirFromDirection(static_cast<VoxelFaceDirection>(normal)));
-                        const glm::vec3 toChunkVector =
-                            glm::normalize(chunkCenterPosition - camera.getPosition());
-                        const glm::vec3 forwardVector = camera.getForwardVector();
-
-                    // const glm::i32vec3 chunkCenterInteger =
-                    //     static_cast<glm::i32vec3>(chunkCenterPosition);
-                    // const glm::i32vec3 cameraCenterInteger =
-                    //     static_cast<glm::i32vec3>(camera.getPosition());
-
-                    // const glm::i32vec3 cameraCoordinate =
-                    //     cameraCenterInteger / static_cast<i32>(voxel::VoxelsPerChunkEdge);
-
-#warning fix
-                        // const bool doesChunkShareAxis = false;
-                        // glm::any(glm::equal(chunkCoordinate, cameraCoordinate));
-
-                        // TODO: refine bounds on axies
-                        if (glm::distance(chunkCenterPosition, camera.getPosition())
-                                > VoxelsPerChunkEdge * 2
-                            && (glm::dot(forwardVector, toChunkVector) < -std::cos(std::min({
-                                    this->game->getFovXRadians(),
-                                    this->game->getFovYRadians(),
-                                }))
-
-                                || glm::dot(forwardVector, toChunkVector) < 0.0f
-
-                                // || (glm::dot(toChunkVector, normalVector) > 0.0f
-                                //     && !doesChunkShareAxis))
-                                ))
-                        {
-                            /* cull */
-                        }
-                        else
-                        {
-                            indirectCommands.push_back(vk::DrawIndirectCommand {
-                                .vertexCount {numberOfFaces * 6},
-                                .instanceCount {1},
-                                .firstVertex {a.offset * 6},
-                                .firstInstance {callNumber},
-                            });
+                        addToRun(
+                            normal,
+                            firstFace + c.first_face,
+                            c.number_of_faces,
+                            getDistanceToBox(cameraPosition, clusterMin, clusterMax));
+                    }
+                }
+            }
 
-                            indirectPayload.push_back(ChunkDrawIndirectInstancePayload {
-                                .normal {normal}, .chunk_id {chunkId}});
+            const std::size_t numberOfPartialRuns = static_cast<std::size_t>(
+                std::ranges::count_if(runs, std::not_fn(isWholeDirections)));
 
-                            callNumber += 1;
-                            numberOfTotalFaces += numberOfFaces;
-                        }
-                        normal += 1;
+            // Partial runs need their own command. Once this batch's share of those can't fit all
+            // of this chunk's, every run is widened to the whole directions it touches instead,
+            // merging runs that then touch the same or adjacent directions so that no direction
+            // is drawn twice
+            if (batch.explicit_draws.size() + numberOfPartialRuns > maxExplicitDrawsPerBatch)
+            {
+                std::size_t numberOfWidenedRuns = 0;
+
+                for (const DrawRun& r : runs)
+                {
+                    if (numberOfWidenedRuns != 0
+                        && r.first_direction <= runs[numberOfWidenedRuns - 1].last_direction + 1)
+                    {
+                        DrawRun& previous = runs[numberOfWidenedRuns - 1];
+
+                        previous.distance       = std::min(previous.distance, r.distance);
+                        previous.last_direction = r.last_direction;
+                    }
+                    else
+                    {
+                        runs[numberOfWidenedRuns++] = r;
                     }
                 }
+
+                runs.resize(numberOfWidenedRuns);
+
+                for (DrawRun& r : runs)
+                {
+                    r.first_face      = getDirectionsStart(r);
+                    r.number_of_faces = getDirectionsEnd(r) - r.first_face;
+                }
+            }
+
+            for (const DrawRun& r : runs)
+            {
+                u32 visibleDraw = 0;
+
+                if (isWholeDirections(r))
+                {
+                    visibleDraw =
+                        gpu_packVisibleChunkDraw(chunkId, r.first_direction, r.last_direction);
+                }
+                else
+                {
+                    visibleDraw = GpuVisibleChunkDrawExplicitBit
+                                | static_cast<u32>(batch.explicit_draws.size());
+
+                    batch.explicit_draws.push_back(vk::DrawIndirectCommand {
+                        .vertexCount {r.number_of_faces * 6},
+                        .instanceCount {1},
+                        .firstVertex {r.first_face * 6},
+                        .firstInstance {chunkId},
+                    });
+                }
+
+                const u32 bucket = getDrawDistanceBucket(r.distance);
+
+                batch.draws.push_back(
+                    SortableChunkDraw {.bucket {bucket}, .visible_draw {visibleDraw}});
+
+                batch.draws_per_bucket[bucket] += 1;
+                // Widened runs count every face of the directions they draw
+                batch.number_of_faces += r.number_of_faces;
+            }
+        };
+
+        util::parallelFor(
+            numberOfFramePrepTasks,
+            [&](std::size_t task)
+            {
+                const std::size_t lastChunk =
+                    std::min((task + 1) * ChunksPerFramePrepTask, numberOfChunkSlots);
+
+                for (std::size_t chunkId = task * ChunksPerFramePrepTask; chunkId < lastChunk;
+                     ++chunkId)
+                {
+                    generateChunkDraws(batches[task], static_cast<u32>(chunkId));
+                }
             });
-        profilerTaskGenerator.stamp("Cull Meshes");
+
+        // Counting sort the draws into front to back order so the nearest surfaces are
+        // rasterized first and hide as much as possible of what comes after behind early depth
+        // rejection
+        std::array<u32, NumberOfDrawDistanceBuckets> drawsPerBucket {};
+        std::size_t                                  numberOfDraws = 0;
+
+        for (const ChunkDrawBatch& batch : batches)
+        {
+            for (u32 bucket = 0; bucket < NumberOfDrawDistanceBuckets; ++bucket)
+            {
+                drawsPerBucket[bucket] += batch.draws_per_bucket[bucket];
+            }
+
+            numberOfDraws += batch.draws.size();
+        }
+
+        std::exclusive_scan(
+            drawsPerBucket.begin(), drawsPerBucket.end(), drawsPerBucket.begin(), 0U);
+
+        visibleDraws.resize(numberOfDraws);
+
+        for (const ChunkDrawBatch& batch : batches)
+        {
+            const u32 explicitDrawOffset = static_cast<u32>(explicitDraws.size());
+
+            explicitDraws.insert(
+                explicitDraws.end(), batch.explicit_draws.cbegin(), batch.explicit_draws.cend());
+            numberOfTotalFaces += batch.number_of_faces;
+
+            for (const SortableChunkDraw& d : batch.draws)
+            {
+                const bool isExplicit = (d.visible_draw & GpuVisibleChunkDrawExplicitBit) != 0;
+
+                visibleDraws[drawsPerBucket[d.bucket]++] =
+                    d.visible_draw + (isExplicit ? explicitDrawOffset : 0);
+            }
+        }
+
+        profilerTaskGenerator.stamp("Generate Draws");
 
         // Update Debug Menu
         ::numberOfChunksAllocated.store(this->chunk_id_allocator.getNumberAllocated());
-        ::numberOfChunksPossible.store(MaxChunks);
+        ::numberOfChunksPossible.store(this->max_chunks);
+        ::numberOfChunksElided.store(this->number_of_elided_chunks);
+        ::numberOfChunksOccluded.store(numberOfChunksOccluded);
+        ::numberOfChunkDraws.store(static_cast<u32>(visibleDraws.size()));
+        ::numberOfMeshCacheHits.store(this->greedy_mesh_cache->getNumberOfHits());
+        ::numberOfMeshCacheMisses.store(this->greedy_mesh_cache->getNumberOfMisses());
 
         const auto [bricksAllocated, bricksPossible] = this->brick_range_allocator.getStorageInfo();
         ::numberOfBricksAllocated.store(bricksAllocated);
@@ -1195,106 +1362,29 @@ namespace voxel
         ::numberOfFacesPossible.store(facesPossible);
 
         this->raytraced_lights.flushViaStager(stager);
-        this->gpu_chunk_data.flushViaStager(stager);
+        for (gfx::vulkan::CpuCachedBuffer<PerChunkGpuData>& page : this->gpu_chunk_data_pages)
+        {
+            page.flushViaStager(stager);
+        }
         this->material_bricks.flushViaStager(stager);
-        this->shadow_bricks.flushViaStager(stager);
 
-        if (!indirectCommands.empty())
+        this->chunk_direction_draws.flushViaStager(stager);
+
+        if (!visibleDraws.empty())
         {
             stager.enqueueTransfer(
-                this->indirect_commands,
-                0,
-                std::span<const vk::DrawIndirectCommand> {indirectCommands});
+                this->visible_chunk_draws, 0, std::span<const u32> {visibleDraws});
         }
 
-        if (!indirectPayload.empty())
+        if (!explicitDraws.empty())
         {
             stager.enqueueTransfer(
-                this->indirect_payload,
+                this->explicit_chunk_draws,
                 0,
-                std::span<const ChunkDrawIndirectInstancePayload> {indirectPayload});
+                std::span<const vk::DrawIndirectCommand> {explicitDraws});
         }
 
-        if (this->does_chunk_hash_map_need_recreated)
-        {
-            this->does_chunk_hash_map_need_recreated = false;
-
-            std::vector<HashedGpuChunkLocation> keys {};
-            std::vector<u16>                    values {};
-
-            keys.resize(MaxChunkHashNodes, HashedGpuChunkLocation {});
-            values.resize(MaxChunkHashNodes, 65535);
-
-            // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
-            auto nonAtomicCas = [](u32& mem, u32 compare, u32 data)
-            {
-                const u32 originalMem = mem;
-
-                if (mem == compare)
-                {
-                    mem = data;
-                }
-
-                return originalMem;
-            };
-
-            auto insertChunkHashTable = [&](HashedGpuChunkLocation position, u16 chunkId)
-            {
-                const u32 key = position.hashed_value;
-
-                uint32_t slot = key % MaxChunkHashNodes;
-
-                while (true)
-                {
-                    const uint32_t prev =
-                        nonAtomicCas(keys[slot].hashed_value, HashedGpuChunkLocation::Empty, key);
-
-                    if (prev == HashedGpuChunkLocation::Empty || prev == key)
-                    {
-                        values[slot] = chunkId;
-                        break;
-                    }
-                    else if (prev == key)
-                    {
-                        util::logWarn("Hash collision detected! {}", position.hashed_value);
-                        break;
-                    }
-                    slot = (slot + 1) % MaxChunkHashNodes;
-                }
-            };
-
-            // auto readChunkHashTable = [&](HashedGpuChunkLocation position) -> u16
-            // {
-            //     const u32 key = position.hashed_value;
-
-            //     uint32_t slot = key % MaxChunkHashNodes;
-
-            //     while (true)
-            //     {
-            //         if (keys[slot].hashed_value == key)
-            //         {
-            //             return values[slot];
-            //         }
-            //         if (keys[slot].hashed_value == HashedGpuChunkLocation::Empty)
-            //         {
-            //             return 65535;
-            //         }
-            //         slot = (slot + 1) % MaxChunkHashNodes;
-            //     }
-            // };
-
-            for (const auto [key, value] : alignedChunksToPutInHashMap)
-            {
-                insertChunkHashTable(key, value);
-
-                // util::assertFatal(
-                //     value == readChunkHashTable(key), "{} != {}", value,
-                //     readChunkHashTable(key));
-            }
-
-            stager.enqueueTransfer(this->aligned_chunk_hash_table_keys, 0, {keys});
-            stager.enqueueTransfer(this->aligned_chunk_hash_table_values, 0, {values});
-        }
+        this->chunk_hash_table.flushViaStager(stager);
 
         profilerTaskGenerator.stamp("Do gpu writes");
 
@@ -1304,7 +1394,7 @@ namespace voxel
             .pipeline {nullptr},
             .descriptors {},
             .record_func {
-                [this, indirectCommands, indirectPayload](
+                [this, numberOfDraws = static_cast<u32>(visibleDraws.size())](
                     vk::CommandBuffer commandBuffer, vk::PipelineLayout, u32)
                 {
                     GlobalVoxelData data {
@@ -1321,6 +1411,62 @@ namespace voxel
                         *this->global_voxel_data, 0, sizeof(GlobalVoxelData) - 4, &data);
 
                     commandBuffer.fillBuffer(*this->visible_face_id_map, 0, vk::WholeSize, ~0U);
+
+                    if (numberOfDraws == 0)
+                    {
+                        return;
+                    }
+
+                    // Expand this frame's visible draws into indirect_commands. The previous
+                    // frame's indirect reads must finish before they are overwritten.
+                    commandBuffer.pipelineBarrier(
+                        vk::PipelineStageFlagBits::eTransfer
+                            | vk::PipelineStageFlagBits::eDrawIndirect,
+                        vk::PipelineStageFlagBits::eComputeShader,
+                        vk::DependencyFlags {},
+                        {vk::MemoryBarrier {
+                            .sType {vk::StructureType::eMemoryBarrier},
+                            .pNext {nullptr},
+                            .srcAccessMask {vk::AccessFlagBits::eTransferWrite},
+                            .dstAccessMask {
+                                vk::AccessFlagBits::eShaderRead
+                                | vk::AccessFlagBits::eShaderWrite},
+                        }},
+                        {},
+                        {});
+
+                    const vk::PipelineLayout gatherLayout =
+                        **this->game->getRenderer()->getAllocator()->lookupPipelineLayout(
+                            **this->voxel_draw_gather_pipeline);
+
+                    commandBuffer.bindPipeline(
+                        vk::PipelineBindPoint::eCompute, **this->voxel_draw_gather_pipeline);
+                    commandBuffer.bindDescriptorSets(
+                        vk::PipelineBindPoint::eCompute,
+                        gatherLayout,
+                        0,
+                        {this->global_descriptor_set, this->voxel_chunk_descriptor_set},
+                        {});
+                    commandBuffer.pushConstants(
+                        gatherLayout,
+                        vk::ShaderStageFlagBits::eCompute,
+                        0,
+                        sizeof(u32),
+                        &numberOfDraws);
+                    commandBuffer.dispatch((numberOfDraws + 63) / 64, 1, 1);
+
+                    commandBuffer.pipelineBarrier(
+                        vk::PipelineStageFlagBits::eComputeShader,
+                        vk::PipelineStageFlagBits::eDrawIndirect,
+                        vk::DependencyFlags {},
+                        {vk::MemoryBarrier {
+                            .sType {vk::StructureType::eMemoryBarrier},
+                            .pNext {nullptr},
+                            .srcAccessMask {vk::AccessFlagBits::eShaderWrite},
+                            .dstAccessMask {vk::AccessFlagBits::eIndirectCommandRead},
+                        }},
+                        {},
+                        {});
                 }}};
 
         game::FrameGenerator::RecordObject chunkDraw = game::FrameGenerator::RecordObject {
@@ -1329,11 +1475,9 @@ namespace voxel
             .pipeline {this->voxel_chunk_render_pipeline},
             .descriptors {
                 {this->global_descriptor_set, this->voxel_chunk_descriptor_set, nullptr, nullptr}},
-            .record_func {[this, size = indirectCommands.size()](
+            .record_func {[this, size = visibleDraws.size()](
                               vk::CommandBuffer commandBuffer, vk::PipelineLayout layout, u32 id)
                           {
-                              commandBuffer.bindVertexBuffers(0, {*this->indirect_payload}, {0});
-
                               commandBuffer.pushConstants(
                                   layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(u32), &id);
 
@@ -1383,11 +1527,153 @@ namespace voxel
         return {preFrameUpdate, chunkDraw, visibilityDraw, colorCalculation, colorTransfer};
     }
 
+    u32 ChunkRenderManager::cullOccludedChunks(
+        const game::Camera& camera, std::vector<u8>& visibleDirections)
+    {
+        const glm::vec3 cameraPosition = camera.getPosition();
+
+        std::vector<std::pair<f32, u32>> occludingChunks {};
+
+        for (u32 chunkId = 0; chunkId < visibleDirections.size(); ++chunkId)
+        {
+            if (visibleDirections[chunkId] == 0
+                || this->cpu_chunk_data[chunkId].active_occluders.empty())
+            {
+                continue;
+            }
+
+            const glm::vec3 offset = this->chunk_bounds.getCenter(chunkId) - cameraPosition;
+
+            occludingChunks.push_back({glm::dot(offset, offset), chunkId});
+        }
+
+        const bool hasOccluders = !occludingChunks.empty();
+
+        if (hasOccluders)
+        {
+            const std::size_t numberOfOccludingChunks =
+                std::min(occludingChunks.size(), OcclusionCuller::MaxOccluders);
+
+            std::ranges::partial_sort(
+                occludingChunks,
+                occludingChunks.begin() + static_cast<std::ptrdiff_t>(numberOfOccludingChunks));
+
+            this->occlusion_culler.clear(
+                camera.getPerspectiveMatrix(*this->game, game::Transform {}));
+
+            for (std::size_t i = 0; i < numberOfOccludingChunks; ++i)
+            {
+                const u32       chunkId    = occludingChunks[i].second;
+                const f32       halfExtent = this->chunk_bounds.getHalfExtent(chunkId);
+                const glm::vec3 chunkMin   = this->chunk_bounds.getCenter(chunkId) - halfExtent;
+                const f32       brickWidth =
+                    (2.0f * halfExtent) / static_cast<f32>(BricksPerChunkEdge);
+
+                for (const BrickOccluder& o : this->cpu_chunk_data[chunkId].active_occluders)
+                {
+                    this->occlusion_culler.rasterizeOccluder(
+                        chunkMin + (glm::vec3 {o.min} * brickWidth),
+                        chunkMin + ((glm::vec3 {o.max} + 1.0f) * brickWidth));
+                }
+            }
+
+            this->occlusion_culler.buildHierarchy();
+        }
+
+        u32 numberOfChunksOccluded = 0;
+
+        for (u32 chunkId = 0; chunkId < visibleDirections.size(); ++chunkId)
+        {
+            if (visibleDirections[chunkId] == 0)
+            {
+                continue;
+            }
+
+            const glm::vec3 center     = this->chunk_bounds.getCenter(chunkId);
+            const f32       halfExtent = this->chunk_bounds.getHalfExtent(chunkId);
+
+            // Enclosed chunks, like caves, are found through the neighbour links alone, however
+            // far away they are
+            if (this->chunk_neighbours.isEnclosedFrom(chunkId, cameraPosition)
+                || (hasOccluders
+                    && this->occlusion_culler.isOccluded(
+                        center - halfExtent, center + halfExtent)))
+            {
+                visibleDirections[chunkId] = 0;
+                numberOfChunksOccluded += 1;
+            }
+        }
+
+        return numberOfChunksOccluded;
+    }
+
+    ChunkStorageLimits ChunkRenderManager::getChunkStorageLimits(const gfx::Renderer* renderer)
+    {
+        const gfx::vulkan::Allocator*           allocator        = renderer->getAllocator();
+        const VkPhysicalDeviceMemoryProperties* memoryProperties = nullptr;
+        vmaGetMemoryProperties(**allocator, &memoryProperties);
+
+        std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets {};
+        vmaGetHeapBudgets(**allocator, budgets.data());
+
+        VkDeviceSize deviceLocalBudget = 0;
+
+        for (u32 i = 0; i < memoryProperties->memoryHeapCount; ++i)
+        {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+            if (memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            {
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+                deviceLocalBudget = std::max(deviceLocalBudget, budgets[i].budget);
+            }
+        }
+
+        const u32 maxStorageBufferRange =
+            renderer->getDevice()->getPhysicalDevice().getProperties().limits.maxStorageBufferRange;
+
+        const ChunkStorageLimits limits =
+            calculateChunkStorageLimits(deviceLocalBudget, maxStorageBufferRange);
+
+        util::logLog(
+            "Chunk storage from a budget of {}MiB | Chunk data pages: {} | Bricks: {} | Faces: {}",
+            deviceLocalBudget >> 20U,
+            limits.number_of_chunk_data_pages,
+            limits.max_bricks,
+            limits.max_faces);
+
+        return limits;
+    }
+
+    const PerChunkGpuData& ChunkRenderManager::readChunkGpuData(u32 chunkId) const
+    {
+        return this->gpu_chunk_data_pages[chunkId / GpuChunksPerDataPage].read(
+            chunkId % GpuChunksPerDataPage);
+    }
+
+    void ChunkRenderManager::writeChunkGpuData(u32 chunkId, const PerChunkGpuData& data)
+    {
+        this->gpu_chunk_data_pages[chunkId / GpuChunksPerDataPage].write(
+            chunkId % GpuChunksPerDataPage, data);
+    }
+
+    ChunkLocation ChunkRenderManager::getChunkLocation(u32 chunkId) const
+    {
+        const PerChunkGpuData& gpuData = this->readChunkGpuData(chunkId);
+
+        return ChunkLocation {
+            glm::i32vec3 {
+                gpuData.world_offset_x,
+                gpuData.world_offset_y,
+                gpuData.world_offset_z,
+            },
+            gpuData.lod};
+    }
+
     boost::dynamic_bitset<u64> ChunkRenderManager::readShadow(
         const Chunk& chunk, std::span<const ChunkLocalPosition> positions)
     {
         const PerChunkGpuData& chunkGpuData =
-            this->gpu_chunk_data.read(this->chunk_id_allocator.getValueOfHandle(chunk));
+            this->readChunkGpuData(this->chunk_id_allocator.getValueOfHandle(chunk));
 
         boost::dynamic_bitset<u64> output {};
         output.resize(positions.size());
@@ -1398,17 +1684,16 @@ namespace voxel
 
             const auto [bC, bP] = splitChunkLocalPosition(p);
 
-            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-            const u16 maybeLocalOffset = chunkGpuData.data.data[bC.x][bC.y][bC.z];
+            const u16 maybeLocalOffset = chunkGpuData.data.getOffset(bC);
 
             if (maybeLocalOffset != decltype(chunkGpuData.data)::NullOffset)
             {
                 const u32 globalBrickOffset =
                     chunkGpuData.brick_allocation_offset + maybeLocalOffset;
 
-                const ShadowBrick& shadowBrick = this->shadow_bricks.read(globalBrickOffset);
+                const MaterialBrick& materialBrick = this->material_bricks.read(globalBrickOffset);
 
-                if (shadowBrick.read(bP))
+                if (getMaterialOpacity(materialBrick.read(bP)).casts_shadows)
                 {
                     output.set(i, true);
                 }
@@ -1418,4 +1703,14 @@ namespace voxel
         return output;
     }
 
+    const ChunkNeighbourGraph& ChunkRenderManager::getNeighbourGraph() const
+    {
+        return this->chunk_neighbours;
+    }
+
+    u32 ChunkRenderManager::getChunkId(const Chunk& chunk) const
+    {
+        return this->chunk_id_allocator.getValueOfHandle(chunk);
+    }
+
 } // namespace voxel
\ No newline at end of file
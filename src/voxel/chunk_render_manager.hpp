@@ -2,12 +2,20 @@
 
 #include "game/frame_generator.hpp"
 #include "gfx/profiler/task_generator.hpp"
+#include "chunk_bounds_table.hpp"
+#include "chunk_neighbour_graph.hpp"
+#include "chunk_storage_limits.hpp"
 #include "gfx/vulkan/buffer.hpp"
+#include "gpu_chunk_hash_table.hpp"
+#include "greedy_mesh_cache.hpp"
 #include "material_manager.hpp"
+#include "occlusion_culler.hpp"
 #include "structures.hpp"
+#include "util/lru_cache.hpp"
 #include "util/misc.hpp"
 #include "util/opaque_integer_handle.hpp"
 #include "util/range_allocator.hpp"
+#include "util/recycling_pool.hpp"
 #include <boost/dynamic_bitset.hpp>
 #include <semaphore>
 #include <source_location>
@@ -24,7 +32,7 @@ namespace voxel
     class ChunkRenderManager
     {
     public:
-        using Chunk          = util::OpaqueHandle<"voxel::ChunkRenderManager::Chunk", u16>;
+        using Chunk          = util::OpaqueHandle<"voxel::ChunkRenderManager::Chunk", u32>;
         using RaytracedLight = util::OpaqueHandle<"voxel::ChunkRenderManager::RaytracedLight", u16>;
     public:
         explicit ChunkRenderManager(const game::Game*);
@@ -39,14 +47,29 @@ namespace voxel
         [[nodiscard]] Chunk createChunk(ChunkLocation);
         void                destroyChunk(Chunk);
 
+        /// Generated chunks with nothing to draw never become a Chunk, they are only counted for
+        /// the debug menu
+        void addElidedChunk();
+        void removeElidedChunk();
+
         [[nodiscard]] RaytracedLight createRaytracedLight(GpuRaytracedLight);
         void                         destroyRaytracedLight(RaytracedLight);
 
+        [[nodiscard]] bool hasRecentlyDestroyedChunk(ChunkLocation) const;
+        /// If this chunk's location was recently destroyed with a complete mesh, that mesh is
+        /// reused and a future to when it is integrated is returned, otherwise nullptr.
+        /// A restored chunk needs no generation or meshing.
+        [[nodiscard]] std::shared_ptr<std::atomic_bool>
+        tryRestoreRecentlyDestroyedChunk(const Chunk&);
+
         // Returns a future to when the meshing of this chunk is actually completed
         std::shared_ptr<std::atomic_bool> updateChunk(
             const Chunk&,
             std::span<const ChunkLocalUpdate>,
             std::source_location = std::source_location::current());
+        /// Sets every voxel of the chunk at once, discarding any updates not yet meshed.
+        /// Returns a future to when the meshing of this chunk is actually completed
+        std::shared_ptr<std::atomic_bool> fillChunk(const Chunk&, Voxel);
 
         std::vector<game::FrameGenerator::RecordObject>
         processUpdatesAndGetDrawObjects(const game::Camera&, gfx::profiler::TaskGenerator&);
@@ -54,9 +77,29 @@ namespace voxel
         [[nodiscard]] boost::dynamic_bitset<u64>
         readShadow(const Chunk&, std::span<const ChunkLocalPosition>);
 
+        /// Neighbour links of every live chunk, indexed by getChunkId
+        [[nodiscard]] const ChunkNeighbourGraph& getNeighbourGraph() const;
+        [[nodiscard]] u32                        getChunkId(const Chunk&) const;
+
     private:
+        [[nodiscard]] ChunkLocation getChunkLocation(u32 chunkId) const;
+
+        [[nodiscard]] const PerChunkGpuData& readChunkGpuData(u32 chunkId) const;
+        void                                 writeChunkGpuData(u32 chunkId, const PerChunkGpuData&);
+
+        [[nodiscard]] static ChunkStorageLimits getChunkStorageLimits(const gfx::Renderer*);
+
+        /// Clears the directions of every chunk in visibleDirections that is entirely hidden
+        /// behind the occluders of the nearest visible chunks or enclosed by sealed neighbours,
+        /// returns how many were cleared
+        u32 cullOccludedChunks(const game::Camera&, std::vector<u8>& visibleDirections);
+
         const game::Game* game;
 
+        ChunkStorageLimits storage_limits;
+        u32                max_chunks;
+        u32                number_of_elided_chunks;
+
         // Global data
         gfx::vulkan::WriteOnlyBuffer<GlobalVoxelData> global_voxel_data;
 
@@ -65,25 +108,32 @@ namespace voxel
         gfx::vulkan::CpuCachedBuffer<GpuRaytracedLight> raytraced_lights;
 
         // Per Chunk Data
-        util::OpaqueHandleAllocator<Chunk>                   chunk_id_allocator;
-        std::vector<CpuChunkData>                            cpu_chunk_data;
-        gfx::vulkan::CpuCachedBuffer<PerChunkGpuData>        gpu_chunk_data;
-        bool                                                 does_chunk_hash_map_need_recreated;
-        gfx::vulkan::WriteOnlyBuffer<HashedGpuChunkLocation> aligned_chunk_hash_table_keys;
-        gfx::vulkan::WriteOnlyBuffer<u16> aligned_chunk_hash_table_values; // chunkId
-        static constexpr std::size_t      VramOverheadPerChunk =
-            sizeof(PerChunkGpuData) + sizeof(u32) + sizeof(u16);
+        util::OpaqueHandleAllocator<Chunk> chunk_id_allocator;
+        // Grows a page at a time as chunk ids are handed out
+        std::vector<CpuChunkData>          cpu_chunk_data;
+        GpuChunkHashTable                  chunk_hash_table;
+        ChunkBoundsTable                   chunk_bounds;
+        ChunkNeighbourGraph                chunk_neighbours;
+        OcclusionCuller                    occlusion_culler;
+
+        // Chunk i lives in page i / GpuChunksPerDataPage, so no single buffer has to be big
+        // enough for every chunk
+        std::vector<gfx::vulkan::CpuCachedBuffer<PerChunkGpuData>> gpu_chunk_data_pages;
+
+        // Final meshes of destroyed chunks, lets lod transitions that revert skip generation
+        util::LruCache<ChunkLocation, ChunkAsyncMesh> recently_destroyed_chunk_cache;
+        // Shared with in flight meshing tasks, which may outlive this
+        std::shared_ptr<GreedyMeshCache>                      greedy_mesh_cache;
+        // Integrated meshes are released here and their storage reused by the next meshing tasks
+        std::shared_ptr<util::RecyclingPool<ChunkAsyncMesh>> mesh_pool;
 
         // Per Brick Data
         util::RangeAllocator                                 brick_range_allocator;
         gfx::vulkan::WriteOnlyBuffer<BrickParentInformation> per_brick_chunk_parent_info;
         gfx::vulkan::CpuCachedBuffer<MaterialBrick>          material_bricks;
-        gfx::vulkan::CpuCachedBuffer<ShadowBrick>            shadow_bricks;
+        // Derived from material_bricks when meshing, never read back on the cpu
+        gfx::vulkan::WriteOnlyBuffer<ShadowBrick>            shadow_bricks;
         gfx::vulkan::WriteOnlyBuffer<VisibilityBrick>        visibility_bricks;
-        std::vector<PrimaryRayBrick>                         primary_ray_bricks;
-        static constexpr std::size_t                         VramOverheadPerBrick =
-            sizeof(BrickParentInformation) + sizeof(MaterialBrick) + sizeof(ShadowBrick)
-            + sizeof(PrimaryRayBrick) + sizeof(VisibilityBrick);
 
         // Greedily Meshed Voxel Data
         util::RangeAllocator                          voxel_face_allocator;
@@ -93,18 +143,18 @@ namespace voxel
         gfx::vulkan::WriteOnlyBuffer<VisibleFaceData>                  visible_face_data;
 
         // Actual Draw Data
-        struct ChunkDrawIndirectInstancePayload
-        {
-            u32 normal;
-            u32 chunk_id;
-        };
-        gfx::vulkan::WriteOnlyBuffer<ChunkDrawIndirectInstancePayload> indirect_payload;
-        gfx::vulkan::WriteOnlyBuffer<vk::DrawIndirectCommand>          indirect_commands;
+        // Index chunkId * 6 + direction, only rewritten when a chunk is remeshed
+        gfx::vulkan::CpuCachedBuffer<vk::DrawIndirectCommand> chunk_direction_draws;
+        // Rebuilt each frame, expanded into indirect_commands by voxel_draw_gather_pipeline
+        gfx::vulkan::WriteOnlyBuffer<u32>                     visible_chunk_draws;
+        gfx::vulkan::WriteOnlyBuffer<vk::DrawIndirectCommand> explicit_chunk_draws;
+        gfx::vulkan::WriteOnlyBuffer<vk::DrawIndirectCommand> indirect_commands;
 
         gfx::vulkan::WriteOnlyBuffer<VoxelMaterial> materials;
 
         std::shared_ptr<vk::UniqueDescriptorSetLayout> voxel_chunk_descriptor_set_layout;
 
+        std::shared_ptr<vk::UniquePipeline> voxel_draw_gather_pipeline;
         std::shared_ptr<vk::UniquePipeline> voxel_chunk_render_pipeline;
         std::shared_ptr<vk::UniquePipeline> voxel_visibility_pipeline;
         std::shared_ptr<vk::UniquePipeline> voxel_color_calculation_pipeline;
@@ -0,0 +1,51 @@
+#include "chunk_storage_limits.hpp"
+#include "shaders/include/common.glsl"
+#include "util/log.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace voxel
+{
+    namespace
+    {
+        // Enough to mesh a handful of chunks even on the smallest budget
+        constexpr u64 MinBricks = 1U << 12U;
+        constexpr u64 MinFaces  = 1U << 16U;
+
+        // Every chunk id of every page must fit in a brick's parent info
+        static_assert(
+            GpuMaxChunkDataPages * GpuChunksPerDataPage <= (1U << GpuBrickParentChunkBits));
+
+        u32 getCountInShare(u64 bytes, std::size_t bytesPerElement, u64 min, u64 max)
+        {
+            util::assertFatal(min <= max, "Storage minimum {} is above its maximum {}", min, max);
+
+            return static_cast<u32>(std::clamp<u64>(bytes / bytesPerElement, min, max));
+        }
+    } // namespace
+
+    ChunkStorageLimits calculateChunkStorageLimits(u64 deviceLocalBudget, u64 maxStorageBufferRange)
+    {
+        // Each brick kind and the faces get their own buffer, the material bricks are the largest
+        const u64 maxBricksInBuffer = maxStorageBufferRange / sizeof(MaterialBrick);
+        const u64 maxFacesInBuffer  = maxStorageBufferRange / sizeof(GreedyVoxelFace);
+
+        return ChunkStorageLimits {
+            .number_of_chunk_data_pages {getCountInShare(
+                deviceLocalBudget / 16,
+                VramPerChunk * GpuChunksPerDataPage,
+                1,
+                GpuMaxChunkDataPages)},
+            .max_bricks {getCountInShare(
+                deviceLocalBudget / 4,
+                VramPerBrick,
+                MinBricks,
+                std::min(u64 {1} << GpuBrickPointerBits, maxBricksInBuffer))},
+            .max_faces {getCountInShare(
+                deviceLocalBudget / 16,
+                VramPerFace,
+                MinFaces,
+                std::min(u64 {std::numeric_limits<u32>::max()}, maxFacesInBuffer))},
+        };
+    }
+} // namespace voxel
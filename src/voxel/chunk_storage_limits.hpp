@@ -0,0 +1,31 @@
+#pragma once
+
+#include "structures.hpp"
+#include "util/misc.hpp"
+#include <cstddef>
+
+namespace voxel
+{
+    /// How many of each kind of chunk storage the gpu buffers are created with, chosen once at
+    /// startup from the device's memory budget
+    struct ChunkStorageLimits
+    {
+        // Chunk capacity is a whole number of pages
+        u32 number_of_chunk_data_pages;
+        u32 max_bricks;
+        u32 max_faces;
+    };
+
+    inline constexpr std::size_t VramPerChunk =
+        sizeof(PerChunkGpuData) + sizeof(Gpu_ChunkLocation) + sizeof(u32);
+    inline constexpr std::size_t VramPerBrick = sizeof(BrickParentInformation)
+                                              + sizeof(MaterialBrick) + sizeof(ShadowBrick)
+                                              + sizeof(VisibilityBrick);
+    inline constexpr std::size_t VramPerFace  = sizeof(GreedyVoxelFace);
+
+    /// Per chunk data and faces may each take up to a sixteenth of the budget and bricks a
+    /// quarter. Never more than the shaders can address or than fits in one storage buffer of
+    /// maxStorageBufferRange bytes, never less than enough for a few chunks.
+    [[nodiscard]] ChunkStorageLimits
+    calculateChunkStorageLimits(u64 deviceLocalBudget, u64 maxStorageBufferRange);
+} // namespace voxel
@@ -0,0 +1,90 @@
+#include "gpu_chunk_hash_table.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace voxel
+{
+    GpuChunkHashTable::GpuChunkHashTable(const gfx::vulkan::Allocator* allocator)
+        : keys(
+              allocator,
+              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+              vk::MemoryPropertyFlagBits::eDeviceLocal,
+              GpuChunkHashTableCapacity,
+              "Aligned Chunk Hash Table Keys")
+        , values(
+              allocator,
+              vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+              vk::MemoryPropertyFlagBits::eDeviceLocal,
+              GpuChunkHashTableCapacity,
+              "Aligned Chunk Hash Table Values")
+        , has_uploaded_values {false}
+    {}
+
+    bool GpuChunkHashTable::insert(ChunkLocation location, u32 chunkId)
+    {
+        return this->table.insert(location, chunkId);
+    }
+
+    void GpuChunkHashTable::erase(ChunkLocation location, u32 chunkId)
+    {
+        this->table.erase(location, chunkId);
+    }
+
+    const ChunkHashTable& GpuChunkHashTable::getTable() const
+    {
+        return this->table;
+    }
+
+    void GpuChunkHashTable::flushViaStager(const gfx::vulkan::BufferStager& stager)
+    {
+        std::vector<u32> changedSlots = this->table.takeChangedSlots();
+
+        const std::span<const Gpu_ChunkLocation> tableKeys   = this->table.getKeys();
+        const std::span<const u32>               tableValues = this->table.getValues();
+
+        // Every value has to be uploaded once, so that empty slots read as empty. The key of an
+        // empty slot is never read.
+        if (!this->has_uploaded_values)
+        {
+            stager.enqueueTransfer(this->values, 0, tableValues);
+
+            this->has_uploaded_values = true;
+        }
+
+        std::ranges::sort(changedSlots);
+        const auto [firstRepeat, end] = std::ranges::unique(changedSlots);
+        changedSlots.erase(firstRepeat, end);
+
+        // Neighbouring slots are often written together, upload them as one run
+        for (std::size_t runStart = 0; runStart < changedSlots.size();)
+        {
+            std::size_t runEnd = runStart + 1;
+
+            while (runEnd < changedSlots.size()
+                   && changedSlots[runEnd] == changedSlots[runEnd - 1] + 1)
+            {
+                runEnd += 1;
+            }
+
+            const u32         firstSlot     = changedSlots[runStart];
+            const std::size_t numberOfSlots = runEnd - runStart;
+
+            stager.enqueueTransfer(
+                this->keys, firstSlot, tableKeys.subspan(firstSlot, numberOfSlots));
+            stager.enqueueTransfer(
+                this->values, firstSlot, tableValues.subspan(firstSlot, numberOfSlots));
+
+            runStart = runEnd;
+        }
+    }
+
+    vk::Buffer GpuChunkHashTable::getKeyBuffer() const
+    {
+        return *this->keys;
+    }
+
+    vk::Buffer GpuChunkHashTable::getValueBuffer() const
+    {
+        return *this->values;
+    }
+} // namespace voxel
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "chunk_hash_table.hpp"
+#include "gfx/vulkan/buffer.hpp"
+#include "structures.hpp"
+#include "util/misc.hpp"
+#include <vulkan/vulkan_handles.hpp>
+
+namespace voxel
+{
+    /// ChunkHashTable along with the gpu buffers that shaders search with ChunkHashTable_load
+    class GpuChunkHashTable
+    {
+    public:
+        explicit GpuChunkHashTable(const gfx::vulkan::Allocator*);
+        ~GpuChunkHashTable() = default;
+
+        GpuChunkHashTable(const GpuChunkHashTable&)             = delete;
+        GpuChunkHashTable(GpuChunkHashTable&&)                  = default;
+        GpuChunkHashTable& operator= (const GpuChunkHashTable&) = delete;
+        GpuChunkHashTable& operator= (GpuChunkHashTable&&)      = delete;
+
+        /// See ChunkHashTable::insert, false if the location was refused
+        [[nodiscard]] bool insert(ChunkLocation, u32 chunkId);
+        void               erase(ChunkLocation, u32 chunkId);
+
+        [[nodiscard]] const ChunkHashTable& getTable() const;
+
+        /// Uploads only the slots that changed since the last flush
+        void flushViaStager(const gfx::vulkan::BufferStager&);
+
+        [[nodiscard]] vk::Buffer getKeyBuffer() const;
+        [[nodiscard]] vk::Buffer getValueBuffer() const;
+
+    private:
+        ChunkHashTable                                  table;
+        gfx::vulkan::WriteOnlyBuffer<Gpu_ChunkLocation> keys;
+        gfx::vulkan::WriteOnlyBuffer<u32>               values;
+        bool                                            has_uploaded_values;
+    };
+} // namespace voxel
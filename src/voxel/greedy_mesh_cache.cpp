@@ -0,0 +1,161 @@
+#include "greedy_mesh_cache.hpp"
+#include <bit>
+
+namespace voxel
+{
+    namespace
+    {
+        // splitmix64's finalizer, every input bit affects every output bit
+        constexpr u64 finalizeHash(u64 h)
+        {
+            h ^= h >> 30;
+            h *= 0xbf58476d1ce4e5b9;
+            h ^= h >> 27;
+            h *= 0x94d049bb133111eb;
+            h ^= h >> 31;
+
+            return h;
+        }
+
+        struct HashLane
+        {
+            u64 state;
+            u64 multiplier;
+            int rotation;
+
+            void add(u64 word)
+            {
+                this->state = std::rotl(this->state ^ (word * this->multiplier), this->rotation)
+                            * 0x9e3779b97f4a7c15;
+            }
+        };
+
+        std::size_t getGreedyMeshCost(
+            const std::array<std::vector<GreedyVoxelFace>, 6>&   faces,
+            const std::array<std::vector<GreedyFaceCluster>, 6>& clusters)
+        {
+            std::size_t cost = sizeof(GreedyMesh);
+
+            for (std::size_t normal = 0; normal < 6; ++normal)
+            {
+                cost += faces[normal].size() * sizeof(GreedyVoxelFace);
+                cost += clusters[normal].size() * sizeof(GreedyFaceCluster);
+            }
+
+            return cost;
+        }
+    } // namespace
+
+    GreedyMeshCache::GreedyMeshCache(std::size_t maxBytes)
+        : max_bytes {maxBytes}
+        , cache {util::LruCache<Key, GreedyMesh, KeyHasher> {maxBytes}}
+        , number_of_hits {0}
+        , number_of_misses {0}
+    {}
+
+    GreedyMeshCache::Key
+    GreedyMeshCache::hashContents(std::span<const std::pair<BrickCoordinate, BitBrick>> bricks)
+    {
+        HashLane low {
+            .state {0x243f6a8885a308d3}, .multiplier {0x87c37b91114253d5}, .rotation {31}};
+        HashLane high {
+            .state {0x13198a2e03707344}, .multiplier {0x4cf5ad432745937f}, .rotation {33}};
+        u64 numberOfHashedBricks = 0;
+
+        for (const auto& [coordinate, brick] : bricks)
+        {
+            if (brick.isEmpty())
+            {
+                continue;
+            }
+
+            low.add(coordinate.asLinearIndex());
+            high.add(coordinate.asLinearIndex());
+
+            for (std::size_t i = 0; i < brick.data.size(); i += 2)
+            {
+                const u64 word = (u64 {brick.data[i + 1]} << 32) | brick.data[i];
+
+                low.add(word);
+                high.add(word);
+            }
+
+            numberOfHashedBricks += 1;
+        }
+
+        return Key {
+            .low {finalizeHash(low.state ^ numberOfHashedBricks)},
+            .high {finalizeHash(high.state ^ numberOfHashedBricks)}};
+    }
+
+    bool GreedyMeshCache::find(
+        const Key&                                     key,
+        std::array<std::vector<GreedyVoxelFace>, 6>&   outFaces,
+        std::array<std::vector<GreedyFaceCluster>, 6>& outClusters) const
+    {
+        const bool isHit = this->cache.lock(
+            [&](util::LruCache<Key, GreedyMesh, KeyHasher>& c)
+            {
+                // Also moves it to the front so that commonly repeated contents stay cached
+                const GreedyMesh* const maybeMesh = c.find(key);
+
+                if (maybeMesh == nullptr)
+                {
+                    return false;
+                }
+
+                for (std::size_t normal = 0; normal < 6; ++normal)
+                {
+                    outFaces[normal].assign(
+                        maybeMesh->faces[normal].cbegin(), maybeMesh->faces[normal].cend());
+                    outClusters[normal].assign(
+                        maybeMesh->clusters[normal].cbegin(), maybeMesh->clusters[normal].cend());
+                }
+
+                return true;
+            });
+
+        if (isHit)
+        {
+            this->number_of_hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            this->number_of_misses.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return isHit;
+    }
+
+    void GreedyMeshCache::insert(
+        const Key&                                           key,
+        const std::array<std::vector<GreedyVoxelFace>, 6>&   faces,
+        const std::array<std::vector<GreedyFaceCluster>, 6>& clusters) const
+    {
+        const std::size_t cost = getGreedyMeshCost(faces, clusters);
+
+        // The cache would only drop it again, don't bother copying it
+        if (cost > this->max_bytes)
+        {
+            return;
+        }
+
+        GreedyMesh mesh {.faces {faces}, .clusters {clusters}};
+
+        this->cache.lock(
+            [&](util::LruCache<Key, GreedyMesh, KeyHasher>& c)
+            {
+                c.insert(key, std::move(mesh), cost);
+            });
+    }
+
+    u32 GreedyMeshCache::getNumberOfHits() const
+    {
+        return this->number_of_hits.load(std::memory_order_relaxed);
+    }
+
+    u32 GreedyMeshCache::getNumberOfMisses() const
+    {
+        return this->number_of_misses.load(std::memory_order_relaxed);
+    }
+} // namespace voxel
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "structures.hpp"
+#include "util/lru_cache.hpp"
+#include "util/misc.hpp"
+#include "util/threads.hpp"
+#include <array>
+#include <atomic>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace voxel
+{
+    /// Everything meshChunkGreedy and clusterGreedyFaces produce for one chunk
+    struct GreedyMesh
+    {
+        std::array<std::vector<GreedyVoxelFace>, 6>   faces;
+        std::array<std::vector<GreedyFaceCluster>, 6> clusters;
+    };
+
+    /// Bounded cache of greedy meshes keyed by a hash of the bricks they were meshed from, so
+    /// that the many chunks with identical contents (solid stone, flat ground, open ocean) are
+    /// only meshed once. Threadsafe.
+    class GreedyMeshCache
+    {
+    public:
+        /// 128 bit hash from two independently seeded lanes, so that different contents
+        /// practically never collide
+        struct Key
+        {
+            u64 low;
+            u64 high;
+
+            bool operator== (const Key&) const = default;
+        };
+    public:
+        explicit GreedyMeshCache(std::size_t maxBytes);
+
+        /// Bricks without any filled voxels don't change the mesh, so they don't change the key
+        [[nodiscard]] static Key
+        hashContents(std::span<const std::pair<BrickCoordinate, BitBrick>> bricks);
+
+        /// Copies the cached mesh into the outputs, reusing their storage. Counts as a hit or a
+        /// miss.
+        [[nodiscard]] bool find(
+            const Key&,
+            std::array<std::vector<GreedyVoxelFace>, 6>&   outFaces,
+            std::array<std::vector<GreedyFaceCluster>, 6>& outClusters) const;
+        void insert(
+            const Key&,
+            const std::array<std::vector<GreedyVoxelFace>, 6>&   faces,
+            const std::array<std::vector<GreedyFaceCluster>, 6>& clusters) const;
+
+        [[nodiscard]] u32 getNumberOfHits() const;
+        [[nodiscard]] u32 getNumberOfMisses() const;
+
+    private:
+        struct KeyHasher
+        {
+            std::size_t operator() (const Key& key) const
+            {
+                return static_cast<std::size_t>(key.low);
+            }
+        };
+
+        std::size_t                                             max_bytes;
+        util::Mutex<util::LruCache<Key, GreedyMesh, KeyHasher>> cache;
+        mutable std::atomic<u32>                                 number_of_hits;
+        mutable std::atomic<u32>                                 number_of_misses;
+    };
+} // namespace voxel
@@ -5,45 +5,77 @@
 #include <chrono>
 #include <future>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace voxel
 {
 
     LazilyGeneratedChunk::LazilyGeneratedChunk(
-        util::ThreadPool&                pool,
+        util::ThreadPool&                pool_,
         util::Mutex<ChunkRenderManager>* chunkRenderManager,
         world::WorldGenerator*           worldGenerator,
-        voxel::ChunkLocation             location)
-        : chunk_render_manager {chunkRenderManager}
-        , chunk {this->chunk_render_manager->lock(
-              [&](ChunkRenderManager& manager)
-              {
-                  return manager.createChunk(location);
-              })}
+        voxel::ChunkLocation             location_,
+        ChunkPrefetcher*                 prefetcher)
+        : pool {&pool_}
+        , chunk_render_manager {chunkRenderManager}
+        , world_generator {worldGenerator}
+        , location {location_}
         , should_still_generate(std::make_shared<std::atomic<bool>>(true))
-        , updates {pool.executeOnPool(
-              [wg  = worldGenerator,
-               loc = location,
-               shouldGeneratePtr =
-                   this->should_still_generate]() -> std::vector<voxel::ChunkLocalUpdate>
-              {
-                  if (shouldGeneratePtr->load(std::memory_order_acquire))
-                  {
-                      return wg->generateChunk(loc);
-                  }
-                  else
-                  {
-                      return {};
-                  }
-              })}
-        , is_meshing_complete {std::make_shared<std::atomic_bool>(false)}
-    {}
+        , is_meshing_complete {nullptr}
+    {
+        // Chunks are only given to the render manager once we know they have a surface, unless
+        // there's a recently destroyed one at this location we can take the mesh of
+        this->chunk_render_manager->lock(
+            [&](ChunkRenderManager& manager)
+            {
+                if (manager.hasRecentlyDestroyedChunk(this->location))
+                {
+                    this->chunk = manager.createChunk(this->location);
+                    this->is_meshing_complete =
+                        manager.tryRestoreRecentlyDestroyedChunk(this->chunk);
+                    this->contents = world::ChunkContents::Surface;
+                }
+            });
+
+        // A recently destroyed chunk at this location had its mesh restored, nothing to generate
+        if (this->is_meshing_complete != nullptr)
+        {
+            return;
+        }
+
+        if (prefetcher != nullptr)
+        {
+            if (std::optional<ChunkPrefetcher::PrefetchedChunk> prefetched =
+                    prefetcher->take(this->location))
+            {
+                this->should_still_generate = std::move(prefetched->should_still_generate);
+                this->updates               = std::move(prefetched->updates);
+
+                return;
+            }
+        }
+
+        this->generateOnPool(true);
+    }
 
     LazilyGeneratedChunk::~LazilyGeneratedChunk()
     {
+        // null if we've been moved from
         if (this->should_still_generate != nullptr)
         {
             this->should_still_generate->store(false, std::memory_order_release);
+
+            if (this->contents == world::ChunkContents::Empty
+                || this->contents == world::ChunkContents::Buried)
+            {
+                this->chunk_render_manager->lock(
+                    [](ChunkRenderManager& manager)
+                    {
+                        manager.removeElidedChunk();
+                    });
+            }
         }
 
         if (this->updates.valid())
@@ -69,29 +101,125 @@ namespace voxel
         {
             updatesOcurred += 1;
 
-            std::vector<voxel::ChunkLocalUpdate> realUpdates = this->updates.get();
+            world::GeneratedChunk generated = this->updates.get();
 
-            if (!realUpdates.empty())
+            this->contents = generated.contents;
+
+            if (generated.contents == world::ChunkContents::Surface
+                || generated.contents == world::ChunkContents::Solid)
             {
                 this->is_meshing_complete = this->chunk_render_manager->lock(
                     [&](ChunkRenderManager& manager)
                     {
-                        return manager.updateChunk(this->chunk, realUpdates);
+                        this->chunk = manager.createChunk(this->location);
+
+                        std::shared_ptr<std::atomic_bool> isMeshed =
+                            generated.contents == world::ChunkContents::Solid
+                                ? manager.fillChunk(this->chunk, generated.fill)
+                                : manager.updateChunk(this->chunk, generated.updates);
+
+                        // Meshed along with the generated voxels
+                        if (!this->pending_updates.empty())
+                        {
+                            isMeshed = manager.updateChunk(
+                                this->chunk, std::exchange(this->pending_updates, {}));
+                        }
+
+                        return isMeshed;
                     });
             }
             else
             {
+                // Nothing to see, this chunk lives only in the octree
+                this->chunk_render_manager->lock(
+                    [](ChunkRenderManager& manager)
+                    {
+                        manager.addElidedChunk();
+                    });
+
                 this->is_meshing_complete = std::make_shared<std::atomic_bool>(true);
+
+                if (!this->pending_updates.empty())
+                {
+                    this->materializeElidedChunk();
+                }
             }
         }
 
         if (!extraUpdates.empty() && extraUpdates.data() != nullptr)
         {
-            this->chunk_render_manager->lock(
-                [&](ChunkRenderManager& manager)
+            if (this->chunk.isNull())
+            {
+                this->pending_updates.append_range(extraUpdates);
+
+                // Otherwise they're applied once generation finishes
+                if (this->contents.has_value())
                 {
-                    manager.updateChunk(this->chunk, extraUpdates);
-                });
+                    this->materializeElidedChunk();
+                }
+            }
+            else
+            {
+                this->chunk_render_manager->lock(
+                    [&](ChunkRenderManager& manager)
+                    {
+                        manager.updateChunk(this->chunk, extraUpdates);
+                    });
+            }
+        }
+    }
+
+    void LazilyGeneratedChunk::generateOnPool(bool shouldElideBuried)
+    {
+        this->updates = this->pool->executeOnPool(
+            [wg                = this->world_generator,
+             loc               = this->location,
+             shouldGeneratePtr = this->should_still_generate,
+             shouldElideBuried]() -> world::GeneratedChunk
+            {
+                if (!shouldGeneratePtr->load(std::memory_order_acquire))
+                {
+                    return {};
+                }
+
+                return shouldElideBuried ? wg->generateChunk(loc) : wg->generateChunkVoxels(loc);
+            });
+    }
+
+    void LazilyGeneratedChunk::materializeElidedChunk()
+    {
+        util::assertFatal(
+            this->contents == world::ChunkContents::Empty
+                || this->contents == world::ChunkContents::Buried,
+            "Tried to materialize a chunk that wasn't elided");
+
+        const bool isBuried = this->contents == world::ChunkContents::Buried;
+
+        this->chunk_render_manager->lock(
+            [&](ChunkRenderManager& manager)
+            {
+                manager.removeElidedChunk();
+
+                // An empty chunk has nothing to restore and can take the updates right away
+                if (!isBuried)
+                {
+                    this->chunk = manager.createChunk(this->location);
+                    this->is_meshing_complete =
+                        manager.updateChunk(this->chunk, std::exchange(this->pending_updates, {}));
+                }
+            });
+
+        if (isBuried)
+        {
+            // But a buried one needs all of its voxels back first, which is far too slow for the
+            // caller's thread. Nothing of it can be seen meanwhile, so it stays fully loaded.
+            this->contents = std::nullopt;
+
+            this->generateOnPool(false);
+        }
+        else
+        {
+            this->contents = world::ChunkContents::Surface;
         }
     }
 
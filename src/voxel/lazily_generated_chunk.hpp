@@ -1,8 +1,12 @@
 #pragma once
 
 #include "util/thread_pool.hpp"
+#include "voxel/chunk_prefetcher.hpp"
 #include "voxel/chunk_render_manager.hpp"
 #include "world/generator.hpp"
+#include <optional>
+#include <vector>
+
 namespace voxel
 {
     class LazilyGeneratedChunk
@@ -12,7 +16,8 @@ namespace voxel
             util::ThreadPool&,
             util::Mutex<ChunkRenderManager>*,
             world::WorldGenerator*,
-            voxel::ChunkLocation);
+            voxel::ChunkLocation,
+            ChunkPrefetcher* = nullptr);
         ~LazilyGeneratedChunk();
 
         LazilyGeneratedChunk(const LazilyGeneratedChunk&)             = delete;
@@ -36,17 +41,37 @@ namespace voxel
 
         [[nodiscard]] bool isFullyLoaded() const;
 
+        /// Null until generation has found something to draw and for chunks that were elided
+        /// as empty or buried, which have no render manager resources at all
         [[nodiscard]] const ChunkRenderManager::Chunk* getChunk() const
         {
-            return &this->chunk;
+            return this->chunk.isNull() ? nullptr : &this->chunk;
+        }
+
+        /// nullopt until generation has finished
+        [[nodiscard]] std::optional<world::ChunkContents> getContents() const
+        {
+            return this->contents;
         }
 
     private:
+        /// Starts generating on the pool, only the first generation may elide a buried chunk
+        void generateOnPool(bool shouldElideBuried);
+        /// Gives an elided chunk render manager resources so that pending_updates can be
+        /// applied, a buried one has its voxels generated on the pool first
+        void materializeElidedChunk();
+
+        const util::ThreadPool*            pool;
         util::Mutex<ChunkRenderManager>*   chunk_render_manager;
+        world::WorldGenerator*             world_generator;
+        voxel::ChunkLocation               location;
         ChunkRenderManager::Chunk          chunk;
         std::shared_ptr<std::atomic<bool>> should_still_generate;
 
-        std::future<std::vector<voxel::ChunkLocalUpdate>> updates;
-        std::shared_ptr<std::atomic_bool>                 is_meshing_complete;
+        std::future<world::GeneratedChunk>  updates;
+        std::shared_ptr<std::atomic_bool>   is_meshing_complete;
+        std::optional<world::ChunkContents> contents;
+        // Updates that arrived while there was no chunk to apply them to
+        std::vector<voxel::ChunkLocalUpdate> pending_updates;
     };
 } // namespace voxel
\ No newline at end of file
@@ -3,16 +3,21 @@
 #include "game/game.hpp"
 #include "gfx/profiler/task_generator.hpp"
 #include "shaders/include/common.glsl"
-#include "util/object_pool.hpp"
 #include "voxel/chunk_render_manager.hpp"
 #include "voxel/lazily_generated_chunk.hpp"
 #include "voxel/structures.hpp"
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstddef>
 #include <future>
+#include <glm/common.hpp>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <random>
+#include <span>
+#include <vector>
 
 namespace voxel
 {
@@ -20,140 +25,426 @@ namespace voxel
         util::ThreadPool&                threadPool,
         util::Mutex<ChunkRenderManager>* chunkRenderManager,
         world::WorldGenerator*           worldGenerator,
+        ChunkPrefetcher*                 chunkPrefetcher,
         u32                              dimension)
-        : node_pool {4096, 65536}
-        , root {
-              voxel::ChunkLocation {Gpu_ChunkLocation {
-                  .root_position {glm::ivec3 {
-                      -static_cast<i32>(dimension / 2),
-                      -static_cast<i32>(dimension / 2),
-                      -static_cast<i32>(dimension / 2),
-                  }},
-                  .lod {calculateLODBasedOnDistance(static_cast<f32>(dimension))},
+        : prefetcher {chunkPrefetcher}
+        , root_location {Gpu_ChunkLocation {
+              .root_position {glm::ivec3 {
+                  -static_cast<i32>(dimension / 2),
+                  -static_cast<i32>(dimension / 2),
+                  -static_cast<i32>(dimension / 2),
               }},
-              threadPool,
-              chunkRenderManager,
-              worldGenerator}
+              .lod {calculateLODBasedOnDistance(static_cast<f32>(dimension))},
+          }}
+        , viewpoint_travel {0.0}
+        , viewpoint_set_generation {0}
+    {
+        this->nodes.push_back(NodeRecord {.morton_key {RootKey}});
+        this->node_chunks.emplace_back(
+            std::in_place,
+            threadPool,
+            chunkRenderManager,
+            worldGenerator,
+            this->root_location,
+            this->prefetcher);
+        this->node_extended_chunks.emplace_back();
+    }
+
+    VoxelChunkOctree::~VoxelChunkOctree()
+    {
+        // Stop all outstanding generation up front so that we don't wait on them one by one
+        for (std::optional<LazilyGeneratedChunk>& c : this->node_chunks)
+        {
+            if (c.has_value())
+            {
+                c->markShouldNotGenerate();
+            }
+        }
 
-    {}
+        for (std::optional<LazilyGeneratedChunk>& c : this->node_extended_chunks)
+        {
+            if (c.has_value())
+            {
+                c->markShouldNotGenerate();
+            }
+        }
+    }
 
     void VoxelChunkOctree::update(
-        const game::Camera&              camera,
+        std::span<const LodViewpoint>    viewpoints,
         util::ThreadPool&                threadPool,
         util::Mutex<ChunkRenderManager>* chunkRenderManager,
         world::WorldGenerator*           worldGenerator)
     {
-        this->root.update(camera, threadPool, chunkRenderManager, worldGenerator, &this->node_pool);
+        bool hasViewpointSetChanged = viewpoints.size() != this->previous_viewpoints.size();
+        f32  maxWeightedTravel      = 0.0f;
+
+        for (std::size_t i = 0; i < viewpoints.size() && !hasViewpointSetChanged; ++i)
+        {
+            const LodViewpoint& now  = viewpoints[i];
+            const LodViewpoint& prev = this->previous_viewpoints[i];
+
+            if (now.weight != prev.weight) // NOLINT(clang-diagnostic-float-equal)
+            {
+                hasViewpointSetChanged = true;
+            }
+            else
+            {
+                maxWeightedTravel = std::max(
+                    maxWeightedTravel, glm::distance(now.position, prev.position) / now.weight);
+            }
+        }
+
+        if (hasViewpointSetChanged)
+        {
+            // stable radii were computed against a different set of viewpoints, revisit
+            // everything
+            this->viewpoint_set_generation += 1;
+        }
+        else
+        {
+            // A node's weighted distance can change by at most the furthest weighted distance
+            // any single viewpoint moved
+            this->viewpoint_travel += static_cast<f64>(maxWeightedTravel);
+        }
+
+        this->previous_viewpoints.assign(viewpoints.begin(), viewpoints.end());
+
+        this->updateNode(
+            RootNode,
+            this->root_location,
+            viewpoints,
+            threadPool,
+            chunkRenderManager,
+            worldGenerator);
     }
 
-    void VoxelChunkOctree::Node::update( // NOLINT(misc-no-recursion)
-        const game::Camera&              camera,
+    void VoxelChunkOctree::prefetch(std::span<const LodViewpoint> predictedViewpoints)
+    {
+        std::vector<voxel::ChunkLocation> targets {};
+
+        this->collectPrefetchTargets(RootNode, this->root_location, predictedViewpoints, targets);
+
+        this->prefetcher->setPrefetchTargets(targets);
+    }
+
+    void VoxelChunkOctree::updateNode( // NOLINT(misc-no-recursion)
+        NodeIndex                        node,
+        voxel::ChunkLocation             location,
+        std::span<const LodViewpoint>    viewpoints,
         util::ThreadPool&                threadPool,
         util::Mutex<ChunkRenderManager>* chunkRenderManager,
-        world::WorldGenerator*           worldGenerator,
-        util::ObjectPool<Node>*          nodePool)
+        world::WorldGenerator*           worldGenerator)
     {
-        const u32 desiredLOD = calculateLODBasedOnDistance(
-            glm::distance(
-                camera.getPosition(),
-                static_cast<glm::f32vec3>(this->entire_bounds.getCenterPosition()))
-            / 2.0f);
+        // Careful, this->nodes may be reallocated by anything that allocates children, only
+        // ever hold indices across those calls
 
-        if (this->payload.index() == 0)
+        // Nothing in this subtree is waiting on work and no viewpoint has left the band in
+        // which every node below us would keep its current lod, there's nothing to do
+        if (this->nodes[node].number_of_unloaded_leaves == 0 && !this->hasLifetimeExtension(node)
+            && this->nodes[node].last_update_generation == this->viewpoint_set_generation
+            && this->nodes[node].getRemainingStableDistance(this->viewpoint_travel) > 0.0f)
         {
-            LazilyGeneratedChunk* const chunk = std::get_if<0>(&this->payload);
+            return;
+        }
+
+        const f32 distanceToViewpoints = getWeightedDistance(
+            viewpoints, static_cast<glm::f32vec3>(location.getCenterPosition()));
 
-            if (this->entire_bounds.lod > desiredLOD)
+        const f32 splitDistance = getSplitDistance(location.lod);
+        const f32 mergeDistance = getMergeDistance(location.lod);
+
+        if (this->nodes[node].first_child == NullNode)
+        {
+            if (distanceToViewpoints < splitDistance)
             {
-                std::array<util::ObjectPool<Node>::UniqueT, 8> newChildren {};
-                std::array<glm::ivec3, 8>                      newChildrenRoots =
-                    generateChildrenRootPositions(this->entire_bounds);
+                this->dropLifetimeExtension(node);
 
-                for (std::size_t i = 0; i < 8; ++i)
-                {
-                    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-                    newChildren[i] = nodePool->allocate(
-                        voxel::ChunkLocation {Gpu_ChunkLocation {
-                            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
-                            .root_position {newChildrenRoots[i]},
-                            .lod {this->entire_bounds.lod - 1},
-                        }},
-                        threadPool,
-                        chunkRenderManager,
-                        worldGenerator);
-                }
+                const NodeIndex firstChild = this->allocateChildren(
+                    node, location, threadPool, chunkRenderManager, worldGenerator);
 
-                this->previous_payload_lifetime_extension = std::move(this->payload);
+                this->nodes[node].first_child = firstChild;
 
-                this->payload = std::move(newChildren);
+                this->node_extended_chunks[node] = std::move(this->node_chunks[node]);
+                this->node_chunks[node].reset();
             }
             else
             {
                 std::size_t _ {};
 
-                chunk->updateAndFlushUpdates({}, _);
+                this->node_chunks[node]->updateAndFlushUpdates({}, _);
             }
         }
         else
         {
-            std::array<util::ObjectPool<Node>::UniqueT, 8>* const children =
-                std::get_if<1>(&this->payload);
+            if (distanceToViewpoints > mergeDistance)
+            {
+                this->dropLifetimeExtension(node);
+
+                this->nodes[node].extended_first_child = this->nodes[node].first_child;
+                this->nodes[node].first_child          = NullNode;
+
+                this->node_chunks[node].emplace(
+                    threadPool, chunkRenderManager, worldGenerator, location, this->prefetcher);
+            }
+        }
 
-            if (this->entire_bounds.lod <= desiredLOD)
+        f32 stableRadius {};
+        u32 numberOfUnloadedLeaves = 0;
+
+        if (const NodeIndex firstChild = this->nodes[node].first_child; firstChild == NullNode)
+        {
+            numberOfUnloadedLeaves = this->node_chunks[node]->isFullyLoaded() ? 0 : 1;
+
+            stableRadius = distanceToViewpoints - splitDistance;
+        }
+        else
+        {
+            const std::array<glm::ivec3, 8> childrenRoots =
+                generateChildrenRootPositions(location);
+
+            stableRadius = mergeDistance - distanceToViewpoints;
+
+            for (NodeIndex i = 0; i < 8; ++i)
             {
-                this->previous_payload_lifetime_extension = std::move(this->payload);
+                this->updateNode(
+                    firstChild + i,
+                    voxel::ChunkLocation {Gpu_ChunkLocation {
+                        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+                        .root_position {childrenRoots[i]},
+                        .lod {location.lod - 1},
+                    }},
+                    viewpoints,
+                    threadPool,
+                    chunkRenderManager,
+                    worldGenerator);
+
+                const NodeRecord& child = this->nodes[firstChild + i];
 
-                this->payload.emplace<LazilyGeneratedChunk>(
-                    threadPool, chunkRenderManager, worldGenerator, this->entire_bounds);
+                numberOfUnloadedLeaves += child.number_of_unloaded_leaves;
+
+                stableRadius = std::min(
+                    stableRadius, child.getRemainingStableDistance(this->viewpoint_travel));
             }
-            else
+        }
+
+        NodeRecord& thisNode               = this->nodes[node];
+        thisNode.last_update_travel        = this->viewpoint_travel;
+        thisNode.last_update_generation    = this->viewpoint_set_generation;
+        thisNode.stable_lod_band_radius    = stableRadius;
+        thisNode.number_of_unloaded_leaves = numberOfUnloadedLeaves;
+
+        if (numberOfUnloadedLeaves == 0)
+        {
+            this->dropLifetimeExtension(node);
+        }
+    }
+
+    f32 VoxelChunkOctree::getWeightedDistance(
+        std::span<const LodViewpoint> viewpoints, glm::vec3 position, f32 radius)
+    {
+        // With no viewpoints at all nothing needs detail and the whole tree collapses
+        f32 weightedDistance = std::numeric_limits<f32>::infinity();
+
+        for (const LodViewpoint& v : viewpoints)
+        {
+            const f32 distance = std::max(0.0f, glm::distance(v.position, position) - radius);
+
+            weightedDistance = std::min(weightedDistance, distance / v.weight);
+        }
+
+        return weightedDistance;
+    }
+
+    void VoxelChunkOctree::collectPrefetchTargets( // NOLINT(misc-no-recursion)
+        NodeIndex                          node,
+        voxel::ChunkLocation               location,
+        std::span<const LodViewpoint>      predictedViewpoints,
+        std::vector<voxel::ChunkLocation>& outTargets) const
+    {
+        if (outTargets.size() >= MaxPrefetchTargets)
+        {
+            return;
+        }
+
+        const glm::vec3 center = static_cast<glm::f32vec3>(location.getCenterPosition());
+
+        if (const NodeIndex firstChild = this->nodes[node].first_child; firstChild == NullNode)
+        {
+            if (getWeightedDistance(predictedViewpoints, center) < getSplitDistance(location.lod))
             {
-                for (const util::ObjectPool<Node>::UniqueT& c : *children)
-                {
-                    c->update(camera, threadPool, chunkRenderManager, worldGenerator, nodePool);
-                }
+                collectPrefetchTargetsOfSplit(location, predictedViewpoints, outTargets);
             }
         }
+        else
+        {
+            // Every leaf below this node is somewhere in its bounding sphere (of radius
+            // width * sqrt(3) / 2) and none of them would split at a distance beyond what our
+            // children split at
+            const f32 boundingRadius =
+                static_cast<f32>(gpu_calculateChunkWidthUnits(location.lod)) * 0.8660254f;
+
+            if (getWeightedDistance(predictedViewpoints, center, boundingRadius)
+                >= getSplitDistance(location.lod - 1))
+            {
+                return;
+            }
+
+            const std::array<glm::ivec3, 8> childrenRoots =
+                generateChildrenRootPositions(location);
+
+            for (NodeIndex i = 0; i < 8; ++i)
+            {
+                this->collectPrefetchTargets(
+                    firstChild + i,
+                    voxel::ChunkLocation {Gpu_ChunkLocation {
+                        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+                        .root_position {childrenRoots[i]},
+                        .lod {location.lod - 1},
+                    }},
+                    predictedViewpoints,
+                    outTargets);
+            }
+        }
+    }
+
+    void VoxelChunkOctree::collectPrefetchTargetsOfSplit( // NOLINT(misc-no-recursion)
+        voxel::ChunkLocation               location,
+        std::span<const LodViewpoint>      predictedViewpoints,
+        std::vector<voxel::ChunkLocation>& outTargets)
+    {
+        const std::array<glm::ivec3, 8> childrenRoots = generateChildrenRootPositions(location);
 
-        if (this->previous_payload_lifetime_extension.has_value())
+        for (const glm::ivec3& childRoot : childrenRoots)
         {
-            if (this->isNodeFullyLoaded())
+            if (outTargets.size() >= MaxPrefetchTargets)
             {
-                this->previous_payload_lifetime_extension = std::nullopt;
+                return;
+            }
+
+            const voxel::ChunkLocation child {Gpu_ChunkLocation {
+                .root_position {childRoot},
+                .lod {location.lod - 1},
+            }};
+
+            outTargets.push_back(child);
+
+            if (getWeightedDistance(
+                    predictedViewpoints, static_cast<glm::f32vec3>(child.getCenterPosition()))
+                < getSplitDistance(child.lod))
+            {
+                collectPrefetchTargetsOfSplit(child, predictedViewpoints, outTargets);
             }
         }
     }
 
-    bool VoxelChunkOctree::Node::isNodeFullyLoaded() const // NOLINT(misc-no-recursion)
+    VoxelChunkOctree::NodeIndex VoxelChunkOctree::allocateChildren(
+        NodeIndex                        parent,
+        voxel::ChunkLocation             parentLocation,
+        util::ThreadPool&                threadPool,
+        util::Mutex<ChunkRenderManager>* chunkRenderManager,
+        world::WorldGenerator*           worldGenerator)
     {
-        if (this->payload.index() == 0)
+        NodeIndex firstChild = NullNode;
+
+        if (this->free_child_blocks.empty())
         {
-            const LazilyGeneratedChunk* const chunk = std::get_if<0>(&this->payload);
+            firstChild = static_cast<NodeIndex>(this->nodes.size());
 
-            return chunk->isFullyLoaded();
+            this->nodes.resize(this->nodes.size() + 8);
+            this->node_chunks.resize(this->node_chunks.size() + 8);
+            this->node_extended_chunks.resize(this->node_extended_chunks.size() + 8);
         }
         else
         {
-            const std::array<util::ObjectPool<Node>::UniqueT, 8>* const children =
-                std::get_if<1>(&this->payload);
+            firstChild = this->free_child_blocks.back();
+            this->free_child_blocks.pop_back();
+        }
 
-            return std::ranges::all_of(
-                *children,
-                [](const auto& p)
-                {
-                    return p->isNodeFullyLoaded();
-                });
+        const u64                       parentKey = this->nodes[parent].morton_key;
+        const std::array<glm::ivec3, 8> childrenRoots =
+            generateChildrenRootPositions(parentLocation);
+
+        for (NodeIndex i = 0; i < 8; ++i)
+        {
+            this->nodes[firstChild + i] = NodeRecord {.morton_key {getChildKey(parentKey, i)}};
+
+            this->node_chunks[firstChild + i].emplace(
+                threadPool,
+                chunkRenderManager,
+                worldGenerator,
+                voxel::ChunkLocation {Gpu_ChunkLocation {
+                    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+                    .root_position {childrenRoots[i]},
+                    .lod {parentLocation.lod - 1},
+                }},
+                this->prefetcher);
+        }
+
+        return firstChild;
+    }
+
+    void VoxelChunkOctree::freeChildren(NodeIndex firstChild) // NOLINT(misc-no-recursion)
+    {
+        for (NodeIndex i = firstChild; i < firstChild + 8; ++i)
+        {
+            if (this->node_chunks[i].has_value())
+            {
+                this->node_chunks[i]->markShouldNotGenerate();
+            }
+
+            if (this->nodes[i].first_child != NullNode)
+            {
+                this->freeChildren(this->nodes[i].first_child);
+            }
+
+            this->dropLifetimeExtension(i);
+
+            this->node_chunks[i].reset();
+            this->nodes[i] = NodeRecord {};
+        }
+
+        this->free_child_blocks.push_back(firstChild);
+    }
+
+    bool VoxelChunkOctree::hasLifetimeExtension(NodeIndex node) const
+    {
+        return this->nodes[node].extended_first_child != NullNode
+            || this->node_extended_chunks[node].has_value();
+    }
+
+    void VoxelChunkOctree::dropLifetimeExtension(NodeIndex node) // NOLINT(misc-no-recursion)
+    {
+        if (this->node_extended_chunks[node].has_value())
+        {
+            this->node_extended_chunks[node]->markShouldNotGenerate();
+            this->node_extended_chunks[node].reset();
+        }
+
+        if (const NodeIndex extendedFirstChild = this->nodes[node].extended_first_child;
+            extendedFirstChild != NullNode)
+        {
+            this->nodes[node].extended_first_child = NullNode;
+
+            this->freeChildren(extendedFirstChild);
         }
     }
 
-    LodWorldManager::LodWorldManager(const game::Game* game, u32 dimension)
+    LodWorldManager::LodWorldManager(
+        const game::Game* game, u32 dimension, std::chrono::duration<f32> prefetchHorizon)
         : chunk_generation_thread_pool {4}
         , chunk_render_manager {ChunkRenderManager {game}}
         , generator {UINT64_C(879123897234897243)}
+        , chunk_prefetcher {&this->generator}
+        , prefetch_horizon {prefetchHorizon}
+        , previous_camera_time {std::chrono::steady_clock::now()}
+        , previous_camera_position {std::nullopt}
+        , camera_velocity {0.0f}
         , tree {std::make_unique<VoxelChunkOctree>(
               this->chunk_generation_thread_pool,
               &this->chunk_render_manager,
               &this->generator,
+              &this->chunk_prefetcher,
               dimension)}
     {
         std::mt19937_64                     gen {73847375}; // NOLINT
@@ -207,20 +498,62 @@ namespace voxel
     }
 
     std::vector<game::FrameGenerator::RecordObject> LodWorldManager::onFrameUpdate(
-        const game::Camera& camera, gfx::profiler::TaskGenerator& taskGenerator)
+        const game::Camera&           camera,
+        gfx::profiler::TaskGenerator& taskGenerator,
+        std::span<const LodViewpoint> additionalViewpoints)
     {
+        for (const LodViewpoint& v : additionalViewpoints)
+        {
+            util::assertFatal(v.weight > 0.0f, "LodViewpoint weight {} must be positive", v.weight);
+        }
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const f32 deltaTime = std::chrono::duration<f32> {now - this->previous_camera_time}.count();
+
+        if (this->previous_camera_position.has_value() && deltaTime > 0.0f)
+        {
+            const glm::vec3 instantaneousVelocity =
+                (camera.getPosition() - *this->previous_camera_position) / deltaTime;
+
+            this->camera_velocity = glm::mix(this->camera_velocity, instantaneousVelocity, 0.2f);
+        }
+
+        this->previous_camera_time     = now;
+        this->previous_camera_position = camera.getPosition();
+
         if (!this->maybe_tree_process_future.valid()
             || this->maybe_tree_process_future.wait_for(std::chrono::years {0})
                    == std::future_status::ready)
         {
+            std::vector<LodViewpoint> viewpoints {LodViewpoint {
+                .position {camera.getPosition()},
+                .weight {1.0f},
+                .velocity {this->camera_velocity}}};
+            viewpoints.append_range(additionalViewpoints);
+
+            std::vector<LodViewpoint> predictedViewpoints {};
+            predictedViewpoints.reserve(viewpoints.size());
+
+            for (const LodViewpoint& v : viewpoints)
+            {
+                predictedViewpoints.push_back(LodViewpoint {
+                    .position {v.position + v.velocity * this->prefetch_horizon.count()},
+                    .weight {v.weight},
+                    .velocity {v.velocity}});
+            }
+
             this->maybe_tree_process_future = this->chunk_generation_thread_pool.executeOnPool(
-                [this, c = game::Camera {camera}]
+                [this,
+                 viewpoints          = std::move(viewpoints),
+                 predictedViewpoints = std::move(predictedViewpoints)]
                 {
                     this->tree->update(
-                        c,
+                        viewpoints,
                         this->chunk_generation_thread_pool,
                         &this->chunk_render_manager,
                         &this->generator);
+
+                    this->tree->prefetch(predictedViewpoints);
                 });
         }
 
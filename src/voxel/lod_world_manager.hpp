@@ -6,45 +6,69 @@
 #include "gfx/profiler/task_generator.hpp"
 #include "lazily_generated_chunk.hpp"
 #include "shaders/include/common.glsl"
-#include "util/object_pool.hpp"
 #include "util/thread_pool.hpp"
+#include "voxel/chunk_prefetcher.hpp"
 #include "voxel/chunk_render_manager.hpp"
 #include "voxel/structures.hpp"
 #include "world/generator.hpp"
+#include <chrono>
 #include <glm/geometric.hpp>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <span>
 #include <utility>
-#include <variant>
 #include <vector>
 
 namespace voxel
 {
+    /// A position the world must be loaded around.
+    /// Weight scales how much detail the viewpoint demands, a viewpoint of weight 2 gets the
+    /// lod a weight 1 viewpoint would get at half the distance.
+    struct LodViewpoint
+    {
+        glm::vec3 position;
+        f32       weight = 1.0f;
+        // Only used to predict where the viewpoint is headed, for prefetching
+        glm::vec3 velocity {0.0f};
+    };
 
+    /// A linear octree of LazilyGeneratedChunks.
+    /// Nodes are flat records identified by a morton locational code (a leading 1 bit followed
+    /// by 3 bits of child position per level) and the 8 children of a node are always stored
+    /// contiguously, so a node only needs the index of its first child. The chunks themselves
+    /// live in a separate table indexed by node.
+    /// Every node is refined to the finest lod any viewpoint needs, so chunks seen by several
+    /// viewpoints are only generated and meshed once.
     class VoxelChunkOctree
     {
-    private:
-        struct Node;
     public:
 
         explicit VoxelChunkOctree(
             util::ThreadPool&,
             util::Mutex<ChunkRenderManager>*,
             world::WorldGenerator*,
+            ChunkPrefetcher*,
             u32 dimension);
-        ~VoxelChunkOctree() = default;
+        ~VoxelChunkOctree();
 
         VoxelChunkOctree(const VoxelChunkOctree&)             = delete;
         VoxelChunkOctree(VoxelChunkOctree&&)                  = delete;
         VoxelChunkOctree& operator= (const VoxelChunkOctree&) = delete;
         VoxelChunkOctree& operator= (VoxelChunkOctree&&)      = delete;
 
+        /// Walks the tree serially, splitting and merging nodes may create chunks and grow the
+        /// node tables, so nothing else may touch the tree while this runs
         void update(
-            const game::Camera&,
+            std::span<const LodViewpoint>,
             util::ThreadPool&,
             util::Mutex<ChunkRenderManager>*,
             world::WorldGenerator*);
 
+        /// Speculatively generates the chunks that leaves would split into if the viewpoints
+        /// were at these predicted positions, cancelling any earlier prediction's work
+        void prefetch(std::span<const LodViewpoint> predictedViewpoints);
+
     private:
         enum class OctreeNodePosition : std::uint8_t
         {
@@ -58,6 +82,38 @@ namespace voxel
             PxPyPz = 0b111,
         };
 
+        using NodeIndex = u32;
+
+        static constexpr NodeIndex NullNode = ~NodeIndex {0};
+        static constexpr NodeIndex RootNode = 0;
+        static constexpr u64       RootKey  = 1;
+
+        // Fraction of a node's lod boundary that the camera must go past before it splits or
+        // merges, so that hovering around a boundary doesn't thrash between the two
+        static constexpr f32 LodHysteresis = 0.25f;
+
+        /// A leaf splits once the camera is closer than this
+        static f32 getSplitDistance(u32 lod)
+        {
+            if (lod == 0)
+            {
+                return -std::numeric_limits<f32>::infinity();
+            }
+
+            return 2.0f * calculateMinimumDistanceForLOD(lod) * (1.0f - LodHysteresis);
+        }
+
+        /// A node with children merges back into a leaf once the camera is further than this
+        static f32 getMergeDistance(u32 lod)
+        {
+            return 2.0f * calculateMinimumDistanceForLOD(lod) * (1.0f + LodHysteresis);
+        }
+
+        static constexpr u64 getChildKey(u64 parentKey, std::size_t childPosition)
+        {
+            return (parentKey << 3u) | static_cast<u64>(childPosition);
+        }
+
         static constexpr std::array<glm::ivec3, 8>
         generateChildrenRootPositions(voxel::ChunkLocation location)
         {
@@ -78,62 +134,98 @@ namespace voxel
             return output;
         }
 
-        struct Node
+        struct NodeRecord
         {
-            Node(
-                voxel::ChunkLocation             bounds,
-                util::ThreadPool&                threadPool,
-                util::Mutex<ChunkRenderManager>* chunkRenderManager,
-                world::WorldGenerator*           worldGenerator)
-                : entire_bounds {bounds}
-                , payload {
-                      std::in_place_index<0>,
-                      threadPool,
-                      chunkRenderManager,
-                      worldGenerator,
-                      bounds}
-            {}
-            ~Node()
-            {
-                LazilyGeneratedChunk* const chunk = std::get_if<0>(&this->payload);
+            u64       morton_key  = 0;
+            // Index of the first of 8 contiguous children, NullNode for leaves
+            NodeIndex first_child = NullNode;
+            // Children that were merged away, kept alive until this node's new chunk is loaded
+            NodeIndex extended_first_child = NullNode;
 
-                if (chunk != nullptr)
-                {
-                    chunk->markShouldNotGenerate();
-                }
-            }
+            // Value of viewpoint_travel when this subtree was last evaluated
+            f64 last_update_travel        = 0.0;
+            // How much further the viewpoints may travel before any node in this subtree
+            // would choose a different lod
+            f32 stable_lod_band_radius    = 0.0f;
+            // Number of leaves in this subtree that are not yet fully loaded
+            u32 number_of_unloaded_leaves = 1;
+            // Value of viewpoint_set_generation when this subtree was last evaluated
+            u32 last_update_generation    = 0;
 
-            Node(const Node&)             = delete;
-            Node(Node&&)                  = default;
-            Node& operator= (const Node&) = delete;
-            Node& operator= (Node&&)      = default;
-
-            voxel::ChunkLocation entire_bounds;
-            std::variant<LazilyGeneratedChunk, std::array<util::ObjectPool<Node>::UniqueT, 8>>
-                payload;
-            std::optional<
-                std::variant<LazilyGeneratedChunk, std::array<util::ObjectPool<Node>::UniqueT, 8>>>
-                previous_payload_lifetime_extension;
-
-            void update(
-                const game::Camera&,
-                util::ThreadPool&,
-                util::Mutex<ChunkRenderManager>*,
-                world::WorldGenerator*,
-                util::ObjectPool<Node>*);
-
-            [[nodiscard]] bool isNodeFullyLoaded() const;
+            /// Remaining distance the viewpoints may travel before this subtree needs to be
+            /// revisited
+            [[nodiscard]] f32 getRemainingStableDistance(f64 viewpointTravel) const
+            {
+                return this->stable_lod_band_radius
+                     - static_cast<f32>(viewpointTravel - this->last_update_travel);
+            }
         };
 
-        util::ObjectPool<Node> node_pool;
+        // Upper bound on the number of chunks a single prediction may prefetch
+        static constexpr std::size_t MaxPrefetchTargets = 256;
+
+        /// Distance from the closest viewpoint, scaled by that viewpoint's weight.
+        /// With a radius, a lower bound on this for every position within that sphere
+        static f32 getWeightedDistance(
+            std::span<const LodViewpoint>, glm::vec3 position, f32 radius = 0.0f);
+
+        void collectPrefetchTargets(
+            NodeIndex,
+            voxel::ChunkLocation,
+            std::span<const LodViewpoint>,
+            std::vector<voxel::ChunkLocation>&) const;
+        static void collectPrefetchTargetsOfSplit(
+            voxel::ChunkLocation,
+            std::span<const LodViewpoint>,
+            std::vector<voxel::ChunkLocation>&);
+
+        void updateNode(
+            NodeIndex,
+            voxel::ChunkLocation,
+            std::span<const LodViewpoint>,
+            util::ThreadPool&,
+            util::Mutex<ChunkRenderManager>*,
+            world::WorldGenerator*);
 
-        Node root;
+        [[nodiscard]] NodeIndex allocateChildren(
+            NodeIndex parent,
+            voxel::ChunkLocation parentLocation,
+            util::ThreadPool&,
+            util::Mutex<ChunkRenderManager>*,
+            world::WorldGenerator*);
+        void freeChildren(NodeIndex firstChild);
+
+        [[nodiscard]] bool hasLifetimeExtension(NodeIndex) const;
+        void               dropLifetimeExtension(NodeIndex);
+
+        ChunkPrefetcher*     prefetcher;
+        voxel::ChunkLocation root_location;
+
+        std::vector<NodeRecord>                          nodes;
+        // chunk of each leaf
+        std::vector<std::optional<LazilyGeneratedChunk>> node_chunks;
+        // chunk of each node that was split, kept alive until its children are loaded
+        std::vector<std::optional<LazilyGeneratedChunk>> node_extended_chunks;
+        // first indices of unused blocks of 8 records
+        std::vector<NodeIndex>                           free_child_blocks;
+
+        // Viewpoints as of the last update
+        std::vector<LodViewpoint> previous_viewpoints;
+        // Running upper bound on how far any viewpoint has moved, in weighted distance
+        f64                       viewpoint_travel;
+        // Bumped whenever viewpoints are added, removed or reweighted
+        u32                       viewpoint_set_generation;
     };
 
     class LodWorldManager
     {
     public:
-        explicit LodWorldManager(const game::Game*, u32 dimension = 2u << 20u);
+        /// The prefetch horizon is how far ahead the viewpoints' trajectories are extrapolated to
+        /// prefetch chunks
+        explicit LodWorldManager(
+            const game::Game*,
+            u32                        dimension       = 2u << 20u,
+            std::chrono::duration<f32> prefetchHorizon = std::chrono::duration<f32> {1.5f});
         ~LodWorldManager();
 
         LodWorldManager(const LodWorldManager&)             = delete;
@@ -143,14 +235,25 @@ namespace voxel
 
         bool readIsPositionOccupied(glm::ivec3) const;
 
-        [[nodiscard]] std::vector<game::FrameGenerator::RecordObject>
-        onFrameUpdate(const game::Camera&, gfx::profiler::TaskGenerator&);
+        /// The additional viewpoints are the ones other than the camera that the world should
+        /// also be loaded around, e.g. spectators or bots, as of this frame
+        [[nodiscard]] std::vector<game::FrameGenerator::RecordObject> onFrameUpdate(
+            const game::Camera&,
+            gfx::profiler::TaskGenerator&,
+            std::span<const LodViewpoint> additionalViewpoints = {});
     private:
         std::vector<voxel::ChunkRenderManager::RaytracedLight> temporary_raytraced_lights;
 
         util::ThreadPool                chunk_generation_thread_pool;
         util::Mutex<ChunkRenderManager> chunk_render_manager;
         world::WorldGenerator           generator;
+        ChunkPrefetcher                 chunk_prefetcher;
+
+        const std::chrono::duration<f32>      prefetch_horizon;
+        std::chrono::steady_clock::time_point previous_camera_time;
+        std::optional<glm::vec3>              previous_camera_position;
+        // Smoothed so that single frame hitches don't throw the prediction around
+        glm::vec3                             camera_velocity;
 
         std::unique_ptr<VoxelChunkOctree> tree;
 
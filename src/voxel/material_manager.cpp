@@ -2,7 +2,6 @@
 
 namespace voxel
 {
-
     VoxelMaterial getMaterialFromVoxel(Voxel v)
     {
         switch (v)
@@ -2,6 +2,7 @@
 
 #include "gfx/renderer.hpp"
 #include "gfx/vulkan/buffer.hpp"
+#include "material_opacity.hpp"
 #include "structures.hpp"
 #include <glm/vec4.hpp>
 #include <limits>
@@ -0,0 +1,76 @@
+#include "material_opacity.hpp"
+#include "brick_kernels.hpp"
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace voxel
+{
+    namespace
+    {
+        struct MaterialOpacityException
+        {
+            Voxel           voxel;
+            MaterialOpacity opacity;
+        };
+
+        // Materials that aren't fully opaque, the only ones deriveBrickMasks has to look for
+        const std::vector<MaterialOpacityException>& getMaterialOpacityExceptions()
+        {
+            static const std::vector<MaterialOpacityException> exceptions = []
+            {
+                std::vector<MaterialOpacityException> result {};
+
+                for (u32 i = 0; i <= std::numeric_limits<u16>::max(); ++i)
+                {
+                    const Voxel           voxel   = static_cast<Voxel>(i);
+                    const MaterialOpacity opacity = getMaterialOpacity(voxel);
+
+                    if (!opacity.casts_shadows || !opacity.visible_to_camera)
+                    {
+                        result.push_back(
+                            MaterialOpacityException {.voxel {voxel}, .opacity {opacity}});
+                    }
+                }
+
+                return result;
+            }();
+
+            return exceptions;
+        }
+    } // namespace
+
+    MaterialOpacity getMaterialOpacity(Voxel v)
+    {
+        switch (v)
+        {
+        case Voxel::NullAirEmpty:
+            return MaterialOpacity {.casts_shadows {false}, .visible_to_camera {false}};
+        default:
+            return MaterialOpacity {.casts_shadows {true}, .visible_to_camera {true}};
+        }
+    }
+
+    void deriveBrickMasks(
+        const MaterialBrick& materials, ShadowBrick& shadows, PrimaryRayBrick& primaryRays)
+    {
+        shadows.fill(true);
+        primaryRays.fill(true);
+
+        for (const auto& [voxel, opacity] : getMaterialOpacityExceptions())
+        {
+            kernels::BitWords isVoxel {};
+            kernels::extractMask(isVoxel, materials.asU16s(), std::to_underlying(voxel));
+
+            if (!opacity.casts_shadows)
+            {
+                kernels::bitAndNot(shadows.data, shadows.data, isVoxel);
+            }
+
+            if (!opacity.visible_to_camera)
+            {
+                kernels::bitAndNot(primaryRays.data, primaryRays.data, isVoxel);
+            }
+        }
+    }
+} // namespace voxel
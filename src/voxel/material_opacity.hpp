@@ -0,0 +1,19 @@
+#pragma once
+
+#include "structures.hpp"
+
+namespace voxel
+{
+    /// Which of the masks derived from a brick's materials a voxel of a material is set in
+    struct MaterialOpacity
+    {
+        bool casts_shadows;
+        bool visible_to_camera;
+    };
+
+    /// Every material but air is fully opaque unless it says otherwise here
+    MaterialOpacity getMaterialOpacity(Voxel v);
+
+    /// Fills both masks from the brick's materials according to getMaterialOpacity
+    void deriveBrickMasks(const MaterialBrick&, ShadowBrick&, PrimaryRayBrick&);
+} // namespace voxel
@@ -0,0 +1,747 @@
+#include "occlusion_culler.hpp"
+#include "brick_kernels.hpp"
+#include "util/log.hpp"
+#include <algorithm>
+#include <cmath>
+#include <glm/vec4.hpp>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VOXEL_KERNELS_X86
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define VOXEL_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace voxel
+{
+    namespace
+    {
+        // Matches the camera's projection
+        constexpr f32 NearPlane = 0.1f;
+
+        constexpr f32 NoOccluder = std::numeric_limits<f32>::infinity();
+
+        constexpr std::size_t MaxHullEdges = 8;
+
+        // Andrew's monotone chain, counter clockwise
+        std::size_t findConvexHull(std::array<glm::vec2, 8> points, std::array<glm::vec2, 9>& hull)
+        {
+            std::ranges::sort(
+                points,
+                [](glm::vec2 l, glm::vec2 r)
+                {
+                    return l.x < r.x || (l.x == r.x && l.y < r.y);
+                });
+
+            auto cross = [](glm::vec2 o, glm::vec2 a, glm::vec2 b)
+            {
+                return ((a.x - o.x) * (b.y - o.y)) - ((a.y - o.y) * (b.x - o.x));
+            };
+
+            std::size_t k = 0;
+
+            for (const glm::vec2 p : points)
+            {
+                while (k >= 2 && cross(hull[k - 2], hull[k - 1], p) <= 0.0f)
+                {
+                    --k;
+                }
+                hull[k++] = p;
+            }
+
+            const std::size_t lowerSize = k + 1;
+
+            for (auto it = points.rbegin() + 1; it != points.rend(); ++it)
+            {
+                while (k >= lowerSize && cross(hull[k - 2], hull[k - 1], *it) <= 0.0f)
+                {
+                    --k;
+                }
+                hull[k++] = *it;
+            }
+
+            // The first point is repeated at the end
+            return k - 1;
+        }
+
+        /// Edge functions of a hull, a pixel at (x, y) is inside of edge e when
+        /// a[e] * x + b[e] * y + c[e] >= 0
+        struct HullEdges
+        {
+            std::array<f32, MaxHullEdges> a;
+            std::array<f32, MaxHullEdges> b;
+            std::array<f32, MaxHullEdges> c;
+            std::size_t                   count;
+        };
+
+        /// Where the corners of a box land on level 0, corner i is at the max of each axis whose
+        /// bit is set in i. Nothing else is filled in when the box crosses the near plane.
+        struct ProjectedBox
+        {
+            std::array<glm::vec2, 8> corners;
+            glm::vec2                screen_min;
+            glm::vec2                screen_max;
+            f32                      nearest_depth;
+            f32                      furthest_depth;
+            bool                     crosses_near_plane;
+        };
+
+        ProjectedBox makeProjectedBox(
+            const std::array<f32, 8>& screenX,
+            const std::array<f32, 8>& screenY,
+            const std::array<f32, 8>& depth)
+        {
+            ProjectedBox box {
+                .corners {},
+                .screen_min {std::numeric_limits<f32>::max()},
+                .screen_max {std::numeric_limits<f32>::lowest()},
+                .nearest_depth {std::numeric_limits<f32>::max()},
+                .furthest_depth {0.0f},
+                .crosses_near_plane {false},
+            };
+
+            for (std::size_t i = 0; i < 8; ++i)
+            {
+                const glm::vec2 screen {screenX[i], screenY[i]};
+
+                box.corners[i]     = screen;
+                box.screen_min     = glm::min(box.screen_min, screen);
+                box.screen_max     = glm::max(box.screen_max, screen);
+                box.nearest_depth  = std::min(box.nearest_depth, depth[i]);
+                box.furthest_depth = std::max(box.furthest_depth, depth[i]);
+            }
+
+            return box;
+        }
+
+        ProjectedBox makeBoxCrossingNearPlane()
+        {
+            return ProjectedBox {
+                .corners {},
+                .screen_min {},
+                .screen_max {},
+                .nearest_depth {},
+                .furthest_depth {},
+                .crosses_near_plane {true},
+            };
+        }
+
+        struct OcclusionKernelTable
+        {
+            ProjectedBox (*project_box)(const glm::mat4&, glm::vec3 min, glm::vec3 max);
+            /// Lowers row[x] to depth for every x in [x0, x1) whose pixel is inside every edge
+            void (*rasterize_row)(f32* row, u32 x0, u32 x1, f32 y, const HullEdges&, f32 depth);
+            /// out[x] is the furthest of the 2x2 texels below it for every x in [0, width)
+            void (*downsample_row)(f32* out, const f32* top, const f32* bottom, u32 width);
+        };
+
+        // Every kernel transforms corners as (((m0 * x) + (m1 * y)) + (m2 * z)) + m3 and evaluates
+        // each edge as ((a * x) + (b * y)) + c, in that order and without fusing, so that all of
+        // them cover exactly the same pixels
+
+        ProjectedBox projectBoxScalar(const glm::mat4& m, glm::vec3 min, glm::vec3 max)
+        {
+            std::array<f32, 8> screenX {};
+            std::array<f32, 8> screenY {};
+            std::array<f32, 8> depth {};
+
+            for (std::size_t i = 0; i < 8; ++i)
+            {
+                const glm::vec3 corner {
+                    (i & 1) != 0 ? max.x : min.x,
+                    (i & 2) != 0 ? max.y : min.y,
+                    (i & 4) != 0 ? max.z : min.z,
+                };
+
+                glm::vec4 clip {};
+
+                for (glm::length_t j = 0; j < 4; ++j)
+                {
+                    clip[j] = (m[0][j] * corner.x) + (m[1][j] * corner.y) + (m[2][j] * corner.z)
+                            + m[3][j];
+                }
+
+                // w is the view space distance in front of the camera
+                if (clip.w < NearPlane)
+                {
+                    return makeBoxCrossingNearPlane();
+                }
+
+                screenX[i] = (((clip.x / clip.w) * 0.5f) + 0.5f) * f32 {OcclusionCuller::Width};
+                screenY[i] = (((clip.y / clip.w) * 0.5f) + 0.5f) * f32 {OcclusionCuller::Height};
+                depth[i]   = clip.w;
+            }
+
+            return makeProjectedBox(screenX, screenY, depth);
+        }
+
+        void rasterizeRowScalar(f32* row, u32 x0, u32 x1, f32 y, const HullEdges& edges, f32 depth)
+        {
+            for (u32 x = x0; x < x1; ++x)
+            {
+                bool isCovered = true;
+
+                for (std::size_t e = 0; e < edges.count; ++e)
+                {
+                    isCovered &=
+                        ((edges.a[e] * static_cast<f32>(x)) + (edges.b[e] * y) + edges.c[e])
+                        >= 0.0f;
+                }
+
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                row[x] = isCovered ? std::min(row[x], depth) : row[x];
+            }
+        }
+
+        void downsampleRowScalar(f32* out, const f32* top, const f32* bottom, u32 width)
+        {
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            for (u32 x = 0; x < width; ++x)
+            {
+                out[x] = std::max(
+                    {top[2 * x], top[(2 * x) + 1], bottom[2 * x], bottom[(2 * x) + 1]});
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+
+        constexpr OcclusionKernelTable ScalarOcclusionKernels {
+            .project_box {projectBoxScalar},
+            .rasterize_row {rasterizeRowScalar},
+            .downsample_row {downsampleRowScalar},
+        };
+
+        // The remainder of every row that doesn't fill a whole vector is left to the scalar
+        // kernels. Boxes have 8 corners, one for each lane of 8 floats.
+
+#ifdef VOXEL_KERNELS_X86
+        [[gnu::target("avx2")]] __m256 transformAvx2(
+            const glm::mat4& m, glm::length_t component, __m256 xs, __m256 ys, __m256 zs)
+        {
+            return _mm256_add_ps(
+                _mm256_add_ps(
+                    _mm256_add_ps(
+                        _mm256_mul_ps(_mm256_set1_ps(m[0][component]), xs),
+                        _mm256_mul_ps(_mm256_set1_ps(m[1][component]), ys)),
+                    _mm256_mul_ps(_mm256_set1_ps(m[2][component]), zs)),
+                _mm256_set1_ps(m[3][component]));
+        }
+
+        [[gnu::target("avx2")]] f32 getMinAvx2(__m256 v)
+        {
+            __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            m        = _mm_min_ps(m, _mm_movehl_ps(m, m));
+
+            return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(m, m, 0b01)));
+        }
+
+        [[gnu::target("avx2")]] f32 getMaxAvx2(__m256 v)
+        {
+            __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            m        = _mm_max_ps(m, _mm_movehl_ps(m, m));
+
+            return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 0b01)));
+        }
+
+        [[gnu::target("avx2")]] __m256 toScreenAvx2(__m256 clip, __m256 w, f32 size)
+        {
+            const __m256 half = _mm256_set1_ps(0.5f);
+
+            return _mm256_mul_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_div_ps(clip, w), half), half),
+                _mm256_set1_ps(size));
+        }
+
+        [[gnu::target("avx2")]] ProjectedBox
+        projectBoxAvx2(const glm::mat4& m, glm::vec3 min, glm::vec3 max)
+        {
+            // Lane i is corner i
+            const __m256 xs =
+                _mm256_setr_ps(min.x, max.x, min.x, max.x, min.x, max.x, min.x, max.x);
+            const __m256 ys =
+                _mm256_setr_ps(min.y, min.y, max.y, max.y, min.y, min.y, max.y, max.y);
+            const __m256 zs =
+                _mm256_setr_ps(min.z, min.z, min.z, min.z, max.z, max.z, max.z, max.z);
+            const __m256 w  = transformAvx2(m, 3, xs, ys, zs);
+
+            if (_mm256_movemask_ps(_mm256_cmp_ps(w, _mm256_set1_ps(NearPlane), _CMP_LT_OQ)) != 0)
+            {
+                return makeBoxCrossingNearPlane();
+            }
+
+            const __m256 screenX =
+                toScreenAvx2(transformAvx2(m, 0, xs, ys, zs), w, f32 {OcclusionCuller::Width});
+            const __m256 screenY =
+                toScreenAvx2(transformAvx2(m, 1, xs, ys, zs), w, f32 {OcclusionCuller::Height});
+
+            // Reduced here rather than by makeProjectedBox, calling into code built without avx
+            // from here costs more than all of the above
+            ProjectedBox box {
+                .corners {},
+                .screen_min {getMinAvx2(screenX), getMinAvx2(screenY)},
+                .screen_max {getMaxAvx2(screenX), getMaxAvx2(screenY)},
+                .nearest_depth {getMinAvx2(w)},
+                .furthest_depth {getMaxAvx2(w)},
+                .crosses_near_plane {false},
+            };
+
+            // Interleaved as x y pairs, unpack leaves corners 0 1 4 5 and 2 3 6 7
+            const __m256 corners0145 = _mm256_unpacklo_ps(screenX, screenY);
+            const __m256 corners2367 = _mm256_unpackhi_ps(screenX, screenY);
+
+            _mm256_storeu_ps(
+                &box.corners[0].x, _mm256_permute2f128_ps(corners0145, corners2367, 0x20));
+            _mm256_storeu_ps(
+                &box.corners[4].x, _mm256_permute2f128_ps(corners0145, corners2367, 0x31));
+
+            return box;
+        }
+
+        [[gnu::target("avx2")]] void rasterizeRowAvx2(
+            f32* row, u32 x0, u32 x1, f32 y, const HullEdges& edges, f32 depth)
+        {
+            const __m256 laneOffsets   = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+            const __m256 occluderDepth = _mm256_set1_ps(depth);
+            const __m256 zero          = _mm256_setzero_ps();
+
+            u32 x = x0;
+
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            for (; x + 8 <= x1; x += 8)
+            {
+                const __m256 xs = _mm256_add_ps(_mm256_set1_ps(static_cast<f32>(x)), laneOffsets);
+                __m256       isCovered = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+
+                for (std::size_t e = 0; e < edges.count; ++e)
+                {
+                    const __m256 value = _mm256_add_ps(
+                        _mm256_add_ps(
+                            _mm256_mul_ps(_mm256_set1_ps(edges.a[e]), xs),
+                            _mm256_set1_ps(edges.b[e] * y)),
+                        _mm256_set1_ps(edges.c[e]));
+
+                    isCovered = _mm256_and_ps(isCovered, _mm256_cmp_ps(value, zero, _CMP_GE_OQ));
+                }
+
+                const __m256 current = _mm256_loadu_ps(row + x);
+
+                _mm256_storeu_ps(
+                    row + x,
+                    _mm256_blendv_ps(current, _mm256_min_ps(current, occluderDepth), isCovered));
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+            rasterizeRowScalar(row, x, x1, y, edges, depth);
+        }
+
+        [[gnu::target("avx2")]] void
+        downsampleRowAvx2(f32* out, const f32* top, const f32* bottom, u32 width)
+        {
+            u32 x = 0;
+
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            for (; x + 8 <= width; x += 8)
+            {
+                // Pairs of the first and last four outputs
+                const __m256 first = _mm256_max_ps(
+                    _mm256_loadu_ps(top + (2 * x)), _mm256_loadu_ps(bottom + (2 * x)));
+                const __m256 last = _mm256_max_ps(
+                    _mm256_loadu_ps(top + (2 * x) + 8), _mm256_loadu_ps(bottom + (2 * x) + 8));
+
+                // shuffle works within each 128 bit half, which leaves the outputs in the order
+                // 0 1 4 5 2 3 6 7, put the pairs of them back in order
+                const __m256 furthest = _mm256_max_ps(
+                    _mm256_shuffle_ps(first, last, 0b10'00'10'00),
+                    _mm256_shuffle_ps(first, last, 0b11'01'11'01));
+
+                _mm256_storeu_ps(
+                    out + x,
+                    _mm256_castpd_ps(
+                        _mm256_permute4x64_pd(_mm256_castps_pd(furthest), 0b11'01'10'00)));
+            }
+
+            downsampleRowScalar(out + x, top + (2 * x), bottom + (2 * x), width - x);
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+
+        constexpr OcclusionKernelTable Avx2OcclusionKernels {
+            .project_box {projectBoxAvx2},
+            .rasterize_row {rasterizeRowAvx2},
+            .downsample_row {downsampleRowAvx2},
+        };
+
+        [[gnu::target("avx512f")]] void rasterizeRowAvx512(
+            f32* row, u32 x0, u32 x1, f32 y, const HullEdges& edges, f32 depth)
+        {
+            const __m512 laneOffsets =
+                _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            const __m512 occluderDepth = _mm512_set1_ps(depth);
+            const __m512 zero          = _mm512_setzero_ps();
+
+            u32 x = x0;
+
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            for (; x + 16 <= x1; x += 16)
+            {
+                const __m512 xs = _mm512_add_ps(_mm512_set1_ps(static_cast<f32>(x)), laneOffsets);
+                __mmask16    isCovered = 0xFFFF;
+
+                for (std::size_t e = 0; e < edges.count; ++e)
+                {
+                    const __m512 value = _mm512_add_ps(
+                        _mm512_add_ps(
+                            _mm512_mul_ps(_mm512_set1_ps(edges.a[e]), xs),
+                            _mm512_set1_ps(edges.b[e] * y)),
+                        _mm512_set1_ps(edges.c[e]));
+
+                    isCovered = _mm512_mask_cmp_ps_mask(isCovered, value, zero, _CMP_GE_OQ);
+                }
+
+                const __m512 current = _mm512_loadu_ps(row + x);
+
+                _mm512_storeu_ps(
+                    row + x, _mm512_mask_min_ps(current, isCovered, current, occluderDepth));
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+            rasterizeRowScalar(row, x, x1, y, edges, depth);
+        }
+
+        // A box's corners only fill 8 lanes and the levels are too small for wider downsampling to
+        // be worth it
+        constexpr OcclusionKernelTable Avx512OcclusionKernels {
+            .project_box {projectBoxAvx2},
+            .rasterize_row {rasterizeRowAvx512},
+            .downsample_row {downsampleRowAvx2},
+        };
+#endif // VOXEL_KERNELS_X86
+
+#ifdef VOXEL_KERNELS_NEON
+        float32x4_t transformNeon(
+            const glm::mat4& m,
+            glm::length_t    component,
+            float32x4_t      xs,
+            float32x4_t      ys,
+            float32x4_t      zs)
+        {
+            return vaddq_f32(
+                vaddq_f32(
+                    vaddq_f32(
+                        vmulq_f32(vdupq_n_f32(m[0][component]), xs),
+                        vmulq_f32(vdupq_n_f32(m[1][component]), ys)),
+                    vmulq_f32(vdupq_n_f32(m[2][component]), zs)),
+                vdupq_n_f32(m[3][component]));
+        }
+
+        float32x4_t toScreenNeon(float32x4_t clip, float32x4_t w, f32 size)
+        {
+            const float32x4_t half = vdupq_n_f32(0.5f);
+
+            return vmulq_f32(
+                vaddq_f32(vmulq_f32(vdivq_f32(clip, w), half), half), vdupq_n_f32(size));
+        }
+
+        ProjectedBox projectBoxNeon(const glm::mat4& m, glm::vec3 min, glm::vec3 max)
+        {
+            const std::array<f32, 4> cornerXs {min.x, max.x, min.x, max.x};
+            const std::array<f32, 4> cornerYs {min.y, min.y, max.y, max.y};
+
+            const float32x4_t xs = vld1q_f32(cornerXs.data());
+            const float32x4_t ys = vld1q_f32(cornerYs.data());
+
+            std::array<f32, 8> screenX {};
+            std::array<f32, 8> screenY {};
+            std::array<f32, 8> depth {};
+
+            // Corners 0 to 3 are on the min z side, 4 to 7 on the max z side
+            for (std::size_t half = 0; half < 2; ++half)
+            {
+                const float32x4_t zs = vdupq_n_f32(half == 0 ? min.z : max.z);
+                const float32x4_t w  = transformNeon(m, 3, xs, ys, zs);
+
+                if (vmaxvq_u32(vcltq_f32(w, vdupq_n_f32(NearPlane))) != 0)
+                {
+                    return makeBoxCrossingNearPlane();
+                }
+
+                const float32x4_t clipX = transformNeon(m, 0, xs, ys, zs);
+                const float32x4_t clipY = transformNeon(m, 1, xs, ys, zs);
+
+                vst1q_f32(&screenX[4 * half], toScreenNeon(clipX, w, f32 {OcclusionCuller::Width}));
+                vst1q_f32(
+                    &screenY[4 * half], toScreenNeon(clipY, w, f32 {OcclusionCuller::Height}));
+                vst1q_f32(&depth[4 * half], w);
+            }
+
+            return makeProjectedBox(screenX, screenY, depth);
+        }
+
+        void rasterizeRowNeon(f32* row, u32 x0, u32 x1, f32 y, const HullEdges& edges, f32 depth)
+        {
+            static constexpr std::array<f32, 4> LaneOffsets {0.0f, 1.0f, 2.0f, 3.0f};
+
+            const float32x4_t laneOffsets   = vld1q_f32(LaneOffsets.data());
+            const float32x4_t occluderDepth = vdupq_n_f32(depth);
+
+            u32 x = x0;
+
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            for (; x + 4 <= x1; x += 4)
+            {
+                const float32x4_t xs = vaddq_f32(vdupq_n_f32(static_cast<f32>(x)), laneOffsets);
+                uint32x4_t        isCovered = vdupq_n_u32(~u32 {0});
+
+                for (std::size_t e = 0; e < edges.count; ++e)
+                {
+                    // vmlaq may be fused, multiply and add separately like the scalar kernel
+                    const float32x4_t value = vaddq_f32(
+                        vaddq_f32(
+                            vmulq_f32(vdupq_n_f32(edges.a[e]), xs), vdupq_n_f32(edges.b[e] * y)),
+                        vdupq_n_f32(edges.c[e]));
+
+                    isCovered = vandq_u32(isCovered, vcgeq_f32(value, vdupq_n_f32(0.0f)));
+                }
+
+                const float32x4_t current = vld1q_f32(row + x);
+
+                vst1q_f32(
+                    row + x, vbslq_f32(isCovered, vminq_f32(current, occluderDepth), current));
+            }
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+            rasterizeRowScalar(row, x, x1, y, edges, depth);
+        }
+
+        void downsampleRowNeon(f32* out, const f32* top, const f32* bottom, u32 width)
+        {
+            u32 x = 0;
+
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            for (; x + 4 <= width; x += 4)
+            {
+                // Split into the left and right texel of each pair
+                const float32x4x2_t topPairs    = vld2q_f32(top + (2 * x));
+                const float32x4x2_t bottomPairs = vld2q_f32(bottom + (2 * x));
+
+                vst1q_f32(
+                    out + x,
+                    vmaxq_f32(
+                        vmaxq_f32(topPairs.val[0], topPairs.val[1]),
+                        vmaxq_f32(bottomPairs.val[0], bottomPairs.val[1])));
+            }
+
+            downsampleRowScalar(out + x, top + (2 * x), bottom + (2 * x), width - x);
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+
+        constexpr OcclusionKernelTable NeonOcclusionKernels {
+            .project_box {projectBoxNeon},
+            .rasterize_row {rasterizeRowNeon},
+            .downsample_row {downsampleRowNeon},
+        };
+#endif // VOXEL_KERNELS_NEON
+
+        /// The same instruction set as the brick kernels, so that setting theirs sets these too
+        const OcclusionKernelTable& getOcclusionKernels()
+        {
+            const kernels::InstructionSet instructionSet = kernels::getInstructionSet();
+
+            switch (instructionSet)
+            {
+            case kernels::InstructionSet::Scalar:
+                return ScalarOcclusionKernels;
+#ifdef VOXEL_KERNELS_X86
+            case kernels::InstructionSet::Avx2:
+                return Avx2OcclusionKernels;
+            case kernels::InstructionSet::Avx512:
+                return Avx512OcclusionKernels;
+#endif // VOXEL_KERNELS_X86
+#ifdef VOXEL_KERNELS_NEON
+            case kernels::InstructionSet::Neon:
+                return NeonOcclusionKernels;
+#endif // VOXEL_KERNELS_NEON
+            default:
+                util::panic(
+                    "{} occlusion kernels aren't built for this cpu",
+                    kernels::getInstructionSetName(instructionSet));
+            }
+        }
+    } // namespace
+
+    OcclusionCuller::OcclusionCuller()
+        : view_projection {1.0f}
+    {
+        glm::u32vec2 size {Width, Height};
+
+        while (true)
+        {
+            this->level_sizes.push_back(size);
+            this->depth_levels.emplace_back(static_cast<std::size_t>(size.x) * size.y, NoOccluder);
+
+            if (size.x == 1 && size.y == 1)
+            {
+                break;
+            }
+
+            size = glm::max(size / 2U, glm::u32vec2 {1, 1});
+        }
+    }
+
+    void OcclusionCuller::clear(const glm::mat4& viewProjection)
+    {
+        this->view_projection = viewProjection;
+
+        for (std::vector<f32>& level : this->depth_levels)
+        {
+            std::ranges::fill(level, NoOccluder);
+        }
+    }
+
+    void OcclusionCuller::rasterizeOccluder(glm::vec3 min, glm::vec3 max)
+    {
+        const OcclusionKernelTable& occlusionKernels = getOcclusionKernels();
+        const ProjectedBox box = occlusionKernels.project_box(this->view_projection, min, max);
+
+        if (box.crosses_near_plane)
+        {
+            return;
+        }
+
+        std::array<glm::vec2, 9> hull {};
+        const std::size_t        hullSize = findConvexHull(box.corners, hull);
+
+        if (hullSize < 3)
+        {
+            return;
+        }
+
+        // Edge functions offset to their most pessimistic pixel corner, a pixel is only covered
+        // when the whole of it is inside every edge
+        HullEdges edges {.a {}, .b {}, .c {}, .count {hullSize}};
+
+        for (std::size_t i = 0; i < hullSize; ++i)
+        {
+            const glm::vec2 a = hull[i];
+            const glm::vec2 b = hull[i + 1];
+
+            edges.a[i] = -(b.y - a.y);
+            edges.b[i] = b.x - a.x;
+            edges.c[i] = -(edges.a[i] * a.x) - (edges.b[i] * a.y) + std::min(edges.a[i], 0.0f)
+                       + std::min(edges.b[i], 0.0f);
+        }
+
+        const u32 x0 = static_cast<u32>(std::clamp(box.screen_min.x, 0.0f, f32 {Width}));
+        const u32 y0 = static_cast<u32>(std::clamp(box.screen_min.y, 0.0f, f32 {Height}));
+        const u32 x1 = static_cast<u32>(std::clamp(box.screen_max.x, 0.0f, f32 {Width}));
+        const u32 y1 = static_cast<u32>(std::clamp(box.screen_max.y, 0.0f, f32 {Height}));
+
+        std::vector<f32>& depth = this->depth_levels.front();
+
+        for (u32 y = y0; y < y1; ++y)
+        {
+            occlusionKernels.rasterize_row(
+                &depth[static_cast<std::size_t>(y) * Width],
+                x0,
+                x1,
+                static_cast<f32>(y),
+                edges,
+                box.furthest_depth);
+        }
+    }
+
+    void OcclusionCuller::buildHierarchy()
+    {
+        const OcclusionKernelTable& occlusionKernels = getOcclusionKernels();
+
+        for (std::size_t level = 1; level < this->depth_levels.size(); ++level)
+        {
+            const glm::u32vec2      previousSize = this->level_sizes[level - 1];
+            const glm::u32vec2      size         = this->level_sizes[level];
+            const std::vector<f32>& previous     = this->depth_levels[level - 1];
+            std::vector<f32>&       current      = this->depth_levels[level];
+
+            for (u32 y = 0; y < size.y; ++y)
+            {
+                const u32 previousY0 = std::min(y * 2, previousSize.y - 1);
+                const u32 previousY1 = std::min((y * 2) + 1, previousSize.y - 1);
+
+                // Only the last few levels are an odd number of texels wide
+                if (previousSize.x == size.x * 2)
+                {
+                    occlusionKernels.downsample_row(
+                        &current[static_cast<std::size_t>(y) * size.x],
+                        &previous[static_cast<std::size_t>(previousY0) * previousSize.x],
+                        &previous[static_cast<std::size_t>(previousY1) * previousSize.x],
+                        size.x);
+
+                    continue;
+                }
+
+                for (u32 x = 0; x < size.x; ++x)
+                {
+                    const u32 previousX0 = std::min(x * 2, previousSize.x - 1);
+                    const u32 previousX1 = std::min((x * 2) + 1, previousSize.x - 1);
+
+                    current[(static_cast<std::size_t>(y) * size.x) + x] = std::max({
+                        previous[(static_cast<std::size_t>(previousY0) * previousSize.x)
+                                 + previousX0],
+                        previous[(static_cast<std::size_t>(previousY0) * previousSize.x)
+                                 + previousX1],
+                        previous[(static_cast<std::size_t>(previousY1) * previousSize.x)
+                                 + previousX0],
+                        previous[(static_cast<std::size_t>(previousY1) * previousSize.x)
+                                 + previousX1],
+                    });
+                }
+            }
+        }
+    }
+
+    bool OcclusionCuller::isOccluded(glm::vec3 min, glm::vec3 max) const
+    {
+        const ProjectedBox box = getOcclusionKernels().project_box(this->view_projection, min, max);
+
+        if (box.crosses_near_plane)
+        {
+            return false;
+        }
+
+        const i32 x0 = std::max(static_cast<i32>(std::floor(box.screen_min.x)), 0);
+        const i32 y0 = std::max(static_cast<i32>(std::floor(box.screen_min.y)), 0);
+        const i32 x1 = std::min(static_cast<i32>(std::floor(box.screen_max.x)), i32 {Width} - 1);
+        const i32 y1 = std::min(static_cast<i32>(std::floor(box.screen_max.y)), i32 {Height} - 1);
+
+        if (x0 > x1 || y0 > y1)
+        {
+            return false;
+        }
+
+        // Pick the level where the box covers at most 2x2 texels
+        const u32 largestSide = static_cast<u32>(std::max(x1 - x0, y1 - y0)) + 1;
+        std::size_t level = 0;
+
+        while ((largestSide >> level) > 2 && level + 1 < this->depth_levels.size())
+        {
+            ++level;
+        }
+
+        const glm::u32vec2      size  = this->level_sizes[level];
+        const std::vector<f32>& depth = this->depth_levels[level];
+
+        f32 furthestOccluderDepth = 0.0f;
+
+        for (u32 y = static_cast<u32>(y0) >> level; y <= (static_cast<u32>(y1) >> level); ++y)
+        {
+            for (u32 x = static_cast<u32>(x0) >> level; x <= (static_cast<u32>(x1) >> level); ++x)
+            {
+                furthestOccluderDepth = std::max(
+                    furthestOccluderDepth,
+                    depth[(static_cast<std::size_t>(std::min(y, size.y - 1)) * size.x)
+                          + std::min(x, size.x - 1)]);
+            }
+        }
+
+        return box.nearest_depth > furthestOccluderDepth;
+    }
+} // namespace voxel
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "util/misc.hpp"
+#include <array>
+#include <glm/fwd.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+namespace voxel
+{
+    /// Low resolution software depth buffer for culling chunks hidden behind nearer ones.
+    /// Occluders are rasterized conservatively (only pixels they entirely cover, at their furthest
+    /// depth) so a box is only ever reported as occluded when it truly is.
+    class OcclusionCuller
+    {
+    public:
+        static constexpr u32 Width  = 256;
+        static constexpr u32 Height = 128;
+        /// How many of the nearest occluders are rasterized each frame. Nearby ones cover the most
+        /// of the screen, further ones add little but cost the same.
+        static constexpr std::size_t MaxOccluders = 64;
+    public:
+        OcclusionCuller();
+
+        /// Empties the depth buffer, everything after this is relative to this view projection
+        void clear(const glm::mat4& viewProjection);
+        void rasterizeOccluder(glm::vec3 min, glm::vec3 max);
+        /// Must be called after the last occluder and before the first isOccluded
+        void buildHierarchy();
+
+        [[nodiscard]] bool isOccluded(glm::vec3 min, glm::vec3 max) const;
+
+    private:
+        glm::mat4 view_projection;
+        // Level 0 is Width x Height, each level after is half the size of the previous and holds
+        // the furthest depth of the texels it covers. Depth is view space distance.
+        std::vector<std::vector<f32>> depth_levels;
+        std::vector<glm::u32vec2>     level_sizes;
+    };
+} // namespace voxel
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "brick_kernels.hpp"
 #include "shaders/include/common.glsl"
 #include "util/log.hpp"
 #include "util/misc.hpp"
@@ -16,6 +17,8 @@
 #include <glm/gtx/string_cast.hpp>
 #include <limits>
 #include <optional>
+#include <span>
+#include <type_traits>
 #include <utility>
 
 namespace voxel
@@ -149,6 +152,18 @@ namespace voxel
         {}
     };
 
+    /// Where a BrickLocalPosition lives within a TypedBrick, or a BrickCoordinate within a
+    /// ChunkBrickMap, see gpu_brickLayoutIndex
+    [[nodiscard]] inline std::size_t getBrickLayoutIndex(glm::u8vec3 p)
+    {
+        return gpu_brickLayoutIndex(glm::uvec3 {p});
+    }
+
+    [[nodiscard]] inline glm::u8vec3 getBrickLayoutPosition(std::size_t index)
+    {
+        return glm::u8vec3 {gpu_brickLayoutPosition(static_cast<u32>(index))};
+    }
+
     /// Represents the position of a single Chunk in world space
     // struct ChunkCoordinate : public VoxelCoordinateBase<ChunkCoordinate, glm::i32vec3>
     // {
@@ -316,6 +331,21 @@ namespace voxel
             return (this->data[idx] & (1u << bit)) != 0; // NOLINT
         }
 
+        [[nodiscard]] bool isEmpty() const
+        {
+            return kernels::isEmpty(this->data);
+        }
+
+        [[nodiscard]] bool isFull() const
+        {
+            return kernels::isFull(this->data);
+        }
+
+        [[nodiscard]] u32 countSetVoxels() const
+        {
+            return kernels::popcount(this->data);
+        }
+
         void iterateOverVoxels(std::invocable<BrickLocalPosition, bool> auto func) const
         {
             for (std::size_t x = 0; x < VoxelsPerBrickEdge; ++x)
@@ -351,86 +381,76 @@ namespace voxel
     template<class T>
     struct TypedBrick
     {
-        std::array<
-            std::array<std::array<T, VoxelsPerBrickEdge>, VoxelsPerBrickEdge>,
-            VoxelsPerBrickEdge>
-            data;
+        /// Indexed by getBrickLayoutIndex
+        std::array<T, GpuBrickLayoutSize> data;
 
         void fill(T t)
         {
-            for (std::size_t i = 0; i < VoxelsPerBrickEdge; ++i)
-            {
-                for (std::size_t j = 0; j < VoxelsPerBrickEdge; ++j)
-                {
-                    for (std::size_t k = 0; k < VoxelsPerBrickEdge; ++k)
-                    {
-                        this->data[i][j][k] = t; // NOLINT
-                    }
-                }
-            }
+            std::ranges::fill(this->data, t);
         }
 
         void write(BrickLocalPosition p, T t)
         {
-            this->data[p.x][p.y][p.z] = t; // NOLINT
+            this->data[getBrickLayoutIndex(p)] = t; // NOLINT
         }
 
         [[nodiscard]] T read(BrickLocalPosition p) const
         {
-            return this->data[p.x][p.y][p.z]; // NOLINT
+            return this->data[getBrickLayoutIndex(p)]; // NOLINT
         }
 
         [[nodiscard]] T& modify(BrickLocalPosition p)
         {
-            return this->data[p.x][p.y][p.z]; // NOLINT
+            return this->data[getBrickLayoutIndex(p)]; // NOLINT
         }
 
+        /// Visits voxels in the order they are stored
         void iterateOverVoxels(std::invocable<BrickLocalPosition, T> auto func) const
         {
-            for (std::size_t x = 0; x < VoxelsPerBrickEdge; ++x)
+            for (std::size_t i = 0; i < this->data.size(); ++i)
             {
-                for (std::size_t y = 0; y < VoxelsPerBrickEdge; ++y)
-                {
-                    for (std::size_t z = 0; z < VoxelsPerBrickEdge; ++z)
-                    {
-                        const BrickLocalPosition p {glm::u8vec3 {x, y, z}};
-
-                        func(p, this->read(p));
-                    }
-                }
+                func(BrickLocalPosition {getBrickLayoutPosition(i)}, this->data[i]);
             }
         }
 
+        /// Visits voxels in the order they are stored
         void modifyOverVoxels(std::invocable<BrickLocalPosition, T&> auto func)
         {
-            for (std::size_t x = 0; x < VoxelsPerBrickEdge; ++x)
+            for (std::size_t i = 0; i < this->data.size(); ++i)
             {
-                for (std::size_t y = 0; y < VoxelsPerBrickEdge; ++y)
-                {
-                    for (std::size_t z = 0; z < VoxelsPerBrickEdge; ++z)
-                    {
-                        const BrickLocalPosition p {glm::u8vec3 {x, y, z}};
-
-                        func(p, this->modify(p));
-                    }
-                }
+                func(BrickLocalPosition {getBrickLayoutPosition(i)}, this->data[i]);
             }
         }
 
+        /// data in a form the brick kernels accept
+        [[nodiscard]] std::span<const u16, kernels::VoxelsPerBrick> asU16s() const
+            requires (sizeof(T) == sizeof(u16) && std::is_trivially_copyable_v<T>)
+        {
+            // Every T here is either a u16 or an enum over one, both of which may be read as a u16
+            return std::span<const u16, kernels::VoxelsPerBrick> {
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+                reinterpret_cast<const u16*>(this->data.data()),
+                kernels::VoxelsPerBrick};
+        }
+
         [[nodiscard]] std::optional<T> isSolid() const
         {
-            T maybeSolidT = this->read(BrickLocalPosition {{0, 0, 0}});
+            const T maybeSolidT = this->data[0];
 
-            for (std::size_t x = 0; x < VoxelsPerBrickEdge; ++x)
+            if constexpr (sizeof(T) == sizeof(u16) && std::is_trivially_copyable_v<T>)
             {
-                for (std::size_t y = 0; y < VoxelsPerBrickEdge; ++y)
+                if (!kernels::isUniform(this->asU16s()))
                 {
-                    for (std::size_t z = 0; z < VoxelsPerBrickEdge; ++z)
+                    return std::nullopt;
+                }
+            }
+            else
+            {
+                for (const T& t : this->data)
+                {
+                    if (t != maybeSolidT)
                     {
-                        if (this->read(BrickLocalPosition {{x, y, z}}) != maybeSolidT)
-                        {
-                            return std::nullopt;
-                        }
+                        return std::nullopt;
                     }
                 }
             }
@@ -459,6 +479,19 @@ namespace voxel
     };
     static_assert(std::is_trivially_copyable_v<GreedyVoxelFace>);
 
+    /// Faces of one direction whose roots lie in the same VoxelsPerFaceClusterEdge^3 region of a
+    /// chunk. Bounds are inclusive ChunkLocalPositions of every voxel the faces cover and the face
+    /// range is relative to the start of that direction's faces.
+    struct GreedyFaceCluster
+    {
+        static constexpr u32 VoxelsPerFaceClusterEdge = 16;
+
+        glm::u8vec3 min;
+        glm::u8vec3 max;
+        u32         first_face;
+        u32         number_of_faces;
+    };
+
     struct MaybeBrickPointer
     {
         static constexpr u32 Null = static_cast<u32>(-1);
@@ -474,25 +507,13 @@ namespace voxel
     struct BrickPointer : MaybeBrickPointer
     {};
 
+    /// Whether the voxel casts shadows or is seen by the camera follows from its material, see
+    /// getMaterialOpacity
     class ChunkLocalUpdate
     {
     public:
-        enum class ShadowUpdate : u8
-        {
-            ShadowTransparent = 0,
-            ShadowCasting     = 1,
-        };
-
-        enum class CameraVisibleUpdate : u8
-        {
-            CameraInvisible = 0,
-            CameraVisible   = 1,
-        };
-    public:
-        ChunkLocalUpdate(ChunkLocalPosition p, Voxel v, ShadowUpdate s, CameraVisibleUpdate c)
+        ChunkLocalUpdate(ChunkLocalPosition p, Voxel v)
             : pos_x {p.x}
-            , shadow_casting {std::to_underlying(s)}
-            , camera_visible {std::to_underlying(c)}
             , pos_y {p.y}
             , pos_z {p.z}
             , material {std::bit_cast<std::array<u8, 2>>(v)}
@@ -512,19 +533,9 @@ namespace voxel
         {
             return std::bit_cast<Voxel>(this->material);
         }
-        [[nodiscard]] ShadowUpdate getShadowUpdate() const noexcept
-        {
-            return static_cast<ShadowUpdate>(this->shadow_casting);
-        }
-        [[nodiscard]] CameraVisibleUpdate getCameraVisibility() const noexcept
-        {
-            return static_cast<CameraVisibleUpdate>(this->camera_visible);
-        }
 
     private:
-        u8 pos_x          : 6;
-        u8 shadow_casting : 1;
-        u8 camera_visible : 1;
+        u8 pos_x : 6;
 
         u8 pos_y : 6;
 
@@ -540,39 +551,24 @@ namespace voxel
 
         ChunkBrickMap()
         {
-            for (auto& xyz : this->data)
-            {
-                for (auto& yz : xyz)
-                {
-                    for (u16& z : yz)
-                    {
-                        z = NullOffset;
-                    }
-                }
-            }
+            this->data.fill(NullOffset);
         }
 
         [[nodiscard]] std::optional<u16> getMaxValidOffset() const
         {
             std::optional<u16> maxOffset {};
 
-            for (auto& xyz : this->data)
+            for (u16 offset : this->data)
             {
-                for (auto& yz : xyz)
+                if (offset != NullOffset)
                 {
-                    for (u16 z : yz)
+                    if (maxOffset.has_value())
                     {
-                        if (z != NullOffset)
-                        {
-                            if (maxOffset.has_value())
-                            {
-                                maxOffset = std::max({z, *maxOffset});
-                            }
-                            else
-                            {
-                                maxOffset = z;
-                            }
-                        }
+                        maxOffset = std::max({offset, *maxOffset});
+                    }
+                    else
+                    {
+                        maxOffset = offset;
                     }
                 }
             }
@@ -580,69 +576,100 @@ namespace voxel
             return maxOffset;
         }
 
+        /// Visits bricks in the order they are stored
         void iterateOverBricks(std::invocable<BrickCoordinate, u16> auto func) const
         {
-            for (std::size_t x = 0; x < BricksPerChunkEdge; ++x)
+            for (std::size_t i = 0; i < this->data.size(); ++i)
             {
-                for (std::size_t y = 0; y < BricksPerChunkEdge; ++y)
-                {
-                    for (std::size_t z = 0; z < BricksPerChunkEdge; ++z)
-                    {
-                        const BrickCoordinate p {glm::u8vec3 {x, y, z}};
-
-                        func(p, this->data[x][y][z]); // NOLINT
-                    }
-                }
+                func(BrickCoordinate {getBrickLayoutPosition(i)}, this->data[i]);
             }
         }
 
         void setOffset(BrickCoordinate bC, u16 offset)
         {
-            this->data[bC.x][bC.y][bC.z] = offset; // NOLINT
+            this->data[getBrickLayoutIndex(bC)] = offset; // NOLINT
         }
 
-        u16 getOffset(BrickCoordinate bC)
+        [[nodiscard]] u16 getOffset(BrickCoordinate bC) const
         {
-            return this->data[bC.x][bC.y][bC.z]; // NOLINT
+            return this->data[getBrickLayoutIndex(bC)]; // NOLINT
         }
 
-        std::array<
-            std::array<std::array<u16, BricksPerChunkEdge>, BricksPerChunkEdge>,
-            BricksPerChunkEdge>
-            data;
+        /// Indexed by getBrickLayoutIndex
+        std::array<u16, GpuBrickLayoutSize> data;
     };
 
+    // Layout must match gpu_packBrickParentInformation
     struct BrickParentInformation
     {
-        u32 parent_chunk             : 16;
-        u32 position_in_parent_chunk : 9;
+        u32 parent_chunk             : GpuBrickParentChunkBits;
+        u32 position_in_parent_chunk : 32 - GpuBrickParentChunkBits;
     };
+    static_assert(sizeof(BrickParentInformation) == sizeof(u32));
 
     struct PerChunkGpuData
     {
-        i32           world_offset_x          = 0;
-        i32           world_offset_y          = 0;
-        i32           world_offset_z          = 0;
-        u32           lod                     = 0;
-        u32           brick_allocation_offset = 0;
-        ChunkBrickMap data;
+        i32                world_offset_x          = 0;
+        i32                world_offset_y          = 0;
+        i32                world_offset_z          = 0;
+        u32                lod                     = 0;
+        u32                brick_allocation_offset = 0;
+        // Where each VoxelFaceDirection's faces start in the chunk's single face allocation
+        std::array<u32, 6> direction_face_offsets {};
+        ChunkBrickMap      data;
+    };
+
+    // Box of bricks that block every primary ray, inclusive and in BrickCoordinates
+    struct BrickOccluder
+    {
+        glm::u8vec3 min;
+        glm::u8vec3 max;
     };
 
     struct ChunkAsyncMesh
     {
-        ChunkBrickMap                               new_brick_map;
-        std::vector<BrickParentInformation>         new_parent_bricks;
-        std::vector<MaterialBrick>                  new_material_bricks;
-        std::vector<ShadowBrick>                    new_shadow_bricks;
-        std::vector<PrimaryRayBrick>                new_primary_ray_bricks;
-        std::array<std::vector<GreedyVoxelFace>, 6> new_greedy_faces;
+        ChunkBrickMap                                 new_brick_map;
+        std::vector<BrickParentInformation>           new_parent_bricks;
+        std::vector<MaterialBrick>                    new_material_bricks;
+        std::vector<ShadowBrick>                      new_shadow_bricks;
+        std::array<std::vector<GreedyVoxelFace>, 6>   new_greedy_faces;
+        std::array<std::vector<GreedyFaceCluster>, 6> new_face_clusters;
+        std::vector<BrickOccluder>                    new_occluders;
+        // Bit 1 << VoxelFaceDirection for each face whose bricks all block every primary ray
+        u8                                            new_sealed_faces = 0;
+
+        /// Empties everything but keeps each vector's storage for the next mesh
+        void clear()
+        {
+            this->new_brick_map = ChunkBrickMap {};
+            this->new_parent_bricks.clear();
+            this->new_material_bricks.clear();
+            this->new_shadow_bricks.clear();
+
+            for (std::size_t normal = 0; normal < 6; ++normal)
+            {
+                this->new_greedy_faces[normal].clear();
+                this->new_face_clusters[normal].clear();
+            }
+
+            this->new_occluders.clear();
+            this->new_sealed_faces = 0;
+        }
     };
 
     struct CpuChunkData
     {
-        std::optional<util::RangeAllocation>                active_brick_range_allocation;
-        std::optional<std::array<util::RangeAllocation, 6>> active_draw_allocations;
-
+        std::optional<util::RangeAllocation> active_brick_range_allocation;
+        // Every direction's faces, back to back in VoxelFaceDirection order
+        std::optional<util::RangeAllocation> active_draw_allocation;
+        // cpu copy of the faces behind active_draw_allocation, kept so that the chunk's final
+        // mesh can be cached when it is destroyed
+        std::array<std::vector<GreedyVoxelFace>, 6>   active_greedy_faces;
+        std::array<std::vector<GreedyFaceCluster>, 6> active_face_clusters;
+        std::vector<BrickOccluder>                    active_occluders;
+
+        // Replaces every voxel of the chunk before updates are applied
+        std::optional<Voxel>              pending_fill;
         std::vector<ChunkLocalUpdate>     updates;
         std::future<ChunkAsyncMesh>       maybe_async_mesh;
         std::shared_ptr<std::atomic_bool> maybe_async_mesh_caller_result;
@@ -683,19 +710,11 @@ namespace voxel
             return this->root_position
                  + (static_cast<i32>(gpu_calculateChunkWidthUnits(this->lod)) / 2);
         }
-    };
 
-    struct HashedGpuChunkLocation
-    {
-        static constexpr u32 Empty = ~0u;
-
-        explicit HashedGpuChunkLocation(ChunkLocation c)
-            : hashed_value {gpu_hashChunkCoordinate(c)}
-        {}
-
-        HashedGpuChunkLocation() = default;
-
-        u32 hashed_value = Empty;
+        [[nodiscard]] bool operator== (const ChunkLocation& other) const
+        {
+            return this->root_position == other.root_position && this->lod == other.lod;
+        }
     };
 
     inline u32 calculateLODBasedOnDistance(f32 distance)
@@ -717,6 +736,19 @@ namespace voxel
             return static_cast<u32>(uncorrectedLod) - 1;
         }
     }
+
+    /// The smallest distance for which calculateLODBasedOnDistance returns at least lod
+    inline f32 calculateMinimumDistanceForLOD(u32 lod)
+    {
+        if (lod == 0)
+        {
+            return 0.0f;
+        }
+        else
+        {
+            return static_cast<f32>(VoxelsPerChunkEdge) * static_cast<f32>(1u << lod);
+        }
+    }
 } // namespace voxel
 
 template<>
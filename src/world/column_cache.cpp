@@ -0,0 +1,64 @@
+#include "column_cache.hpp"
+#include <utility>
+
+namespace world
+{
+    namespace
+    {
+        // Enough for every generation thread to miss at once without allocating
+        constexpr std::size_t MaxRetainedColumns = 64;
+    } // namespace
+
+    ColumnCache::ColumnCache(std::size_t maxBytes)
+        : cache {util::LruCache<voxel::ChunkLocation, std::shared_ptr<const ChunkColumns>> {
+              maxBytes}}
+        , free_columns {std::make_shared<ColumnPool>(MaxRetainedColumns)}
+    {}
+
+    std::shared_ptr<const ChunkColumns> ColumnCache::find(voxel::ChunkLocation location) const
+    {
+        return this->cache.lock(
+            [&](util::LruCache<voxel::ChunkLocation, std::shared_ptr<const ChunkColumns>>& c)
+                -> std::shared_ptr<const ChunkColumns>
+            {
+                const std::shared_ptr<const ChunkColumns>* const maybeColumns =
+                    c.find(getFootprint(location));
+
+                return maybeColumns == nullptr ? nullptr : *maybeColumns;
+            });
+    }
+
+    std::shared_ptr<ChunkColumns> ColumnCache::allocate() const
+    {
+        std::unique_ptr<ChunkColumns> storage = this->free_columns->acquire();
+
+        if (storage == nullptr)
+        {
+            storage = std::make_unique<ChunkColumns>();
+        }
+
+        return std::shared_ptr<ChunkColumns> {
+            storage.release(),
+            [pool = this->free_columns](ChunkColumns* columns)
+            {
+                pool->release(std::unique_ptr<ChunkColumns> {columns});
+            }};
+    }
+
+    void ColumnCache::insert(
+        voxel::ChunkLocation location, std::shared_ptr<const ChunkColumns> columns) const
+    {
+        this->cache.lock(
+            [&](util::LruCache<voxel::ChunkLocation, std::shared_ptr<const ChunkColumns>>& c)
+            {
+                c.insert(getFootprint(location), std::move(columns), sizeof(ChunkColumns));
+            });
+    }
+
+    voxel::ChunkLocation ColumnCache::getFootprint(voxel::ChunkLocation location)
+    {
+        location.root_position.y = 0;
+
+        return location;
+    }
+} // namespace world
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "util/lru_cache.hpp"
+#include "util/misc.hpp"
+#include "util/recycling_pool.hpp"
+#include "util/threads.hpp"
+#include "voxel/structures.hpp"
+#include <array>
+#include <memory>
+
+namespace world
+{
+    /// Terrain height of every column under a chunk and of the 1 column border around it, in
+    /// world units, along with the bounds WorldGenerator classifies chunks by
+    struct ChunkColumns
+    {
+        static constexpr std::size_t ApronWidth = 66;
+
+        // [z][x] relative to the apron, chunk local coordinates are offset by 1
+        std::array<std::array<i32, ApronWidth>, ApronWidth> heights;
+
+        i32 min_apron_height;
+        i32 min_footprint_height;
+        i32 max_footprint_height;
+    };
+
+    /// Bounded cache of ChunkColumns keyed by the footprint and lod of the chunks above them, so
+    /// that a vertical stack of chunks evaluates its 2d noise once. Evicted columns have their
+    /// storage reused by later misses once the last chunk using them is done. Threadsafe.
+    class ColumnCache
+    {
+    public:
+        explicit ColumnCache(std::size_t maxBytes);
+
+        /// nullptr if the columns under this chunk aren't cached
+        [[nodiscard]] std::shared_ptr<const ChunkColumns> find(voxel::ChunkLocation) const;
+        /// Uninitialized storage for the columns of a miss
+        [[nodiscard]] std::shared_ptr<ChunkColumns>       allocate() const;
+        void insert(voxel::ChunkLocation, std::shared_ptr<const ChunkColumns>) const;
+
+    private:
+        using ColumnPool = util::RecyclingPool<std::unique_ptr<ChunkColumns>>;
+
+        /// Every chunk of a stack shares the location of the one at height 0
+        [[nodiscard]] static voxel::ChunkLocation getFootprint(voxel::ChunkLocation);
+
+        util::Mutex<util::LruCache<voxel::ChunkLocation, std::shared_ptr<const ChunkColumns>>>
+            cache;
+        // Shared with the deleters of the columns handed out, which may outlive this
+        std::shared_ptr<ColumnPool> free_columns;
+    };
+} // namespace world
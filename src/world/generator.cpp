@@ -1,13 +1,22 @@
 #include "generator.hpp"
 #include "shaders/include/common.glsl"
 #include "voxel/structures.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
 
 namespace world
 {
+    // Roughly 1900 footprints, comfortably more than are in view at once
+    static constexpr std::size_t ColumnCacheBytes = std::size_t {32} << 20u;
+
     WorldGenerator::WorldGenerator(u64 seed_)
         : simplex {FastNoise::New<FastNoise::Simplex>()}
         , fractal {FastNoise::New<FastNoise::FractalFBm>()}
         , seed {seed_}
+        , column_cache {ColumnCacheBytes}
+        , number_of_noise_evaluations {0}
     {
         this->fractal->SetSource(this->simplex);
         this->fractal->SetOctaveCount(1);
@@ -15,31 +24,27 @@ namespace world
         this->fractal->SetLacunarity(2.534f);
     }
 
-    std::vector<voxel::ChunkLocalUpdate>
-    WorldGenerator::generateChunk(voxel::ChunkLocation chunkRoot) const
+    GeneratedChunk WorldGenerator::generateChunk(voxel::ChunkLocation chunkRoot) const
     {
-        const voxel::WorldPosition root {chunkRoot.root_position};
+        return this->generate(chunkRoot, true);
+    }
 
-        const i32 integerScale = static_cast<i32>(gpu_calculateChunkVoxelSizeUnits(chunkRoot.lod));
+    GeneratedChunk WorldGenerator::generateChunkVoxels(voxel::ChunkLocation chunkRoot) const
+    {
+        return this->generate(chunkRoot, false);
+    }
 
-        auto gen2D =
-            [&](float       scale,
-                std::size_t localSeed) -> std::unique_ptr<std::array<std::array<float, 64>, 64>>
-        {
-            std::unique_ptr<std::array<std::array<float, 64>, 64>> res {
-                new std::array<std::array<float, 64>, 64>};
+    u64 WorldGenerator::getNumberOfNoiseEvaluations() const
+    {
+        return this->number_of_noise_evaluations.load(std::memory_order_relaxed);
+    }
 
-            this->fractal->GenUniformGrid2D(
-                res->data()->data(),
-                root.x / integerScale,
-                root.z / integerScale,
-                64,
-                64,
-                scale,
-                static_cast<int>(localSeed));
+    GeneratedChunk
+    WorldGenerator::generate(voxel::ChunkLocation chunkRoot, bool shouldElideBuried) const
+    {
+        const voxel::WorldPosition root {chunkRoot.root_position};
 
-            return res;
-        };
+        const i32 integerScale = static_cast<i32>(gpu_calculateChunkVoxelSizeUnits(chunkRoot.lod));
 
         auto gen3D = [&](float scale, std::size_t localSeed)
             -> std::unique_ptr<std::array<std::array<std::array<float, 64>, 64>, 64>>
@@ -61,15 +66,64 @@ namespace world
             return res;
         };
 
-        auto height     = gen2D(static_cast<float>(integerScale) * 0.001f, this->seed + 487484);
-        auto bumpHeight = gen2D(static_cast<float>(integerScale) * 0.01f, this->seed + 7373834);
-        auto mountainHeight =
-            gen2D(static_cast<float>(integerScale) * 1.0f / 16384.0f, (this->seed * 3884) - 83483);
         // auto mainRock    = gen3D(static_cast<float>(integerScale) * 0.001f, this->seed - 747875);
         // auto pebblesRock = gen3D(static_cast<float>(integerScale) * 0.01f, this->seed -
         // 52649274); auto pebbles     = gen3D(static_cast<float>(integerScale) * 0.05f, this->seed
         // - 948);
 
+        // Every chunk of a vertical stack stands on the same columns
+        std::shared_ptr<const ChunkColumns> columns = this->column_cache.find(chunkRoot);
+
+        if (columns == nullptr)
+        {
+            columns = this->generateColumns(chunkRoot);
+
+            this->column_cache.insert(chunkRoot, columns);
+        }
+
+        const i32 minApronHeight     = columns->min_apron_height;
+        const i32 minFootprintHeight = columns->min_footprint_height;
+        const i32 maxFootprintHeight = columns->max_footprint_height;
+
+        // The bottom voxel of even the highest column is above the grass
+        if ((root.y - maxFootprintHeight) + (4 * integerScale) >= 3 * integerScale)
+        {
+            return GeneratedChunk {.contents {ChunkContents::Empty}, .fill {}, .updates {}};
+        }
+
+        if (shouldElideBuried)
+        {
+            // If the voxel just above this chunk is solid in every column, including the
+            // columns bordering it, then this chunk is entirely solid and every voxel on its
+            // boundary is covered.
+            // That only holds for neighbours of this lod. A neighbour a lod coarser samples the
+            // columns half as often and rounds the surface to voxels twice as tall, so on steep
+            // terrain its surface can sit up to one of its voxels lower than ours, below this
+            // chunk's top. Chunks that close are meshed and their boundary faces close the seam.
+            const i32 worldHeightAboveChunk =
+                static_cast<i32>(64 * gpu_calculateChunkVoxelSizeUnits(chunkRoot.lod)) + root.y;
+            const i32 coarserVoxelSize =
+                static_cast<i32>(gpu_calculateChunkVoxelSizeUnits(chunkRoot.lod + 1));
+
+            if ((worldHeightAboveChunk + coarserVoxelSize - minApronHeight) + (4 * integerScale)
+                < 3 * integerScale)
+            {
+                return GeneratedChunk {.contents {ChunkContents::Buried}, .fill {}, .updates {}};
+            }
+        }
+
+        const voxel::Voxel stone = static_cast<voxel::Voxel>(
+            util::map<float>(0.76f, -1.0f, 1.0f, 14.0f, 18.0f)); // NOLINT
+
+        // The top voxel of even the lowest column is below the dirt
+        const i32 worldHeightOfTopVoxel =
+            static_cast<i32>(63 * gpu_calculateChunkVoxelSizeUnits(chunkRoot.lod)) + root.y;
+
+        if ((worldHeightOfTopVoxel - minFootprintHeight) + (4 * integerScale) < 0)
+        {
+            return GeneratedChunk {.contents {ChunkContents::Solid}, .fill {stone}, .updates {}};
+        }
+
         std::vector<voxel::ChunkLocalUpdate> out {};
         out.reserve(32768);
 
@@ -77,12 +131,9 @@ namespace world
         {
             for (u8 i = 0; i < 64; ++i)
             {
-                // const i32 unscaledWorldHeight =
-                //     static_cast<i32>(std::exp2((*height)[j][i] * 12.0f));
-
-                const i32 unscaledWorldHeight = static_cast<i32>(
-                    (*height)[j][i] * 32.0f + (*bumpHeight)[j][i] * 2.0f
-                    + (*mountainHeight)[j][i] * 1024.0f);
+                // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+                const i32 unscaledWorldHeight = columns->heights[static_cast<std::size_t>(j) + 1]
+                                                                [static_cast<std::size_t>(i) + 1];
 
                 for (u8 h = 0; h < 64; ++h)
                 {
@@ -94,39 +145,125 @@ namespace world
 
                     if (relativeDistanceToHeight < 0 * integerScale)
                     {
-                        out.push_back(voxel::ChunkLocalUpdate {
-                            voxel::ChunkLocalPosition {{i, h, j}},
-                            static_cast<voxel::Voxel>(util::map<float>(
-                                0.76f,
-                                -1.0f,
-                                1.0f,
-                                14.0f,
-                                18.0f)), // NOLINT
-                            voxel::ChunkLocalUpdate::ShadowUpdate::ShadowCasting,
-                            voxel::ChunkLocalUpdate::CameraVisibleUpdate::CameraVisible});
+                        out.push_back(
+                            voxel::ChunkLocalUpdate {voxel::ChunkLocalPosition {{i, h, j}}, stone});
                     }
                     else if (relativeDistanceToHeight < 2 * integerScale)
                     {
                         out.push_back(voxel::ChunkLocalUpdate {
-                            voxel::ChunkLocalPosition {{i, h, j}},
-                            voxel::Voxel::Dirt,
-                            voxel::ChunkLocalUpdate::ShadowUpdate::ShadowCasting,
-                            voxel::ChunkLocalUpdate::CameraVisibleUpdate::CameraVisible});
+                            voxel::ChunkLocalPosition {{i, h, j}}, voxel::Voxel::Dirt});
                     }
                     else if (relativeDistanceToHeight < 3 * integerScale)
 
                     {
                         out.push_back(voxel::ChunkLocalUpdate {
-                            voxel::ChunkLocalPosition {{i, h, j}},
-                            voxel::Voxel::Grass,
-                            voxel::ChunkLocalUpdate::ShadowUpdate::ShadowCasting,
-                            voxel::ChunkLocalUpdate::CameraVisibleUpdate::CameraVisible});
+                            voxel::ChunkLocalPosition {{i, h, j}}, voxel::Voxel::Grass});
                     }
                 }
             }
         }
 
-        return out;
+        if (out.empty())
+        {
+            return GeneratedChunk {.contents {ChunkContents::Empty}, .fill {}, .updates {}};
+        }
+
+        return GeneratedChunk {
+            .contents {ChunkContents::Surface}, .fill {}, .updates {std::move(out)}};
+    }
+
+    std::shared_ptr<const ChunkColumns>
+    WorldGenerator::generateColumns(voxel::ChunkLocation chunkRoot) const
+    {
+        static constexpr std::size_t ApronWidth = ChunkColumns::ApronWidth;
+
+        using NoiseGrid = std::array<std::array<float, ApronWidth>, ApronWidth>;
+
+        // Noise is only ever needed until it is folded into heights, so each thread reuses one
+        struct NoiseScratch
+        {
+            NoiseGrid height;
+            NoiseGrid bump_height;
+            NoiseGrid mountain_height;
+        };
+
+        thread_local std::unique_ptr<NoiseScratch> maybeScratch {};
+
+        if (maybeScratch == nullptr)
+        {
+            maybeScratch = std::make_unique<NoiseScratch>();
+        }
+
+        NoiseScratch& scratch = *maybeScratch;
+
+        const voxel::WorldPosition root {chunkRoot.root_position};
+
+        const i32 integerScale = static_cast<i32>(gpu_calculateChunkVoxelSizeUnits(chunkRoot.lod));
+
+        // Heights are generated with a 1 column border so we can tell whether our neighbors
+        // cover every side of this chunk
+        auto gen2D = [&](NoiseGrid& out, float scale, std::size_t localSeed)
+        {
+            this->fractal->GenUniformGrid2D(
+                out.data()->data(),
+                (root.x / integerScale) - 1,
+                (root.z / integerScale) - 1,
+                static_cast<int>(ApronWidth),
+                static_cast<int>(ApronWidth),
+                scale,
+                static_cast<int>(localSeed));
+
+            this->number_of_noise_evaluations.fetch_add(
+                ApronWidth * ApronWidth, std::memory_order_relaxed);
+        };
+
+        gen2D(scratch.height, static_cast<float>(integerScale) * 0.001f, this->seed + 487484);
+        gen2D(
+            scratch.bump_height, static_cast<float>(integerScale) * 0.01f, this->seed + 7373834);
+        gen2D(
+            scratch.mountain_height,
+            static_cast<float>(integerScale) * 1.0f / 16384.0f,
+            (this->seed * 3884) - 83483);
+
+        std::shared_ptr<ChunkColumns> columns = this->column_cache.allocate();
+
+        // Everything generate decides is by how far each voxel is from its column's height, so
+        // the extremes of the heights are enough to rule out most chunks before the voxel loop
+        columns->min_apron_height     = std::numeric_limits<i32>::max();
+        columns->min_footprint_height = std::numeric_limits<i32>::max();
+        columns->max_footprint_height = std::numeric_limits<i32>::min();
+
+        for (std::size_t j = 0; j < ApronWidth; ++j)
+        {
+            for (std::size_t i = 0; i < ApronWidth; ++i)
+            {
+                // const i32 unscaledWorldHeight =
+                //     static_cast<i32>(std::exp2(scratch.height[j][i] * 12.0f));
+
+                // NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+                const i32 worldHeight = static_cast<i32>(
+                    scratch.height[j][i] * 32.0f + scratch.bump_height[j][i] * 2.0f
+                    + scratch.mountain_height[j][i] * 1024.0f);
+
+                columns->heights[j][i] = worldHeight;
+                // NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+                const bool isInFootprint =
+                    j != 0 && i != 0 && j != ApronWidth - 1 && i != ApronWidth - 1;
+
+                columns->min_apron_height = std::min(columns->min_apron_height, worldHeight);
+
+                if (isInFootprint)
+                {
+                    columns->min_footprint_height =
+                        std::min(columns->min_footprint_height, worldHeight);
+                    columns->max_footprint_height =
+                        std::max(columns->max_footprint_height, worldHeight);
+                }
+            }
+        }
+
+        return columns;
     }
 } // namespace world
 
@@ -1,24 +1,58 @@
 #pragma once
 
+#include "column_cache.hpp"
 #include "util/misc.hpp"
 #include "voxel/structures.hpp"
 #include <FastNoise/FastNoise.h>
+#include <atomic>
+#include <memory>
 
 namespace world
 {
+    enum class ChunkContents : u8
+    {
+        /// No voxels at all
+        Empty,
+        /// Entirely solid and so is everything touching it, nothing can ever be seen
+        Buried,
+        /// Every voxel is GeneratedChunk::fill, but some of them may be seen
+        Solid,
+        /// Has at least one voxel that may be seen
+        Surface,
+    };
+
+    struct GeneratedChunk
+    {
+        ChunkContents contents = ChunkContents::Empty;
+        // Only populated for ChunkContents::Solid
+        voxel::Voxel fill = voxel::Voxel::NullAirEmpty;
+        // Only populated for ChunkContents::Surface
+        std::vector<voxel::ChunkLocalUpdate> updates;
+    };
 
     class WorldGenerator
     {
     public:
         explicit WorldGenerator(u64 seed);
 
-        [[nodiscard]] std::vector<voxel::ChunkLocalUpdate>
-            generateChunk(voxel::ChunkLocation) const;
+        [[nodiscard]] GeneratedChunk generateChunk(voxel::ChunkLocation) const;
+
+        /// Generates a chunk without eliding it as buried, for when a chunk that was elided
+        /// needs to exist after all. The result is never ChunkContents::Buried
+        [[nodiscard]] GeneratedChunk generateChunkVoxels(voxel::ChunkLocation) const;
+
+        /// Points of 2d noise evaluated so far, columns shared through the cache count once
+        [[nodiscard]] u64 getNumberOfNoiseEvaluations() const;
 
     private:
+        [[nodiscard]] GeneratedChunk generate(voxel::ChunkLocation, bool shouldElideBuried) const;
+        [[nodiscard]] std::shared_ptr<const ChunkColumns>
+            generateColumns(voxel::ChunkLocation) const;
 
         FastNoise::SmartNode<FastNoise::Simplex>    simplex;
         FastNoise::SmartNode<FastNoise::FractalFBm> fractal;
         std::size_t                                 seed;
+        ColumnCache                                 column_cache;
+        mutable std::atomic<u64>                    number_of_noise_evaluations;
     };
 } // namespace world
\ No newline at end of file
@@ -0,0 +1,316 @@
+#include "shaders/include/common.glsl"
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/brick_kernels.hpp"
+#include <array>
+#include <random>
+#include <vector>
+
+// Built once for each brick layout. Every instruction set this cpu supports is checked against
+// references written voxel by voxel, which also checks the reordering from memory to BitBrick
+// order that the vector paths of extractMask depend on.
+
+namespace
+{
+    using namespace voxel::kernels;
+
+    using Values = std::array<u16, VoxelsPerBrick>;
+
+    constexpr std::array<InstructionSet, 4> AllInstructionSets {
+        InstructionSet::Scalar, InstructionSet::Avx2, InstructionSet::Avx512, InstructionSet::Neon};
+
+    u32 getBitIndex(u32 x, u32 y, u32 z)
+    {
+        return x + (8 * y) + (64 * z);
+    }
+
+    bool getBit(const BitWords& words, u32 bit)
+    {
+        return ((words[bit / 32] >> (bit % 32)) & 1U) != 0;
+    }
+
+    void setBit(BitWords& words, u32 bit)
+    {
+        words[bit / 32] |= 1U << (bit % 32);
+    }
+
+    BitWords referenceExtractMask(const Values& values, u16 value)
+    {
+        BitWords out {};
+
+        for (u32 z = 0; z < 8; ++z)
+        {
+            for (u32 y = 0; y < 8; ++y)
+            {
+                for (u32 x = 0; x < 8; ++x)
+                {
+                    if (values[gpu_brickLayoutIndex(glm::uvec3 {x, y, z})] == value)
+                    {
+                        setBit(out, getBitIndex(x, y, z));
+                    }
+                }
+            }
+        }
+
+        return out;
+    }
+
+    BitWords referenceShift(const BitWords& in, u32 axis, bool positive)
+    {
+        BitWords out {};
+
+        for (u32 z = 0; z < 8; ++z)
+        {
+            for (u32 y = 0; y < 8; ++y)
+            {
+                for (u32 x = 0; x < 8; ++x)
+                {
+                    // Unsigned, so stepping off the negative side wraps and is dropped too
+                    glm::uvec3 from {x, y, z};
+                    from[static_cast<glm::length_t>(axis)] += positive ? ~0U : 1U;
+
+                    if (from.x < 8 && from.y < 8 && from.z < 8
+                        && getBit(in, getBitIndex(from.x, from.y, from.z)))
+                    {
+                        setBit(out, getBitIndex(x, y, z));
+                    }
+                }
+            }
+        }
+
+        return out;
+    }
+
+    u32 referencePopcount(const BitWords& words)
+    {
+        u32 count = 0;
+
+        for (u32 bit = 0; bit < VoxelsPerBrick; ++bit)
+        {
+            count += getBit(words, bit) ? 1 : 0;
+        }
+
+        return count;
+    }
+
+    /// Runs check once with each instruction set this cpu supports selected
+    template<class Fn>
+    void forEachInstructionSet(const Fn& check)
+    {
+        const InstructionSet original = getInstructionSet();
+
+        for (const InstructionSet i : AllInstructionSets)
+        {
+            if (isInstructionSetSupported(i))
+            {
+                setInstructionSet(i);
+
+                check(getInstructionSetName(i));
+            }
+        }
+
+        setInstructionSet(original);
+    }
+
+    void checkLayoutIsPermutation()
+    {
+        std::vector<bool> seen(VoxelsPerBrick, false);
+
+        for (u32 index = 0; index < VoxelsPerBrick; ++index)
+        {
+            const glm::uvec3 position = gpu_brickLayoutPosition(index);
+
+            util::assertFatal(
+                gpu_brickLayoutIndex(position) == index,
+                "Layout index {} doesn't round trip",
+                index);
+            util::assertFatal(!seen[index], "Layout index {} is used twice", index);
+
+            seen[index] = true;
+        }
+    }
+
+    void checkRandomBricks()
+    {
+        forEachInstructionSet(
+            [](const char* name)
+            {
+                std::mt19937                       generator {0x6c617665}; // NOLINT
+                std::uniform_int_distribution<u32> wordDistribution {};
+                // A small palette so that uniform bricks and matching values both come up
+                std::uniform_int_distribution<u32> valueDistribution {0, 3};
+
+                for (u32 iteration = 0; iteration < 256; ++iteration)
+                {
+                    BitWords l {};
+                    BitWords r {};
+
+                    for (std::size_t i = 0; i < l.size(); ++i)
+                    {
+                        l[i] = wordDistribution(generator);
+                        r[i] = wordDistribution(generator);
+                    }
+
+                    if (iteration % 4 == 1)
+                    {
+                        l.fill(0);
+                    }
+                    else if (iteration % 4 == 2)
+                    {
+                        l.fill(~u32 {0});
+                    }
+
+                    Values    values {};
+                    const u16 fillValue = static_cast<u16>(valueDistribution(generator));
+
+                    for (u16& v : values)
+                    {
+                        // Every 8th brick is uniform
+                        v = iteration % 8 == 3 ? fillValue
+                                               : static_cast<u16>(valueDistribution(generator));
+                    }
+
+                    const u32 expectedPopcount = referencePopcount(l);
+                    bool      expectedUniform  = true;
+
+                    for (const u16 v : values)
+                    {
+                        expectedUniform &= v == values[0];
+                    }
+
+                    util::assertFatal(
+                        isUniform(values) == expectedUniform, "{} isUniform mismatch", name);
+                    util::assertFatal(
+                        isEmpty(l) == (expectedPopcount == 0), "{} isEmpty mismatch", name);
+                    util::assertFatal(
+                        isFull(l) == (expectedPopcount == VoxelsPerBrick),
+                        "{} isFull mismatch",
+                        name);
+                    util::assertFatal(
+                        popcount(l) == expectedPopcount, "{} popcount mismatch", name);
+
+                    BitWords actual {};
+
+                    bitAnd(actual, l, r);
+                    for (std::size_t i = 0; i < l.size(); ++i)
+                    {
+                        util::assertFatal(actual[i] == (l[i] & r[i]), "{} bitAnd mismatch", name);
+                    }
+
+                    bitOr(actual, l, r);
+                    for (std::size_t i = 0; i < l.size(); ++i)
+                    {
+                        util::assertFatal(actual[i] == (l[i] | r[i]), "{} bitOr mismatch", name);
+                    }
+
+                    bitAndNot(actual, l, r);
+                    for (std::size_t i = 0; i < l.size(); ++i)
+                    {
+                        util::assertFatal(
+                            actual[i] == (l[i] & ~r[i]), "{} bitAndNot mismatch", name);
+                    }
+
+                    extractMask(actual, values, fillValue);
+                    util::assertFatal(
+                        actual == referenceExtractMask(values, fillValue),
+                        "{} extractMask mismatch",
+                        name);
+
+                    for (u32 axis = 0; axis < 3; ++axis)
+                    {
+                        for (const bool positive : {false, true})
+                        {
+                            shift(actual, l, axis, positive);
+                            util::assertFatal(
+                                actual == referenceShift(l, axis, positive),
+                                "{} shift mismatch | Axis: {} Positive: {}",
+                                name,
+                                axis,
+                                positive);
+                        }
+                    }
+                }
+            });
+    }
+
+    // A single matching voxel at every position, so that any misplaced bit of the reordering
+    // from memory order shows up on its own
+    void checkExtractMaskOfEveryVoxel()
+    {
+        forEachInstructionSet(
+            [](const char* name)
+            {
+                for (u32 index = 0; index < VoxelsPerBrick; ++index)
+                {
+                    Values values {};
+                    values[index] = 1;
+
+                    const glm::uvec3 position = gpu_brickLayoutPosition(index);
+                    BitWords         expected {};
+                    BitWords         actual {};
+
+                    setBit(expected, getBitIndex(position.x, position.y, position.z));
+                    extractMask(actual, values, 1);
+
+                    util::assertFatal(
+                        actual == expected,
+                        "{} extractMask misplaces voxel {} {} {}",
+                        name,
+                        position.x,
+                        position.y,
+                        position.z);
+
+                    // Matching 0 is the complement
+                    for (u32& w : expected)
+                    {
+                        w = ~w;
+                    }
+                    extractMask(actual, values, 0);
+
+                    util::assertFatal(
+                        actual == expected,
+                        "{} extractMask of 0 misplaces voxel {} {} {}",
+                        name,
+                        position.x,
+                        position.y,
+                        position.z);
+                }
+            });
+    }
+
+    // Single voxels on every face, edge and corner are where bits wrap into other rows or slices
+    void checkShiftOfEveryVoxel()
+    {
+        for (u32 bit = 0; bit < VoxelsPerBrick; ++bit)
+        {
+            BitWords in {};
+            setBit(in, bit);
+
+            for (u32 axis = 0; axis < 3; ++axis)
+            {
+                for (const bool positive : {false, true})
+                {
+                    BitWords actual {};
+                    shift(actual, in, axis, positive);
+
+                    util::assertFatal(
+                        actual == referenceShift(in, axis, positive),
+                        "shift moves bit {} wrongly | Axis: {} Positive: {}",
+                        bit,
+                        axis,
+                        positive);
+                }
+            }
+        }
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"layout is a permutation", checkLayoutIsPermutation},
+        {"random bricks", checkRandomBricks},
+        {"extractMask of every voxel", checkExtractMaskOfEveryVoxel},
+        {"shift of every voxel", checkShiftOfEveryVoxel},
+    });
+}
@@ -0,0 +1,490 @@
+#include "shaders/include/common.glsl"
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/chunk_bounds_table.hpp"
+#include "voxel/structures.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using voxel::ChunkBoundsTable;
+    using voxel::ChunkLocation;
+
+    using Planes = std::array<glm::vec4, 6>;
+
+    constexpr std::array<u32, 6> NoFaceOffsets {0, 1, 2, 3, 4, 5};
+    constexpr std::array<u32, 6> OneFaceEach {1, 1, 1, 1, 1, 1};
+    constexpr u8                 AllDirections = 0b11'1111;
+
+    /// The axis aligned box [-halfWidth, halfWidth] on every axis
+    Planes getBoxPlanes(f32 halfWidth)
+    {
+        return Planes {
+            glm::vec4 {1.0f, 0.0f, 0.0f, halfWidth},
+            glm::vec4 {-1.0f, 0.0f, 0.0f, halfWidth},
+            glm::vec4 {0.0f, 1.0f, 0.0f, halfWidth},
+            glm::vec4 {0.0f, -1.0f, 0.0f, halfWidth},
+            glm::vec4 {0.0f, 0.0f, 1.0f, halfWidth},
+            glm::vec4 {0.0f, 0.0f, -1.0f, halfWidth},
+        };
+    }
+
+    ChunkLocation getLocation(i32 x, i32 y, i32 z, u32 lod)
+    {
+        return ChunkLocation {glm::ivec3 {x, y, z}, lod};
+    }
+
+    u8 cullOne(const Planes& planes, glm::vec3 cameraPosition, ChunkLocation location)
+    {
+        ChunkBoundsTable table {};
+        std::vector<u8>  visibleDirections {};
+
+        table.setBounds(0, location);
+        table.setDrawRanges(0, NoFaceOffsets, OneFaceEach);
+        table.cull(planes, cameraPosition, visibleDirections);
+
+        return visibleDirections[0];
+    }
+
+    struct ReferenceResult
+    {
+        bool is_visible;
+        bool intersects_frustum;
+    };
+
+    // Every corner of the box against every plane, rather than cull's center and extent
+    ReferenceResult referenceCull(const Planes& planes, glm::vec3 min, glm::vec3 max)
+    {
+        ReferenceResult result {.is_visible {true}, .intersects_frustum {false}};
+
+        for (const glm::vec4& plane : planes)
+        {
+            bool anyCornerInside  = false;
+            bool anyCornerOutside = false;
+
+            for (u32 corner = 0; corner < 8; ++corner)
+            {
+                const glm::vec3 p {
+                    (corner & 1U) != 0 ? max.x : min.x,
+                    (corner & 2U) != 0 ? max.y : min.y,
+                    (corner & 4U) != 0 ? max.z : min.z};
+
+                const f32 distance =
+                    (plane.x * p.x) + (plane.y * p.y) + (plane.z * p.z) + plane.w;
+
+                anyCornerInside |= distance >= 0.0f;
+                anyCornerOutside |= distance < 0.0f;
+            }
+
+            result.is_visible &= anyCornerInside;
+            result.intersects_frustum |= anyCornerOutside;
+        }
+
+        return result;
+    }
+
+    void checkInsideOutsideAndStraddling()
+    {
+        const Planes    planes = getBoxPlanes(256.0f);
+        const glm::vec3 camera {0.0f, 0.0f, 0.0f};
+
+        const u8 inside = cullOne(planes, camera, getLocation(-64, -64, -64, 1));
+        util::assertFatal(inside != 0, "A chunk inside the frustum was culled");
+        util::assertFatal(
+            (inside & ChunkBoundsTable::IntersectsFrustumBit) == 0,
+            "A chunk wholly inside the frustum was marked as intersecting it");
+
+        const u8 outside = cullOne(planes, camera, getLocation(512, 0, 0, 0));
+        util::assertFatal(outside == 0, "A chunk outside the frustum wasn't culled");
+
+        // Across x = 256, and then across both x = 256 and y = -256
+        for (const ChunkLocation location :
+             {getLocation(224, 0, 0, 0), getLocation(224, -288, 0, 0)})
+        {
+            const u8 straddling = cullOne(planes, camera, location);
+            util::assertFatal(
+                (straddling & ChunkBoundsTable::IntersectsFrustumBit) != 0,
+                "A chunk across a plane wasn't marked as intersecting the frustum");
+        }
+
+        // A box containing the whole frustum crosses every plane but is still visible
+        const u8 containing = cullOne(planes, camera, getLocation(-1024, -1024, -1024, 5));
+        util::assertFatal(
+            containing == (AllDirections | ChunkBoundsTable::IntersectsFrustumBit),
+            "A chunk containing the frustum was culled | {}",
+            containing);
+    }
+
+    void checkTouchingPlanes()
+    {
+        const Planes    planes = getBoxPlanes(256.0f);
+        const glm::vec3 camera {0.0f, 0.0f, 0.0f};
+
+        // Its min face lies on x = 256, a box that only touches a plane is kept
+        const u8 touchingFromOutside = cullOne(planes, camera, getLocation(256, 0, 0, 0));
+        util::assertFatal(
+            touchingFromOutside != 0, "A chunk touching the frustum from outside was culled");
+
+        // Its max face lies on x = 256, it is inside and doesn't cross the plane
+        const u8 touchingFromInside = cullOne(planes, camera, getLocation(192, 0, 0, 0));
+        util::assertFatal(
+            touchingFromInside != 0
+                && (touchingFromInside & ChunkBoundsTable::IntersectsFrustumBit) == 0,
+            "A chunk touching the frustum from inside was marked as intersecting | {}",
+            touchingFromInside);
+
+        // One unit past the plane
+        const u8 justOutside = cullOne(planes, camera, getLocation(257, 0, 0, 0));
+        util::assertFatal(justOutside == 0, "A chunk just outside the frustum wasn't culled");
+    }
+
+    // Each plane on its own is tested exactly, but a box can be outside the frustum while being
+    // inside of every plane near its corners. Those have to be kept, never the other way around.
+    void checkConservativeAtFrustumCorners()
+    {
+        // A wedge x + z <= 0 and x - z <= 0, the box is past the tip but inside of each plane
+        const f32 invSqrt2 = 1.0f / std::sqrt(2.0f);
+        Planes    planes   = getBoxPlanes(4096.0f);
+        planes[0]          = glm::vec4 {-invSqrt2, 0.0f, -invSqrt2, 0.0f};
+        planes[1]          = glm::vec4 {-invSqrt2, 0.0f, invSqrt2, 0.0f};
+
+        const u8 pastTheTip =
+            cullOne(planes, glm::vec3 {-1000.0f, 0.0f, 0.0f}, getLocation(1, 0, -32, 0));
+
+        // Kept, but marked so that its clusters are culled one by one
+        util::assertFatal(
+            (pastTheTip & ChunkBoundsTable::IntersectsFrustumBit) != 0,
+            "A chunk past the wedge's tip wasn't kept as intersecting it | {}",
+            pastTheTip);
+
+        const u8 acrossTheTip =
+            cullOne(planes, glm::vec3 {-1000.0f, 0.0f, 0.0f}, getLocation(-16, 0, -32, 0));
+
+        util::assertFatal(
+            (acrossTheTip & ChunkBoundsTable::IntersectsFrustumBit) != 0,
+            "A chunk across the wedge's tip wasn't marked as intersecting it");
+    }
+
+    void checkAgainstReference()
+    {
+        // Small whole numbers everywhere, so that both ways of getting each distance are exact
+        // and chunks lying on a plane come up too
+        std::mt19937                       generator {0x6c617665}; // NOLINT
+        std::uniform_int_distribution<i32> normalComponent {-3, 3};
+        std::uniform_int_distribution<i32> planeOffset {-4096, 4096};
+        std::uniform_int_distribution<i32> chunkPosition {-64, 64};
+        std::uniform_int_distribution<u32> chunkLod {0, 3};
+
+        ChunkBoundsTable           table {};
+        std::vector<ChunkLocation> locations {};
+
+        for (u32 chunkId = 0; chunkId < 4096; ++chunkId)
+        {
+            const ChunkLocation location = getLocation(
+                chunkPosition(generator) * 64,
+                chunkPosition(generator) * 64,
+                chunkPosition(generator) * 64,
+                chunkLod(generator));
+
+            table.setBounds(chunkId, location);
+            table.setDrawRanges(chunkId, NoFaceOffsets, OneFaceEach);
+            locations.push_back(location);
+        }
+
+        std::vector<u8> visibleDirections {};
+
+        for (u32 iteration = 0; iteration < 64; ++iteration)
+        {
+            Planes planes {};
+
+            for (glm::vec4& p : planes)
+            {
+                p = glm::vec4 {
+                    static_cast<f32>(normalComponent(generator)),
+                    static_cast<f32>(normalComponent(generator)),
+                    static_cast<f32>(normalComponent(generator)),
+                    static_cast<f32>(planeOffset(generator))};
+            }
+
+            table.cull(planes, glm::vec3 {0.0f}, visibleDirections);
+
+            for (u32 chunkId = 0; chunkId < locations.size(); ++chunkId)
+            {
+                const glm::vec3 min {locations[chunkId].root_position};
+                const f32       width =
+                    static_cast<f32>(gpu_calculateChunkWidthUnits(locations[chunkId].lod));
+
+                const ReferenceResult expected = referenceCull(planes, min, min + width);
+                const u8              actual   = visibleDirections[chunkId];
+
+                util::assertFatal(
+                    (actual != 0) == expected.is_visible,
+                    "Chunk {} visibility differs from the reference",
+                    chunkId);
+                util::assertFatal(
+                    actual == 0
+                        || ((actual & ChunkBoundsTable::IntersectsFrustumBit) != 0)
+                               == expected.intersects_frustum,
+                    "Chunk {} IntersectsFrustumBit differs from the reference",
+                    chunkId);
+            }
+        }
+    }
+
+    void checkChunksWithoutDrawRanges()
+    {
+        const Planes     planes = getBoxPlanes(4096.0f);
+        ChunkBoundsTable table {};
+        std::vector<u8>  visibleDirections {};
+
+        table.setBounds(0, getLocation(0, 0, 0, 0));
+        table.setBounds(1, getLocation(64, 0, 0, 0));
+        table.setDrawRanges(1, NoFaceOffsets, OneFaceEach);
+        table.setBounds(2, getLocation(128, 0, 0, 0));
+        table.setDrawRanges(2, NoFaceOffsets, OneFaceEach);
+        table.clear(2);
+
+        table.cull(planes, glm::vec3 {0.0f}, visibleDirections);
+
+        util::assertFatal(
+            visibleDirections.size() == table.size(), "cull didn't write every chunk slot");
+        util::assertFatal(visibleDirections[0] == 0, "A chunk without draw ranges was drawn");
+        util::assertFatal(visibleDirections[1] != 0, "A chunk with draw ranges was culled");
+        util::assertFatal(visibleDirections[2] == 0, "A cleared chunk was drawn");
+        util::assertFatal(
+            std::all_of(
+                visibleDirections.cbegin() + 3,
+                visibleDirections.cend(),
+                [](u8 d)
+                {
+                    return d == 0;
+                }),
+            "An unused chunk slot was drawn");
+    }
+
+    void checkParallelMatchesSerial()
+    {
+        const Planes     planes = getBoxPlanes(2048.0f);
+        ChunkBoundsTable table {};
+        std::vector<u8>  serial {};
+        std::vector<u8>  parallel {};
+
+        // Nothing to cull at all
+        table.cullParallel(planes, glm::vec3 {0.0f}, parallel);
+        util::assertFatal(parallel.empty(), "cullParallel of an empty table wrote chunks");
+
+        // Enough chunks for several tasks, some in and some out of the frustum
+        const u32 numberOfChunks = static_cast<u32>(ChunkBoundsTable::ChunksPerTask * 5) + 17;
+
+        for (u32 chunkId = 0; chunkId < numberOfChunks; ++chunkId)
+        {
+            const i32 i = static_cast<i32>(chunkId);
+
+            table.setBounds(
+                chunkId,
+                getLocation(((i % 128) - 64) * 64, ((i / 128) % 8) * 64, (i / 1024) * 64, 0));
+            table.setDrawRanges(chunkId, NoFaceOffsets, OneFaceEach);
+        }
+
+        table.cull(planes, glm::vec3 {10.0f, 20.0f, 30.0f}, serial);
+        table.cullParallel(planes, glm::vec3 {10.0f, 20.0f, 30.0f}, parallel);
+
+        util::assertFatal(serial == parallel, "cullParallel differs from cull");
+    }
+    // Faces facing along a normal lie anywhere between the box's nearest and furthest extent
+    // along it, a direction is only skipped when the camera is strictly behind all of them
+    u8 referenceDirections(glm::vec3 cameraPosition, glm::vec3 min, glm::vec3 max)
+    {
+        u8 directions = 0;
+
+        for (u8 d = 0; d < 6; ++d)
+        {
+            const glm::vec3 normal {
+                voxel::getDirFromDirection(static_cast<voxel::VoxelFaceDirection>(d))};
+            f32             nearestFace = std::numeric_limits<f32>::max();
+
+            for (u32 corner = 0; corner < 8; ++corner)
+            {
+                const glm::vec3 p {
+                    (corner & 1U) != 0 ? max.x : min.x,
+                    (corner & 2U) != 0 ? max.y : min.y,
+                    (corner & 4U) != 0 ? max.z : min.z};
+
+                nearestFace = std::min(nearestFace, glm::dot(normal, p));
+            }
+
+            if (!(glm::dot(normal, cameraPosition) < nearestFace))
+            {
+                directions |= static_cast<u8>(1U << d);
+            }
+        }
+
+        return directions;
+    }
+
+    u8 getDirectionBit(voxel::VoxelFaceDirection direction)
+    {
+        return static_cast<u8>(1U << util::toUnderlying(direction));
+    }
+
+    void checkCameraInsideAndOnTheBox()
+    {
+        using enum voxel::VoxelFaceDirection;
+
+        const Planes        planes = getBoxPlanes(4096.0f);
+        const ChunkLocation chunk  = getLocation(0, 0, 0, 0);
+
+        util::assertFatal(
+            cullOne(planes, glm::vec3 {32.0f, 32.0f, 32.0f}, chunk) == AllDirections,
+            "A camera inside the chunk didn't see every direction");
+
+        // On a face, edge or corner of the box every direction is still kept, the faces in the
+        // plane the camera is on are edge on
+        for (const glm::vec3 onTheBox :
+             {glm::vec3 {0.0f, 32.0f, 32.0f},
+              glm::vec3 {64.0f, 32.0f, 32.0f},
+              glm::vec3 {32.0f, 0.0f, 32.0f},
+              glm::vec3 {32.0f, 64.0f, 32.0f},
+              glm::vec3 {32.0f, 32.0f, 0.0f},
+              glm::vec3 {32.0f, 32.0f, 64.0f},
+              glm::vec3 {0.0f, 64.0f, 32.0f},
+              glm::vec3 {64.0f, 0.0f, 64.0f}})
+        {
+            const u8 directions = cullOne(planes, onTheBox, chunk);
+
+            util::assertFatal(
+                directions == AllDirections,
+                "A camera on the chunk at {} {} {} skipped a direction | {}",
+                onTheBox.x,
+                onTheBox.y,
+                onTheBox.z,
+                directions);
+        }
+
+        // Just past each face only the faces pointing away from the camera are skipped
+        struct JustOutside
+        {
+            glm::vec3                 camera_position;
+            voxel::VoxelFaceDirection skipped;
+        };
+
+        for (const JustOutside& j :
+             {JustOutside {glm::vec3 {32.0f, 64.5f, 32.0f}, Bottom},
+              JustOutside {glm::vec3 {32.0f, -0.5f, 32.0f}, Top},
+              JustOutside {glm::vec3 {-0.5f, 32.0f, 32.0f}, Right},
+              JustOutside {glm::vec3 {64.5f, 32.0f, 32.0f}, Left},
+              JustOutside {glm::vec3 {32.0f, 32.0f, -0.5f}, Back},
+              JustOutside {glm::vec3 {32.0f, 32.0f, 64.5f}, Front}})
+        {
+            const u8 directions = cullOne(planes, j.camera_position, chunk);
+
+            util::assertFatal(
+                directions == (AllDirections & ~getDirectionBit(j.skipped)),
+                "A camera just past a face didn't skip only {} | {}",
+                util::toUnderlying(j.skipped),
+                directions);
+        }
+
+        // Past an edge two directions are skipped, past a corner three
+        util::assertFatal(
+            cullOne(planes, glm::vec3 {-1.0f, 65.0f, 32.0f}, chunk)
+                == (AllDirections & ~getDirectionBit(Right) & ~getDirectionBit(Bottom)),
+            "A camera past an edge didn't skip the two directions facing away");
+        util::assertFatal(
+            cullOne(planes, glm::vec3 {65.0f, -1.0f, 65.0f}, chunk)
+                == (AllDirections & ~getDirectionBit(Left) & ~getDirectionBit(Top)
+                    & ~getDirectionBit(Front)),
+            "A camera past a corner didn't skip the three directions facing away");
+    }
+
+    // A camera on the face shared by two chunks is on the boundary of both, neither may lose
+    // the faces that it could be looking along
+    void checkCameraBetweenChunks()
+    {
+        const Planes     planes = getBoxPlanes(4096.0f);
+        ChunkBoundsTable table {};
+        std::vector<u8>  visibleDirections {};
+
+        table.setBounds(0, getLocation(0, 0, 0, 0));
+        table.setBounds(1, getLocation(64, 0, 0, 0));
+        // A coarser chunk whose face touches both
+        table.setBounds(2, getLocation(-128, 0, 0, 1));
+
+        for (u32 chunkId = 0; chunkId < 3; ++chunkId)
+        {
+            table.setDrawRanges(chunkId, NoFaceOffsets, OneFaceEach);
+        }
+
+        table.cull(planes, glm::vec3 {64.0f, 16.0f, 16.0f}, visibleDirections);
+
+        util::assertFatal(
+            visibleDirections[0] == AllDirections && visibleDirections[1] == AllDirections,
+            "Chunks sharing the face the camera is on skipped a direction | {} {}",
+            visibleDirections[0],
+            visibleDirections[1]);
+        util::assertFatal(
+            visibleDirections[2]
+                == (AllDirections & ~getDirectionBit(voxel::VoxelFaceDirection::Left)),
+            "The further chunk didn't skip only its faces pointing away | {}",
+            visibleDirections[2]);
+
+        table.cull(planes, glm::vec3 {0.0f, 16.0f, 16.0f}, visibleDirections);
+
+        util::assertFatal(
+            visibleDirections[0] == AllDirections && visibleDirections[2] == AllDirections,
+            "Chunks of different lods sharing the face the camera is on skipped a direction");
+    }
+
+    void checkDirectionsAgainstReference()
+    {
+        // Whole and half units so that cameras land on, and just next to, every boundary
+        std::mt19937                       generator {0x6c617665}; // NOLINT
+        std::uniform_int_distribution<i32> halfUnits {-160, 160};
+
+        const Planes        planes = getBoxPlanes(4096.0f);
+        const ChunkLocation chunk  = getLocation(-64, 0, 0, 1);
+        const glm::vec3     min {chunk.root_position};
+        const glm::vec3     max = min + 128.0f;
+
+        for (u32 iteration = 0; iteration < 8192; ++iteration)
+        {
+            const glm::vec3 camera {
+                static_cast<f32>(halfUnits(generator)) * 0.5f,
+                static_cast<f32>(halfUnits(generator)) * 0.5f,
+                static_cast<f32>(halfUnits(generator)) * 0.5f};
+
+            const u8 actual   = cullOne(planes, camera, chunk);
+            const u8 expected = referenceDirections(camera, min, max);
+
+            util::assertFatal(
+                (actual & AllDirections) == expected,
+                "Directions from {} {} {} differ from the reference | {} {}",
+                camera.x,
+                camera.y,
+                camera.z,
+                actual,
+                expected);
+        }
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"inside, outside and straddling", checkInsideOutsideAndStraddling},
+        {"touching planes", checkTouchingPlanes},
+        {"conservative at frustum corners", checkConservativeAtFrustumCorners},
+        {"against a per corner reference", checkAgainstReference},
+        {"chunks without draw ranges", checkChunksWithoutDrawRanges},
+        {"parallel matches serial", checkParallelMatchesSerial},
+        {"camera inside and on the chunk", checkCameraInsideAndOnTheBox},
+        {"camera between chunks", checkCameraBetweenChunks},
+        {"directions against a per face reference", checkDirectionsAgainstReference},
+    });
+}
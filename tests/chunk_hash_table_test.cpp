@@ -0,0 +1,353 @@
+#include "shaders/include/common.glsl"
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/chunk_hash_table.hpp"
+#include "voxel/structures.hpp"
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    using voxel::ChunkHashTable;
+    using voxel::ChunkLocation;
+
+    ChunkLocation getLocation(i32 x, i32 y, i32 z, u32 lod)
+    {
+        return ChunkLocation {glm::ivec3 {x, y, z}, lod};
+    }
+
+    u32 getSlotDistance(u32 from, u32 to)
+    {
+        return (to - from) & (GpuChunkHashTableCapacity - 1);
+    }
+
+    /// Every entry is where its probe length says and in Robin Hood order, so that lookups
+    /// stopping early can't miss it, and the table holds exactly the reference's entries
+    void checkInvariants(
+        const ChunkHashTable& table, const std::unordered_map<ChunkLocation, u32>& reference)
+    {
+        const std::span<const Gpu_ChunkLocation> keys            = table.getKeys();
+        const std::span<const u32>               values          = table.getValues();
+        std::size_t                              numberOfEntries = 0;
+
+        for (u32 slot = 0; slot < GpuChunkHashTableCapacity; ++slot)
+        {
+            if (values[slot] == GpuChunkHashTableEmpty)
+            {
+                continue;
+            }
+
+            numberOfEntries += 1;
+
+            const u32 probeLength = gpu_unpackChunkHashTableProbeLength(values[slot]);
+            const u32 nextValue   = values[gpu_chunkHashTableNextSlot(slot)];
+
+            util::assertFatal(
+                probeLength == getSlotDistance(gpu_chunkHashTableHomeSlot(keys[slot]), slot),
+                "Slot {} has probe length {} but isn't that far from home",
+                slot,
+                probeLength);
+            util::assertFatal(
+                probeLength < GpuChunkHashTableMaxProbeLength,
+                "Slot {} is past the max probe length",
+                slot);
+            util::assertFatal(
+                nextValue == GpuChunkHashTableEmpty
+                    || gpu_unpackChunkHashTableProbeLength(nextValue) <= probeLength + 1,
+                "Slot {} is followed by an entry that should have displaced it",
+                slot);
+
+            const ChunkLocation key {keys[slot]};
+            const auto          it = reference.find(key);
+
+            util::assertFatal(
+                it != reference.cend() && it->second == gpu_unpackChunkHashTableId(values[slot]),
+                "Slot {} holds an entry that isn't in the reference",
+                slot);
+        }
+
+        util::assertFatal(
+            numberOfEntries == reference.size(),
+            "Table holds {} entries, the reference {}",
+            numberOfEntries,
+            reference.size());
+    }
+
+    /// Locations whose home slots are all within [firstSlot, firstSlot + window)
+    std::vector<ChunkLocation>
+    findCollidingLocations(u32 firstSlot, u32 window, std::size_t numberOfLocations)
+    {
+        std::vector<ChunkLocation> locations {};
+
+        for (i32 i = 0; locations.size() < numberOfLocations; ++i)
+        {
+            const ChunkLocation location =
+                getLocation((i % 1024) * 64, ((i / 1024) % 1024) * 64, (i / (1024 * 1024)) * 64, 0);
+
+            if (getSlotDistance(firstSlot, gpu_chunkHashTableHomeSlot(location)) < window)
+            {
+                locations.push_back(location);
+            }
+        }
+
+        return locations;
+    }
+
+    void checkInsertFindErase()
+    {
+        ChunkHashTable table {};
+
+        const ChunkLocation a = getLocation(0, 0, 0, 0);
+        const ChunkLocation b = getLocation(64, 0, 0, 0);
+        const ChunkLocation c = getLocation(0, 0, 0, 1);
+
+        util::assertFatal(table.find(a) == GpuChunkHashTableEmpty, "An empty table found a");
+
+        util::assertFatal(table.insert(a, 1) && table.insert(b, 2), "Inserts were refused");
+        util::assertFatal(
+            table.find(a) == 1 && table.find(b) == 2, "Inserted chunks weren't found");
+        util::assertFatal(table.find(c) == GpuChunkHashTableEmpty, "Lods aren't told apart");
+
+        // Replacing a location keeps a single entry
+        util::assertFatal(table.insert(a, 3), "Replacing a was refused");
+        util::assertFatal(table.find(a) == 3, "Replacing a didn't change its chunk");
+
+        // Erasing a chunk that has since been replaced leaves its replacement
+        table.erase(a, 1);
+        util::assertFatal(table.find(a) == 3, "Erasing a replaced chunk removed its replacement");
+
+        table.erase(a, 3);
+        util::assertFatal(table.find(a) == GpuChunkHashTableEmpty, "a wasn't erased");
+        util::assertFatal(table.find(b) == 2, "Erasing a removed b");
+
+        checkInvariants(table, {{b, 2}});
+    }
+
+    // Chains that wrap past the last slot and keep displacing each other, then erased in an
+    // order that shifts back through the middle of them
+    void checkCollidingChains()
+    {
+        ChunkHashTable                         table {};
+        std::unordered_map<ChunkLocation, u32> reference {};
+        const std::vector<ChunkLocation>       locations =
+            findCollidingLocations(GpuChunkHashTableCapacity - 4, 8, 48);
+
+        for (u32 i = 0; i < locations.size(); ++i)
+        {
+            util::assertFatal(table.insert(locations[i], i), "Insert {} was refused", i);
+            reference[locations[i]] = i;
+
+            checkInvariants(table, reference);
+        }
+
+        for (u32 i = 0; i < locations.size(); i += 3)
+        {
+            table.erase(locations[i], i);
+            reference.erase(locations[i]);
+
+            checkInvariants(table, reference);
+        }
+
+        for (u32 i = 0; i < locations.size(); ++i)
+        {
+            const u32 expected = i % 3 == 0 ? GpuChunkHashTableEmpty : i;
+
+            util::assertFatal(
+                table.find(locations[i]) == expected, "Location {} has the wrong chunk", i);
+        }
+    }
+
+    // Past the max probe length lookups would give up before reaching an entry, so the insert
+    // that would put one there has to be refused without changing anything
+    void checkRefusesLongProbes()
+    {
+        ChunkHashTable                         table {};
+        std::unordered_map<ChunkLocation, u32> reference {};
+        // Homed within 8 slots, so at most 64 of them fit before one would be 64 slots from home
+        const std::vector<ChunkLocation>       locations =
+            findCollidingLocations(1000, 8, GpuChunkHashTableMaxProbeLength + 8);
+
+        u32 numberOfInserted = 0;
+
+        while (numberOfInserted < locations.size()
+               && table.insert(locations[numberOfInserted], numberOfInserted))
+        {
+            reference[locations[numberOfInserted]] = numberOfInserted;
+            numberOfInserted += 1;
+        }
+
+        util::assertFatal(
+            numberOfInserted >= GpuChunkHashTableMaxProbeLength,
+            "Only {} inserts were accepted",
+            numberOfInserted);
+        util::assertFatal(
+            numberOfInserted < locations.size(), "No insert past the max probe length was refused");
+
+        checkInvariants(table, reference);
+
+        // Refusing must not leave anything behind to upload either
+        std::ignore = table.takeChangedSlots();
+
+        const ChunkLocation    refused = locations[numberOfInserted];
+        const std::vector<u32> valuesBefore {table.getValues().begin(), table.getValues().end()};
+
+        util::assertFatal(!table.insert(refused, 1234), "A refused insert was accepted later");
+        util::assertFatal(
+            std::ranges::equal(valuesBefore, table.getValues()),
+            "A refused insert changed the table");
+        util::assertFatal(
+            table.takeChangedSlots().empty(), "A refused insert marked slots as changed");
+        util::assertFatal(
+            table.find(refused) == GpuChunkHashTableEmpty, "A refused insert is found");
+
+        // Replacing never moves anything, so even the furthest entries can be replaced
+        for (u32 i = 0; i < numberOfInserted; ++i)
+        {
+            util::assertFatal(table.insert(locations[i], i + 1), "Replacing {} was refused", i);
+            reference[locations[i]] = i + 1;
+        }
+
+        checkInvariants(table, reference);
+
+        // Robin Hood probe lengths only depend on which keys are present, so after an erase the
+        // same key fits again
+        table.erase(locations[0], 1);
+        util::assertFatal(table.insert(locations[0], 1), "Reinserting an erased key was refused");
+
+        checkInvariants(table, reference);
+    }
+
+    // Random inserts, replacements and erases of a small set of locations, so that every kind of
+    // operation keeps running into entries from the others
+    void checkAgainstReference()
+    {
+        ChunkHashTable                         table {};
+        std::unordered_map<ChunkLocation, u32> reference {};
+
+        // Some collide around a single slot, which makes for long displacement chains
+        std::vector<ChunkLocation> locations = findCollidingLocations(77777, 16, 48);
+
+        for (i32 i = 0; i < 256; ++i)
+        {
+            locations.push_back(getLocation((i % 8) * 64, ((i / 8) % 8) * 64, (i / 64) * 64, 0));
+        }
+
+        std::mt19937                               generator {0x6c617665}; // NOLINT
+        std::uniform_int_distribution<std::size_t> locationDistribution {0, locations.size() - 1};
+        std::uniform_int_distribution<u32>         idDistribution {
+            0, (1U << GpuChunkHashTableIdBits) - 1};
+        std::uniform_int_distribution<u32>         operationDistribution {0, 2};
+
+        for (u32 iteration = 0; iteration < 200000; ++iteration)
+        {
+            const ChunkLocation location = locations[locationDistribution(generator)];
+            const auto          it       = reference.find(location);
+
+            switch (operationDistribution(generator))
+            {
+            case 0:
+            case 1: {
+                const u32 chunkId = idDistribution(generator);
+
+                util::assertFatal(table.insert(location, chunkId), "An insert was refused");
+                reference[location] = chunkId;
+                break;
+            }
+            default:
+                // Erasing a stale id must do nothing, so try both
+                if (it != reference.cend())
+                {
+                    const bool eraseStaleId = iteration % 4 == 0;
+
+                    table.erase(location, eraseStaleId ? it->second + 1 : it->second);
+
+                    if (!eraseStaleId)
+                    {
+                        reference.erase(it);
+                    }
+                }
+                break;
+            }
+
+            if (iteration % 997 == 0)
+            {
+                for (const ChunkLocation& l : locations)
+                {
+                    const auto expected = reference.find(l);
+
+                    util::assertFatal(
+                        table.find(l)
+                            == (expected == reference.cend() ? GpuChunkHashTableEmpty
+                                                             : expected->second),
+                        "Lookup differs from the reference after {} operations",
+                        iteration);
+                }
+            }
+
+            if (iteration % 20011 == 0)
+            {
+                checkInvariants(table, reference);
+            }
+        }
+
+        checkInvariants(table, reference);
+    }
+
+    // Everything that differs between two snapshots has to have been reported as changed
+    void checkChangedSlots()
+    {
+        ChunkHashTable table {};
+
+        std::ignore = table.takeChangedSlots();
+
+        const std::vector<ChunkLocation> locations = findCollidingLocations(4242, 4, 32);
+
+        for (u32 i = 0; i < locations.size(); ++i)
+        {
+            util::assertFatal(table.insert(locations[i], i), "Insert {} was refused", i);
+        }
+
+        std::ignore = table.takeChangedSlots();
+
+        const std::vector<u32> valuesBefore {table.getValues().begin(), table.getValues().end()};
+        const std::vector<Gpu_ChunkLocation> keysBefore {
+            table.getKeys().begin(), table.getKeys().end()};
+
+        table.erase(locations[3], 3);
+        table.erase(locations[17], 17);
+        std::ignore = table.insert(getLocation(-64, -64, -64, 2), 99);
+        std::ignore = table.insert(locations[5], 1000);
+
+        std::vector<u32> changedSlots = table.takeChangedSlots();
+        std::ranges::sort(changedSlots);
+
+        for (u32 slot = 0; slot < GpuChunkHashTableCapacity; ++slot)
+        {
+            const bool valueChanged = valuesBefore[slot] != table.getValues()[slot];
+            const bool keyChanged =
+                table.getValues()[slot] != GpuChunkHashTableEmpty
+                && !gpu_isChunkLocationEqual(keysBefore[slot], table.getKeys()[slot]);
+
+            if (valueChanged || keyChanged)
+            {
+                util::assertFatal(
+                    std::ranges::binary_search(changedSlots, slot),
+                    "Slot {} changed without being reported",
+                    slot);
+            }
+        }
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"insert, find and erase", checkInsertFindErase},
+        {"colliding chains", checkCollidingChains},
+        {"refuses long probes", checkRefusesLongProbes},
+        {"against a reference map", checkAgainstReference},
+        {"changed slots", checkChangedSlots},
+    });
+}
@@ -0,0 +1,213 @@
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "util/recycling_pool.hpp"
+#include "voxel/chunk_mesher.hpp"
+#include "voxel/greedy_mesh_cache.hpp"
+#include "voxel/structures.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <vector>
+
+namespace
+{
+    // Only this thread's, the pool's workers and the logger may allocate whenever they like
+    thread_local std::size_t numberOfAllocations = 0; // NOLINT
+
+    void* countAndAllocate(std::size_t size, std::size_t alignment)
+    {
+        numberOfAllocations += 1;
+
+        // aligned_alloc wants a multiple of the alignment and malloc(0) may return null
+        const std::size_t roundedSize =
+            ((std::max(size, std::size_t {1}) + alignment - 1) / alignment) * alignment;
+        void* const allocation = alignment <= alignof(std::max_align_t)
+                                   ? std::malloc(roundedSize) // NOLINT
+                                   : std::aligned_alloc(alignment, roundedSize);
+
+        if (allocation == nullptr)
+        {
+            throw std::bad_alloc {};
+        }
+
+        return allocation;
+    }
+} // namespace
+
+void* operator new (std::size_t size)
+{
+    return countAndAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    return countAndAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete (void* allocation) noexcept
+{
+    std::free(allocation); // NOLINT
+}
+
+void operator delete (void* allocation, std::size_t) noexcept
+{
+    std::free(allocation); // NOLINT
+}
+
+void operator delete (void* allocation, std::align_val_t) noexcept
+{
+    std::free(allocation); // NOLINT
+}
+
+void operator delete (void* allocation, std::size_t, std::align_val_t) noexcept
+{
+    std::free(allocation); // NOLINT
+}
+
+namespace
+{
+    using voxel::ChunkAsyncMesh;
+    using voxel::ChunkLocalPosition;
+    using voxel::ChunkLocalUpdate;
+    using voxel::GreedyMeshCache;
+    using voxel::Voxel;
+
+    using MeshPool = util::RecyclingPool<ChunkAsyncMesh>;
+
+    constexpr u32         ChunkId                = 7;
+    // Clustering passes face storage along between the 6 directions and its scratch, so it takes
+    // 7 meshes for every vector to have been sized for every direction
+    constexpr std::size_t NumberOfWarmupMeshes   = 8;
+    constexpr std::size_t NumberOfMeasuredMeshes = 64;
+
+    /// A tunnel through the whole chunk and a block of another material inside of it, so that
+    /// there are faces inside of bricks, across brick boundaries and on the chunk's sides
+    std::vector<ChunkLocalUpdate> getCarvingUpdates(u8 tunnelY)
+    {
+        std::vector<ChunkLocalUpdate> updates {};
+
+        for (u8 x = 0; x < voxel::VoxelsPerChunkEdge; ++x)
+        {
+            for (u8 y = tunnelY; y < tunnelY + 6; ++y)
+            {
+                for (u8 z = 29; z < 35; ++z)
+                {
+                    updates.emplace_back(ChunkLocalPosition {x, y, z}, Voxel::NullAirEmpty);
+                }
+            }
+        }
+
+        for (u8 x = 10; x < 13; ++x)
+        {
+            for (u8 z = 30; z < 33; ++z)
+            {
+                updates.emplace_back(ChunkLocalPosition {x, tunnelY, z}, Voxel::Emerald);
+            }
+        }
+
+        return updates;
+    }
+
+    /// Meshes and releases the mesh again, like a worker's task followed by its integration
+    template<class Fn>
+    std::size_t countAllocationsOfMeshes(const MeshPool& meshPool, const Fn& mesh)
+    {
+        for (std::size_t i = 0; i < NumberOfWarmupMeshes; ++i)
+        {
+            meshPool.release(mesh());
+        }
+
+        const std::size_t allocationsBefore = numberOfAllocations;
+
+        for (std::size_t i = 0; i < NumberOfMeasuredMeshes; ++i)
+        {
+            meshPool.release(mesh());
+        }
+
+        return numberOfAllocations - allocationsBefore;
+    }
+
+    // Meshes that are already cached are copied into the recycled mesh's storage
+    void checkCachedMeshesDontAllocate()
+    {
+        const MeshPool                      meshPool {4};
+        const GreedyMeshCache               greedyMeshCache {std::size_t {64} << 20u};
+        const std::vector<ChunkLocalUpdate> updates = getCarvingUpdates(20);
+
+        const std::size_t allocations = countAllocationsOfMeshes(
+            meshPool,
+            [&]
+            {
+                return voxel::meshChunk(
+                    ChunkId,
+                    voxel::ChunkBrickMap {},
+                    {},
+                    Voxel::Ruby,
+                    updates,
+                    greedyMeshCache,
+                    meshPool);
+            });
+
+        util::assertFatal(
+            greedyMeshCache.getNumberOfHits() == NumberOfWarmupMeshes + NumberOfMeasuredMeshes - 1,
+            "Only the first mesh should miss the cache, {} hit",
+            greedyMeshCache.getNumberOfHits());
+        util::assertFatal(
+            allocations == 0,
+            "{} meshes of cached contents allocated {} times",
+            NumberOfMeasuredMeshes,
+            allocations);
+    }
+
+    // A cache that can't hold anything makes every mesh go through the mesher itself, which must
+    // only ever use the recycled and per thread storage. Also carries the previous mesh's bricks
+    // over, like every update after a chunk's first.
+    void checkUncachedMeshesDontAllocate()
+    {
+        const MeshPool                      meshPool {4};
+        const GreedyMeshCache               greedyMeshCache {0};
+        const std::vector<ChunkLocalUpdate> firstUpdates = getCarvingUpdates(20);
+        const std::vector<ChunkLocalUpdate> updates      = getCarvingUpdates(40);
+
+        const ChunkAsyncMesh previous = voxel::meshChunk(
+            ChunkId,
+            voxel::ChunkBrickMap {},
+            {},
+            Voxel::Ruby,
+            firstUpdates,
+            greedyMeshCache,
+            meshPool);
+
+        const std::size_t allocations = countAllocationsOfMeshes(
+            meshPool,
+            [&]
+            {
+                return voxel::meshChunk(
+                    ChunkId,
+                    previous.new_brick_map,
+                    previous.new_material_bricks,
+                    std::nullopt,
+                    updates,
+                    greedyMeshCache,
+                    meshPool);
+            });
+
+        util::assertFatal(
+            greedyMeshCache.getNumberOfHits() == 0, "A cache of 0 bytes had a mesh in it");
+        util::assertFatal(
+            allocations == 0,
+            "{} uncached meshes allocated {} times",
+            NumberOfMeasuredMeshes,
+            allocations);
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"cached meshes don't allocate", checkCachedMeshesDontAllocate},
+        {"uncached meshes don't allocate", checkUncachedMeshesDontAllocate},
+    });
+}
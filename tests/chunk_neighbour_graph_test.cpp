@@ -0,0 +1,433 @@
+#include "shaders/include/common.glsl"
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/chunk_hash_table.hpp"
+#include "voxel/chunk_neighbour_graph.hpp"
+#include "voxel/structures.hpp"
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using voxel::ChunkHashTable;
+    using voxel::ChunkLocation;
+    using voxel::ChunkNeighbourGraph;
+    using voxel::VoxelFaceDirection;
+
+    constexpr u8 AllFacesSealed = 0b11'1111;
+
+    i64 getWidth(u32 lod)
+    {
+        return static_cast<i64>(gpu_calculateChunkWidthUnits(lod));
+    }
+
+    ChunkLocation getLocation(i32 x, i32 y, i32 z, u32 lod)
+    {
+        return ChunkLocation {glm::ivec3 {x, y, z}, lod};
+    }
+
+    u8 getFaceBit(VoxelFaceDirection face)
+    {
+        return static_cast<u8>(1U << static_cast<u32>(face));
+    }
+
+    /// The graph along with the table it is built from, kept in sync the same way that
+    /// ChunkRenderManager does
+    struct World
+    {
+        ChunkHashTable      table;
+        ChunkNeighbourGraph graph;
+        u32                 next_chunk_id = 0;
+
+        u32 insert(ChunkLocation location)
+        {
+            const u32 chunkId = this->next_chunk_id++;
+
+            this->insert(chunkId, location);
+
+            return chunkId;
+        }
+
+        void insert(u32 chunkId, ChunkLocation location)
+        {
+            util::assertFatal(this->table.insert(location, chunkId), "Insert was refused");
+            this->graph.insert(chunkId, location, this->table);
+        }
+
+        void erase(u32 chunkId, ChunkLocation location)
+        {
+            this->table.erase(location, chunkId);
+            this->graph.erase(chunkId, this->table);
+        }
+    };
+
+    bool contains(ChunkLocation chunk, glm::ivec3 position)
+    {
+        const i64 width = getWidth(chunk.lod);
+
+        for (glm::length_t axis = 0; axis < 3; ++axis)
+        {
+            if (position[axis] < chunk.root_position[axis]
+                || position[axis] >= chunk.root_position[axis] + width)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /// Searches every live chunk for what the link in this direction should be
+    u32 findNeighbourBruteForce(
+        const std::map<u32, ChunkLocation>& live, u32 chunkId, glm::ivec3 direction)
+    {
+        const ChunkLocation location = live.at(chunkId);
+        const i64           width    = getWidth(location.lod);
+        glm::ivec3          probe {};
+
+        for (glm::length_t axis = 0; axis < 3; ++axis)
+        {
+            const i64 offset =
+                direction[axis] < 0 ? -1 : (direction[axis] == 0 ? width / 2 : width);
+
+            probe[axis] = static_cast<i32>(location.root_position[axis] + offset);
+        }
+
+        u32 best    = ChunkNeighbourGraph::NullChunk;
+        u32 bestLod = ~0U;
+
+        for (const auto& [otherId, other] : live)
+        {
+            const u32 lodDifference = other.lod > location.lod ? other.lod - location.lod
+                                                               : location.lod - other.lod;
+
+            if (otherId == chunkId || lodDifference > ChunkNeighbourGraph::MaxLinkedLodDifference
+                || !contains(other, probe) || contains(other, location.root_position))
+            {
+                continue;
+            }
+
+            if (other.lod < bestLod)
+            {
+                best    = otherId;
+                bestLod = other.lod;
+            }
+        }
+
+        return best;
+    }
+
+    void checkDirections()
+    {
+        for (u32 i = 0; i < ChunkNeighbourGraph::NumberOfDirections; ++i)
+        {
+            const glm::ivec3 direction = ChunkNeighbourGraph::getDirection(i);
+
+            bool isOffset = direction != glm::ivec3 {0};
+
+            for (glm::length_t axis = 0; axis < 3; ++axis)
+            {
+                isOffset &= direction[axis] >= -1 && direction[axis] <= 1;
+            }
+
+            util::assertFatal(isOffset, "Direction {} isn't a neighbour offset", i);
+            util::assertFatal(
+                ChunkNeighbourGraph::getDirectionIndex(direction) == i,
+                "Direction {} doesn't round trip",
+                i);
+        }
+    }
+
+    void checkSameLodGrid()
+    {
+        World              world {};
+        std::map<i32, u32> ids {};
+        const i32          width = static_cast<i32>(getWidth(0));
+
+        auto getKey = [](i32 x, i32 y, i32 z)
+        {
+            return x + (3 * y) + (9 * z);
+        };
+
+        for (i32 z = 0; z < 3; ++z)
+        {
+            for (i32 y = 0; y < 3; ++y)
+            {
+                for (i32 x = 0; x < 3; ++x)
+                {
+                    ids[getKey(x, y, z)] =
+                        world.insert(getLocation(x * width, y * width, z * width, 0));
+                }
+            }
+        }
+
+        const u32 center = ids.at(getKey(1, 1, 1));
+
+        for (u32 i = 0; i < ChunkNeighbourGraph::NumberOfDirections; ++i)
+        {
+            const glm::ivec3 d = ChunkNeighbourGraph::getDirection(i);
+
+            util::assertFatal(
+                world.graph.getNeighbour(center, d) == ids.at(getKey(1 + d.x, 1 + d.y, 1 + d.z)),
+                "Center isn't linked to its neighbour in direction {}",
+                i);
+        }
+
+        // A corner chunk only has neighbours towards the center
+        const u32 corner = ids.at(getKey(0, 0, 0));
+
+        util::assertFatal(
+            world.graph.getNeighbour(corner, {-1, 0, 0}) == ChunkNeighbourGraph::NullChunk,
+            "Corner is linked outward");
+        util::assertFatal(
+            world.graph.getNeighbour(corner, {1, 1, 1}) == center, "Corner isn't linked inward");
+
+        // Erasing relinks whoever pointed at it
+        world.erase(center, getLocation(width, width, width, 0));
+
+        util::assertFatal(
+            world.graph.getNeighbour(corner, {1, 1, 1}) == ChunkNeighbourGraph::NullChunk,
+            "Corner is still linked to an erased chunk");
+    }
+
+    void checkAcrossLods()
+    {
+        World     world {};
+        const i32 fine = static_cast<i32>(getWidth(0));
+
+        // A coarse chunk with fine ones along its -x side
+        const u32 coarseId   = world.insert(getLocation(0, 0, 0, 1));
+        const u32 lowFine    = world.insert(getLocation(-fine, 0, 0, 0));
+        const u32 midFine    = world.insert(getLocation(-fine, fine, fine, 0));
+        const u32 centerFine = world.insert(getLocation(-fine, 2 * fine, 2 * fine, 0));
+
+        util::assertFatal(
+            world.graph.getNeighbour(lowFine, {1, 0, 0}) == coarseId,
+            "Fine chunk isn't linked to the coarse one beside it");
+        util::assertFatal(
+            world.graph.getNeighbour(midFine, {1, 0, 0}) == coarseId,
+            "Other fine chunk isn't linked to the coarse one beside it");
+        // The probe from the coarse chunk lands in the middle of its face
+        util::assertFatal(
+            world.graph.getNeighbour(coarseId, {-1, 0, 0}) == midFine,
+            "Coarse chunk isn't linked to the fine chunk at the middle of its face");
+
+        // A coarser parent containing the coarse chunk mid transition is never a neighbour
+        const u32 parent = world.insert(getLocation(0, 0, 0, 2));
+
+        util::assertFatal(
+            world.graph.getNeighbour(coarseId, {1, 0, 0}) == ChunkNeighbourGraph::NullChunk,
+            "A chunk is linked to its parent");
+        util::assertFatal(
+            world.graph.getNeighbour(lowFine, {1, 0, 0}) == coarseId,
+            "Finer chunks aren't preferred over coarser ones");
+
+        // Once the finer chunk goes the coarser one behind it takes over
+        world.erase(coarseId, getLocation(0, 0, 0, 1));
+
+        util::assertFatal(
+            world.graph.getNeighbour(lowFine, {1, 0, 0}) == parent,
+            "Erasing the coarse chunk didn't relink to its parent");
+        util::assertFatal(
+            world.graph.getNeighbour(parent, {-1, 0, 0}) == centerFine,
+            "Parent isn't linked to the fine chunk at the middle of its face");
+    }
+
+    void checkLodDifferenceLimit()
+    {
+        World     world {};
+        const u32 lod   = ChunkNeighbourGraph::MaxLinkedLodDifference + 1;
+        const i32 width = static_cast<i32>(getWidth(lod));
+
+        // Each one's probe lands in the other, but they are too many lods apart
+        const u32 fine   = world.insert(getLocation(-static_cast<i32>(getWidth(0)), 0, 0, 0));
+        const u32 coarse = world.insert(getLocation(0, -width / 2, -width / 2, lod));
+
+        util::assertFatal(
+            world.graph.getNeighbour(fine, {1, 0, 0}) == ChunkNeighbourGraph::NullChunk
+                && world.graph.getNeighbour(coarse, {-1, 0, 0}) == ChunkNeighbourGraph::NullChunk,
+            "Chunks too many lods apart are linked");
+    }
+
+    // Random inserts and erases of chunks of 5 lods, overlapping like they do mid transition,
+    // compared with a search through every live chunk
+    void checkAgainstBruteForce()
+    {
+        World                        world {};
+        std::map<u32, ChunkLocation> live {};
+        std::vector<u32>             freeIds {};
+        std::mt19937                 generator {0x6c617665}; // NOLINT
+        // Far from 0 so that roots are negative and the offsets of each lod are exercised
+        const i32                    origin = -(1 << 20);
+
+        for (u32 iteration = 0; iteration < 20000; ++iteration)
+        {
+            if (live.size() < 300 || generator() % 2 == 0)
+            {
+                const u32 lod     = generator() % 5;
+                const i32 width   = static_cast<i32>(getWidth(lod));
+                const u32 perAxis = (1U << 12U) / static_cast<u32>(width);
+
+                auto getRoot = [&]
+                {
+                    return origin + (static_cast<i32>(generator() % perAxis) * width);
+                };
+
+                const ChunkLocation location = getLocation(getRoot(), getRoot(), getRoot(), lod);
+
+                if (world.table.find(location) != GpuChunkHashTableEmpty)
+                {
+                    continue;
+                }
+
+                u32 chunkId = world.next_chunk_id;
+
+                if (freeIds.empty())
+                {
+                    world.next_chunk_id += 1;
+                }
+                else
+                {
+                    chunkId = freeIds.back();
+                    freeIds.pop_back();
+                }
+
+                world.insert(chunkId, location);
+                live[chunkId] = location;
+            }
+            else
+            {
+                auto it = live.begin();
+                std::advance(it, static_cast<std::ptrdiff_t>(generator() % live.size()));
+
+                world.erase(it->first, it->second);
+                freeIds.push_back(it->first);
+                live.erase(it);
+            }
+
+            if (iteration % 500 != 0)
+            {
+                continue;
+            }
+
+            for (const auto& [chunkId, location] : live)
+            {
+                for (u32 i = 0; i < ChunkNeighbourGraph::NumberOfDirections; ++i)
+                {
+                    const glm::ivec3 direction = ChunkNeighbourGraph::getDirection(i);
+
+                    util::assertFatal(
+                        world.graph.getNeighbour(chunkId, direction)
+                            == findNeighbourBruteForce(live, chunkId, direction),
+                        "Link {} of chunk {} differs after {} operations",
+                        i,
+                        chunkId,
+                        iteration);
+                }
+            }
+        }
+    }
+
+    void checkEnclosure()
+    {
+        World     world {};
+        const i32 width = static_cast<i32>(getWidth(0));
+        const f32 half  = static_cast<f32>(width) / 2.0f;
+
+        const u32 center = world.insert(getLocation(0, 0, 0, 0));
+
+        for (u8 face = 0; face < 6; ++face)
+        {
+            const glm::ivec3 normal {
+                voxel::getDirFromDirection(static_cast<VoxelFaceDirection>(face))};
+            const glm::ivec3 root = normal * width;
+
+            world.graph.setSealedFaces(
+                world.insert(getLocation(root.x, root.y, root.z, 0)), AllFacesSealed);
+        }
+
+        const u32 back = world.graph.getNeighbour(center, {0, 0, 1});
+        const f32 far  = static_cast<f32>(width) * 10.0f;
+
+        util::assertFatal(
+            world.graph.isEnclosedFrom(center, {half, half, far}), "Not enclosed from the front");
+        util::assertFatal(
+            world.graph.isEnclosedFrom(center, {far, far, -far}), "Not enclosed from a corner");
+        util::assertFatal(
+            !world.graph.isEnclosedFrom(center, {half, half, half}), "Enclosed from inside");
+        // Within the sealed bricks, the near plane could cut through them
+        util::assertFatal(
+            !world.graph.isEnclosedFrom(center, {half, half, static_cast<f32>(width) + 1.0f}),
+            "Enclosed from just outside");
+
+        // Only the face that touches matters
+        world.graph.setSealedFaces(back, AllFacesSealed & ~getFaceBit(VoxelFaceDirection::Back));
+        util::assertFatal(
+            world.graph.isEnclosedFrom(center, {half, half, far}), "Far face of the neighbour");
+
+        world.graph.setSealedFaces(back, AllFacesSealed & ~getFaceBit(VoxelFaceDirection::Front));
+        util::assertFatal(
+            !world.graph.isEnclosedFrom(center, {half, half, far}), "Unsealed touching face");
+        util::assertFatal(
+            world.graph.isEnclosedFrom(center, {half, half, -far}), "Unseen face matters");
+
+        // A missing neighbour leaves a hole
+        world.erase(back, getLocation(0, 0, width, 0));
+        util::assertFatal(
+            !world.graph.isEnclosedFrom(center, {half, half, far}), "Missing neighbour");
+    }
+
+    void checkEnclosureAcrossLods()
+    {
+        const i32 fine = static_cast<i32>(getWidth(0));
+
+        // A coarser neighbour covers the whole face
+        {
+            World     world {};
+            const u32 chunkId = world.insert(getLocation(0, 0, 0, 0));
+
+            world.graph.setSealedFaces(
+                world.insert(getLocation(-fine, -fine, fine, 1)), AllFacesSealed);
+
+            util::assertFatal(
+                world.graph.isEnclosedFrom(chunkId, {8.0f, 8.0f, 1000.0f}),
+                "Coarser neighbour doesn't enclose");
+        }
+
+        // But only one of the finer neighbours is linked, which can't cover all of it
+        {
+            World     world {};
+            const u32 chunkId = world.insert(getLocation(0, 0, 0, 1));
+
+            for (i32 y = 0; y < 2; ++y)
+            {
+                for (i32 x = 0; x < 2; ++x)
+                {
+                    world.graph.setSealedFaces(
+                        world.insert(getLocation(x * fine, y * fine, 2 * fine, 0)),
+                        AllFacesSealed);
+                }
+            }
+
+            util::assertFatal(
+                !world.graph.isEnclosedFrom(chunkId, {8.0f, 8.0f, 1000.0f}),
+                "Finer neighbours enclose");
+        }
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"directions", checkDirections},
+        {"same lod grid", checkSameLodGrid},
+        {"across lods", checkAcrossLods},
+        {"lod difference limit", checkLodDifferenceLimit},
+        {"against brute force", checkAgainstBruteForce},
+        {"enclosure", checkEnclosure},
+        {"enclosure across lods", checkEnclosureAcrossLods},
+    });
+}
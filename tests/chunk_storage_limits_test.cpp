@@ -0,0 +1,180 @@
+#include "shaders/include/common.glsl"
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/chunk_storage_limits.hpp"
+#include "voxel/structures.hpp"
+#include <limits>
+
+namespace
+{
+    using voxel::ChunkStorageLimits;
+
+    constexpr u64 MiB = u64 {1} << 20u;
+    constexpr u64 GiB = u64 {1} << 30u;
+
+    // What most desktop gpus report, and the least that vulkan allows
+    constexpr u64 LargeStorageBufferRange    = std::numeric_limits<u32>::max();
+    constexpr u64 SmallestStorageBufferRange = u64 {1} << 27u;
+
+    u64 getChunkDataBytes(const ChunkStorageLimits& limits)
+    {
+        return u64 {limits.number_of_chunk_data_pages} * GpuChunksPerDataPage * voxel::VramPerChunk;
+    }
+
+    void checkNoBudgetStillFitsSomeChunks()
+    {
+        const ChunkStorageLimits limits =
+            voxel::calculateChunkStorageLimits(0, LargeStorageBufferRange);
+
+        util::assertFatal(
+            limits.number_of_chunk_data_pages == 1,
+            "No budget made {} pages",
+            limits.number_of_chunk_data_pages);
+        util::assertFatal(
+            limits.max_bricks >= voxel::BricksPerChunkEdge * voxel::BricksPerChunkEdge
+                                     * voxel::BricksPerChunkEdge,
+            "No budget can't hold a single chunk's {} bricks",
+            limits.max_bricks);
+        util::assertFatal(limits.max_faces > 0, "No budget made no room for faces");
+    }
+
+    void checkHugeBudgetIsBoundByTheShaders()
+    {
+        const ChunkStorageLimits limits =
+            voxel::calculateChunkStorageLimits(u64 {1} << 40u, LargeStorageBufferRange);
+
+        util::assertFatal(
+            limits.number_of_chunk_data_pages == GpuMaxChunkDataPages,
+            "{} pages instead of all {}",
+            limits.number_of_chunk_data_pages,
+            GpuMaxChunkDataPages);
+        util::assertFatal(
+            limits.max_bricks == (1U << GpuBrickPointerBits),
+            "{} bricks can't all be pointed to with {} bits",
+            limits.max_bricks,
+            GpuBrickPointerBits);
+        util::assertFatal(
+            u64 {limits.max_faces} * sizeof(voxel::GreedyVoxelFace) <= LargeStorageBufferRange,
+            "{} faces don't fit in one buffer",
+            limits.max_faces);
+    }
+
+    void checkSmallStorageBuffersAreRespected()
+    {
+        const ChunkStorageLimits limits =
+            voxel::calculateChunkStorageLimits(64 * GiB, SmallestStorageBufferRange);
+
+        util::assertFatal(
+            u64 {limits.max_bricks} * sizeof(voxel::MaterialBrick) <= SmallestStorageBufferRange,
+            "{} material bricks don't fit in a buffer of {} bytes",
+            limits.max_bricks,
+            SmallestStorageBufferRange);
+        util::assertFatal(
+            u64 {limits.max_faces} * sizeof(voxel::GreedyVoxelFace) <= SmallestStorageBufferRange,
+            "{} faces don't fit in a buffer of {} bytes",
+            limits.max_faces,
+            SmallestStorageBufferRange);
+    }
+
+    // From integrated gpus to the largest cards, each kind grows with the budget and stays within
+    // its share of it unless it is held at its minimum
+    void checkLimitsScaleWithinTheirShares()
+    {
+        ChunkStorageLimits previous =
+            voxel::calculateChunkStorageLimits(0, LargeStorageBufferRange);
+
+        for (u64 budget = 256 * MiB; budget <= 64 * GiB; budget *= 2)
+        {
+            const ChunkStorageLimits limits =
+                voxel::calculateChunkStorageLimits(budget, LargeStorageBufferRange);
+
+            util::assertFatal(
+                limits.number_of_chunk_data_pages >= previous.number_of_chunk_data_pages
+                    && limits.max_bricks >= previous.max_bricks
+                    && limits.max_faces >= previous.max_faces,
+                "A budget of {}MiB shrank the limits",
+                budget / MiB);
+            util::assertFatal(
+                limits.number_of_chunk_data_pages == 1 || getChunkDataBytes(limits) <= budget / 16,
+                "{} pages are over a sixteenth of {}MiB",
+                limits.number_of_chunk_data_pages,
+                budget / MiB);
+            util::assertFatal(
+                u64 {limits.max_bricks} * voxel::VramPerBrick <= budget / 4
+                    || limits.max_bricks == previous.max_bricks,
+                "{} bricks are over a quarter of {}MiB",
+                limits.max_bricks,
+                budget / MiB);
+            util::assertFatal(
+                u64 {limits.max_faces} * voxel::VramPerFace <= budget / 16
+                    || limits.max_faces == previous.max_faces,
+                "{} faces are over a sixteenth of {}MiB",
+                limits.max_faces,
+                budget / MiB);
+
+            previous = limits;
+        }
+
+        util::assertFatal(
+            previous.number_of_chunk_data_pages > 1,
+            "64GiB should fit more than one page of chunks");
+    }
+
+    // Chunk ids on either side of every page boundary, up to the last chunk of the largest
+    // configuration, survive everything they are packed into on the way to the shaders
+    void checkEveryPageOfChunkIdsRoundTrips()
+    {
+        const ChunkStorageLimits limits =
+            voxel::calculateChunkStorageLimits(u64 {1} << 40u, LargeStorageBufferRange);
+        const u32 maxChunks = limits.number_of_chunk_data_pages * GpuChunksPerDataPage;
+
+        for (u32 page = 0; page < limits.number_of_chunk_data_pages; ++page)
+        {
+            for (const u32 chunkId : {page * GpuChunksPerDataPage,
+                                      (page * GpuChunksPerDataPage) + GpuChunksPerDataPage - 1})
+            {
+                util::assertFatal(
+                    chunkId / GpuChunksPerDataPage == page && chunkId < maxChunks,
+                    "Chunk {} isn't in page {}",
+                    chunkId,
+                    page);
+
+                const u32 parentInformation = gpu_packBrickParentInformation(chunkId, 511);
+                util::assertFatal(
+                    gpu_unpackBrickParentChunk(parentInformation) == chunkId
+                        && gpu_unpackBrickPositionInParentChunk(parentInformation) == 511,
+                    "Chunk {}'s brick parent information didn't round trip",
+                    chunkId);
+
+                const u32 hashTableValue =
+                    gpu_packChunkHashTableValue(chunkId, GpuChunkHashTableMaxProbeLength);
+                util::assertFatal(
+                    gpu_unpackChunkHashTableId(hashTableValue) == chunkId
+                        && gpu_unpackChunkHashTableProbeLength(hashTableValue)
+                               == GpuChunkHashTableMaxProbeLength,
+                    "Chunk {}'s hash table value didn't round trip",
+                    chunkId);
+
+                const u32 draw = gpu_packVisibleChunkDraw(chunkId, 0, 5);
+                util::assertFatal(
+                    (draw & GpuVisibleChunkDrawExplicitBit) == 0
+                        && gpu_unpackVisibleChunkDrawChunkId(draw) == chunkId
+                        && gpu_unpackVisibleChunkDrawFirstDirection(draw) == 0
+                        && gpu_unpackVisibleChunkDrawLastDirection(draw) == 5,
+                    "Chunk {}'s visible draw didn't round trip",
+                    chunkId);
+            }
+        }
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"no budget still fits some chunks", checkNoBudgetStillFitsSomeChunks},
+        {"huge budget is bound by the shaders", checkHugeBudgetIsBoundByTheShaders},
+        {"small storage buffers are respected", checkSmallStorageBuffersAreRespected},
+        {"limits scale within their shares", checkLimitsScaleWithinTheirShares},
+        {"every page of chunk ids round trips", checkEveryPageOfChunkIdsRoundTrips},
+    });
+}
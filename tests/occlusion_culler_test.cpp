@@ -0,0 +1,153 @@
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "voxel/brick_kernels.hpp"
+#include "voxel/occlusion_culler.hpp"
+#include <algorithm>
+#include <array>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/mat4x4.hpp>
+#include <random>
+#include <vector>
+
+// The camera sits at the origin looking down -z. Every instruction set this cpu supports must
+// rasterize exactly the same pixels as the scalar kernels, so they must all agree on every box.
+
+namespace
+{
+    using namespace voxel::kernels;
+    using voxel::OcclusionCuller;
+
+    constexpr std::array<InstructionSet, 4> AllInstructionSets {
+        InstructionSet::Scalar, InstructionSet::Avx2, InstructionSet::Avx512, InstructionSet::Neon};
+
+    struct Box
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    glm::mat4 getViewProjection()
+    {
+        return glm::perspective(1.4f, 16.0f / 9.0f, 0.1f, 100000.0f)
+             * glm::lookAt(
+                   glm::vec3 {0.0f}, glm::vec3 {0.0f, 0.0f, -1.0f}, glm::vec3 {0.0f, 1.0f, 0.0f});
+    }
+
+    std::vector<Box> getRandomBoxes(u32 seed, std::size_t count, f32 minSize, f32 maxSize)
+    {
+        std::mt19937                         generator {seed};
+        std::uniform_real_distribution<f32> across {-60.0f, 60.0f};
+        std::uniform_real_distribution<f32> ahead {-200.0f, -5.0f};
+        std::uniform_real_distribution<f32> size {minSize, maxSize};
+
+        std::vector<Box> boxes {};
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const glm::vec3 min {across(generator), across(generator) / 2.0f, ahead(generator)};
+
+            boxes.push_back(
+                Box {min, min + glm::vec3 {size(generator), size(generator), size(generator)}});
+        }
+
+        return boxes;
+    }
+
+    void rasterize(OcclusionCuller& culler, const std::vector<Box>& occluders)
+    {
+        culler.clear(getViewProjection());
+
+        for (const Box& b : occluders)
+        {
+            culler.rasterizeOccluder(b.min, b.max);
+        }
+
+        culler.buildHierarchy();
+    }
+
+    std::vector<bool> queryEach(const OcclusionCuller& culler, const std::vector<Box>& queries)
+    {
+        std::vector<bool> occluded {};
+
+        for (const Box& b : queries)
+        {
+            occluded.push_back(culler.isOccluded(b.min, b.max));
+        }
+
+        return occluded;
+    }
+
+    void checkWallHidesWhatIsBehindIt()
+    {
+        OcclusionCuller culler {};
+
+        rasterize(
+            culler, {Box {glm::vec3 {-40.0f, -40.0f, -51.0f}, glm::vec3 {40.0f, 40.0f, -50.0f}}});
+
+        util::assertFatal(
+            culler.isOccluded(glm::vec3 {-2.0f, -2.0f, -80.0f}, glm::vec3 {2.0f, 2.0f, -76.0f}),
+            "A box behind the wall wasn't occluded");
+        util::assertFatal(
+            !culler.isOccluded(glm::vec3 {-2.0f, -2.0f, -30.0f}, glm::vec3 {2.0f, 2.0f, -26.0f}),
+            "A box in front of the wall was occluded");
+        util::assertFatal(
+            !culler.isOccluded(glm::vec3 {60.0f, -2.0f, -80.0f}, glm::vec3 {64.0f, 2.0f, -76.0f}),
+            "A box beside the wall was occluded");
+    }
+
+    void checkInstructionSetsAgree()
+    {
+        const std::vector<Box> occluders = getRandomBoxes(1, 256, 4.0f, 24.0f);
+        const std::vector<Box> queries   = getRandomBoxes(2, 4096, 0.5f, 8.0f);
+
+        const InstructionSet original = getInstructionSet();
+        OcclusionCuller      culler {};
+
+        setInstructionSet(InstructionSet::Scalar);
+        rasterize(culler, occluders);
+
+        const std::vector<bool> expected = queryEach(culler, queries);
+        const std::size_t       numberOccluded =
+            static_cast<std::size_t>(std::count(expected.cbegin(), expected.cend(), true));
+
+        util::assertFatal(
+            numberOccluded > 0 && numberOccluded < queries.size(),
+            "{} of {} boxes occluded, the scene checks nothing",
+            numberOccluded,
+            queries.size());
+
+        for (const InstructionSet i : AllInstructionSets)
+        {
+            if (!isInstructionSetSupported(i))
+            {
+                continue;
+            }
+
+            setInstructionSet(i);
+            rasterize(culler, occluders);
+
+            const std::vector<bool> occluded = queryEach(culler, queries);
+
+            for (std::size_t q = 0; q < queries.size(); ++q)
+            {
+                util::assertFatal(
+                    occluded[q] == expected[q],
+                    "{} said box {} is {}occluded, scalar disagrees",
+                    getInstructionSetName(i),
+                    q,
+                    occluded[q] ? "" : "not ");
+            }
+        }
+
+        setInstructionSet(original);
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"wall hides what is behind it", checkWallHidesWhatIsBehindIt},
+        {"instruction sets agree", checkInstructionSetsAgree},
+    });
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "util/log.hpp"
+#include "util/thread_pool.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <initializer_list>
+
+namespace test
+{
+    struct TestCase
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    /// Runs every case with the global logger and thread pool installed. Checks are made with
+    /// util::assertFatal, so a case fails by throwing.
+    inline int runTestCases(std::initializer_list<TestCase> testCases)
+    {
+        util::installGlobalLoggerRacy();
+        util::installGlobalThreadPoolRacy();
+
+        std::size_t numberOfFailures = 0;
+
+        for (const TestCase& t : testCases)
+        {
+            try
+            {
+                t.run();
+
+                util::logLog("{} passed", t.name);
+            }
+            catch (const std::exception& e)
+            {
+                util::logFatal("{} failed | {}", t.name, e.what());
+
+                numberOfFailures += 1;
+            }
+        }
+
+        util::removeGlobalThreadPoolRacy();
+        util::removeGlobalLoggerRacy();
+
+        return numberOfFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+} // namespace test
@@ -0,0 +1,210 @@
+#include "shaders/include/common.glsl"
+#include "test_harness.hpp"
+#include "util/log.hpp"
+#include "util/misc.hpp"
+#include "voxel/structures.hpp"
+#include "world/generator.hpp"
+#include <array>
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+
+namespace
+{
+    using voxel::ChunkLocation;
+    using world::ChunkContents;
+    using world::GeneratedChunk;
+    using world::WorldGenerator;
+
+    constexpr i32 FootprintsPerAxis = 3;
+    // Terrain is never more than about 1060 from 0
+    constexpr i32 LowestHeight      = -1280;
+    constexpr i32 HighestHeight     = 1280;
+    constexpr i32 VoxelsPerEdge     = 64;
+    constexpr u64 Seed              = 3849234;
+
+    i32 getChunkWidth(u32 lod)
+    {
+        return static_cast<i32>(gpu_calculateChunkWidthUnits(lod));
+    }
+
+    /// The chunk of this lod that contains the point
+    ChunkLocation getContainingChunk(glm::ivec3 position, u32 lod)
+    {
+        const i32 width = getChunkWidth(lod);
+
+        return ChunkLocation {
+            glm::ivec3 {
+                util::divideEuclidean(position.x, width) * width,
+                util::divideEuclidean(position.y, width) * width,
+                util::divideEuclidean(position.z, width) * width},
+            lod};
+    }
+
+    /// Solid voxels of the chunk that overlap the world space box [min, max)
+    std::size_t countSolidVoxels(
+        const GeneratedChunk& chunk, ChunkLocation location, glm::ivec3 min, glm::ivec3 max)
+    {
+        const i32 voxelSize = static_cast<i32>(gpu_calculateChunkVoxelSizeUnits(location.lod));
+        const glm::ivec3 root = location.root_position;
+        const glm::ivec3 localMin = glm::max(glm::ivec3 {0}, (min - root) / voxelSize);
+        const glm::ivec3 localMax =
+            glm::min(glm::ivec3 {VoxelsPerEdge}, ((max - root) + (voxelSize - 1)) / voxelSize);
+
+        const auto isInside = [&](glm::ivec3 p)
+        {
+            return p.x >= localMin.x && p.y >= localMin.y && p.z >= localMin.z
+                && p.x < localMax.x && p.y < localMax.y && p.z < localMax.z;
+        };
+
+        switch (chunk.contents)
+        {
+        case ChunkContents::Empty:
+            return 0;
+        case ChunkContents::Solid: {
+            const glm::ivec3 extent = localMax - localMin;
+
+            return static_cast<std::size_t>(extent.x) * static_cast<std::size_t>(extent.y)
+                 * static_cast<std::size_t>(extent.z);
+        }
+        case ChunkContents::Surface: {
+            std::size_t numberOfSolidVoxels = 0;
+
+            for (const voxel::ChunkLocalUpdate& u : chunk.updates)
+            {
+                const voxel::ChunkLocalPosition p = u.getPosition();
+
+                numberOfSolidVoxels += isInside(glm::ivec3 {p.x, p.y, p.z}) ? 1 : 0;
+            }
+
+            return numberOfSolidVoxels;
+        }
+        case ChunkContents::Buried:
+            break;
+        }
+
+        util::panic("Buried chunks have no voxels to count");
+    }
+
+    /// Every voxel of the neighbour of this lod that touches the face must be solid, so must
+    /// every voxel of the neighbour a lod coarser that touches it, as either may be meshed
+    /// beside a buried chunk
+    void checkFaceIsCovered(
+        const WorldGenerator& generator, ChunkLocation location, u32 axis, bool isPositive)
+    {
+        const i32        width = getChunkWidth(location.lod);
+        const glm::ivec3 root  = location.root_position;
+
+        // The one unit thick slab just outside the face
+        glm::ivec3 min = root;
+        glm::ivec3 max = root + width;
+        min[axis]      = isPositive ? root[axis] + width : root[axis] - 1;
+        max[axis]      = min[axis] + 1;
+
+        for (u32 lod : {location.lod, location.lod + 1})
+        {
+            const ChunkLocation  neighbour = getContainingChunk(min, lod);
+            const GeneratedChunk chunk     = generator.generateChunkVoxels(neighbour);
+
+            const i32        voxelSize = static_cast<i32>(gpu_calculateChunkVoxelSizeUnits(lod));
+            const glm::ivec3 extent    = glm::max((max - min) / voxelSize, glm::ivec3 {1});
+            const std::size_t numberOfTouchingVoxels = static_cast<std::size_t>(extent.x)
+                                                     * static_cast<std::size_t>(extent.y)
+                                                     * static_cast<std::size_t>(extent.z);
+
+            util::assertFatal(
+                countSolidVoxels(chunk, neighbour, min, max) == numberOfTouchingVoxels,
+                "Chunk at {} {} {} lod {} is buried but the lod {} neighbour across axis {} is "
+                "open",
+                location.root_position.x,
+                location.root_position.y,
+                location.root_position.z,
+                location.lod,
+                lod,
+                axis);
+        }
+    }
+
+    void checkClassification()
+    {
+        const WorldGenerator generator {Seed};
+
+        // Indexed by ChunkContents
+        std::array<std::size_t, 4> numberOfChunks {};
+        bool                       anyVoxelsSolid = false;
+
+        for (u32 lod : {0U, 1U})
+        {
+            const i32 width = getChunkWidth(lod);
+
+            for (i32 x = 0; x < FootprintsPerAxis; ++x)
+            {
+                for (i32 z = 0; z < FootprintsPerAxis; ++z)
+                {
+                    for (i32 y = LowestHeight; y < HighestHeight; y += width)
+                    {
+                        const ChunkLocation location {glm::ivec3 {x * width, y, z * width}, lod};
+
+                        const GeneratedChunk chunk  = generator.generateChunk(location);
+                        const GeneratedChunk voxels = generator.generateChunkVoxels(location);
+
+                        numberOfChunks[util::toUnderlying(chunk.contents)] += 1;
+                        anyVoxelsSolid |= voxels.contents == ChunkContents::Solid;
+
+                        util::assertFatal(
+                            voxels.contents != ChunkContents::Buried,
+                            "generateChunkVoxels elided a chunk as buried");
+
+                        switch (chunk.contents)
+                        {
+                        case ChunkContents::Empty:
+                            util::assertFatal(
+                                voxels.contents == ChunkContents::Empty,
+                                "Empty chunk has voxels");
+                            break;
+                        case ChunkContents::Solid:
+                            util::assertFatal(
+                                voxels.contents == ChunkContents::Solid,
+                                "Solid chunk is not solid");
+                            break;
+                        case ChunkContents::Surface:
+                            util::assertFatal(
+                                !chunk.updates.empty(), "Surface chunk has no voxels");
+                            break;
+                        case ChunkContents::Buried:
+                            util::assertFatal(
+                                countSolidVoxels(
+                                    voxels,
+                                    location,
+                                    location.root_position,
+                                    location.root_position + width)
+                                    == static_cast<std::size_t>(
+                                        VoxelsPerEdge * VoxelsPerEdge * VoxelsPerEdge),
+                                "Buried chunk is not solid");
+
+                            for (u32 axis = 0; axis < 3; ++axis)
+                            {
+                                checkFaceIsCovered(generator, location, axis, false);
+                                checkFaceIsCovered(generator, location, axis, true);
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        util::assertFatal(
+            numberOfChunks[util::toUnderlying(ChunkContents::Empty)] > 0
+                && numberOfChunks[util::toUnderlying(ChunkContents::Buried)] > 0
+                && numberOfChunks[util::toUnderlying(ChunkContents::Surface)] > 0,
+            "Sweep did not reach empty, buried and surface chunks");
+        util::assertFatal(anyVoxelsSolid, "Sweep did not reach a solid chunk");
+    }
+} // namespace
+
+int main()
+{
+    return test::runTestCases({
+        {"empty, buried, solid and surface", checkClassification},
+    });
+}